@@ -1,5 +1,10 @@
 #include "audio.h"
 #include "mp3.h"
+#include "event_queue.h"
+#include "audio_rtos.h"
+#include "scheduler.h"
+#include "i2s_port.h"
+#include "log.h"
 
 uint8_t SongNumber = 0;
 char    SongName[20][25];
@@ -12,23 +17,131 @@ uint8_t AUDIO_Extension = 0;
 extern uint32_t WAV_PlaybackTotal;
 extern uint32_t WAV_PlaybackProgress;
 
+static EVENT_Queue_Type AUDIO_Events;
+static volatile uint8_t AUDIO_RefillQueued; /* a WavRefill is queued, the next halves need not add one. */
+static volatile uint8_t AUDIO_WavEnded;     /* latched, not queued: no interrupt follows to post it again. */
+static uint32_t         AUDIO_I2S_Rate;     /* rate I2S runs at, 0 before the first stream. */
+#if AUDIO_RESAMPLE
+static RESAMPLE_Type    AUDIO_Resampler;
+#endif
+
 FRESULT Audio_ScanFiles(char *path);
 
 
 void AUDIO_Init(void)
 {
-    Audio_ScanFiles("1:/Music");
+    static char Path[100];
+
+    /* Audio_ScanFiles() appends sub-directory names in place. */
+    strcpy(Path, AUDIO_MUSIC_PATH);
+    Audio_ScanFiles(Path);
+
+    LOG_I("\r\nSong Number : %d\r\n", SongNumber);
+
+}
+
+/*
+ * Interrupt side: only records the event, the file is read by AUDIO_ProcessEvents().
+ * One queued refill tops up every free slot, so later halves do not queue more.
+ * The end of stream cannot be dropped with the queue full, it is a flag.
+ */
+void AUDIO_PostEvent(AUDIO_Event_Type Event)
+{
+    if(Event == AUDIO_Event_WavFinished)
+    {
+        AUDIO_WavEnded = 1u;
+    }
+    else if(Event == AUDIO_Event_WavRefill)
+    {
+        if((AUDIO_RefillQueued == 0u) && EVENT_Queue_Put(&AUDIO_Events, (uint8_t)Event))
+        {
+            AUDIO_RefillQueued = 1u;
+        }
+    }
+    else
+    {
+        EVENT_Queue_Put(&AUDIO_Events, (uint8_t)Event);
+    }
+
+#ifdef APP_FREERTOS
+    AUDIO_RTOS_WakeOutputFromISR();
+#else
+    Scheduler_Trigger(SCHED_EVENT_AUDIO);
+#endif
+}
+
+/*
+ * Sets up I2S for one stream: at the divider rate nearest to SampleRate, or to
+ * AUDIO_OUTPUT_RATE if set, left running when that is the rate already set.
+ * A stream further than I2S_CLOCK_PPM_WARN from the rate played goes through
+ * the returned resampler, NULL plays it as it is.
+ */
+RESAMPLE_Type *AUDIO_SetSampleRate(uint32_t SampleRate)
+{
+    I2S_Clock_Plan_Type Plan;
+    int32_t Ppm;
+
+    I2S_ClockPlan((AUDIO_OUTPUT_RATE != 0u) ? AUDIO_OUTPUT_RATE : SampleRate, &Plan);
+
+    if(Plan.Actual != AUDIO_I2S_Rate)
+    {
+        I2S_Configure(I2S_Protocol_PHILIPS, I2S_DataWidth_16b, Plan.Requested, I2S_XferMode_TxOnly);
+        AUDIO_I2S_Rate = Plan.Actual;
+    }
+
+    Ppm = (SampleRate != 0u) ? (int32_t)(((int64_t)Plan.Actual - SampleRate) * 1000000 / SampleRate) : 0;
+
+    if((Ppm <= I2S_CLOCK_PPM_WARN) && (Ppm >= -I2S_CLOCK_PPM_WARN))
+    {
+        LOG_I("\r\nI2S plays %lu Hz for %lu Hz (%ld ppm)\r\n",
+              (unsigned long)Plan.Actual, (unsigned long)SampleRate, (long)Ppm);
+        return NULL;
+    }
+
+#if AUDIO_RESAMPLE
+    RESAMPLE_Init(&AUDIO_Resampler, SampleRate, Plan.Actual);
+    LOG_I("\r\nI2S plays %lu Hz, resampled from %lu Hz\r\n",
+          (unsigned long)Plan.Actual, (unsigned long)SampleRate);
+    return &AUDIO_Resampler;
+#else
+    LOG_W("\r\nI2S plays %lu Hz for %lu Hz (%ld ppm), off pitch\r\n",
+          (unsigned long)Plan.Actual, (unsigned long)SampleRate, (long)Ppm);
+    return NULL;
+#endif
+}
+
+/* Main loop side: does the work the interrupts have queued, oldest first. */
+void AUDIO_ProcessEvents(void)
+{
+    uint8_t Event;
 
-    printf("\r\nSong Number : %d\r\n", SongNumber);
+    while(EVENT_Queue_Get(&AUDIO_Events, &Event))
+    {
+        switch(Event)
+        {
+            case AUDIO_Event_WavRefill:
+                /* cleared first, a half handed back while refilling queues the next one. */
+                AUDIO_RefillQueued = 0u;
+                WAV_PrepareData();
+                break;
 
+            default:
+                break;
+        }
+    }
+
+    /* after the refills queued before it, the ring has played out. */
+    if(AUDIO_WavEnded == 1u)
+    {
+        AUDIO_WavEnded = 0u;
+        WAV_PlayHandler();
+    }
 }
 
 void Audio_Task(void)
 {
 	  static uint8_t  AUDIO_Switching = 0;
     static uint32_t AUDIO_PlayTime  = 0;
-		
-		static char Buffer[100];
 	
     if(AUDIO_StartPlay == 1)//Only one
     {
@@ -36,16 +149,16 @@ void Audio_Task(void)
 
         if((AUDIO_PlayState == 0) && (SongNumber != 0))
         {
-            printf("\r\n\r\n%s\r\n", __FUNCTION__);
+            LOG_D("\r\n\r\n%s\r\n", __FUNCTION__);
 						
             if((strstr(SongName[AUDIO_PlayIndex], "wav") != NULL) || (strstr(SongName[AUDIO_PlayIndex], "WAV") != NULL))
             {
                 AUDIO_Extension = 0;//WAV
                 AUDIO_Switching = 1;
 							
-								printf("Start Play : %s  FileType: WAV\r\n",SongName[AUDIO_PlayIndex]);
+								LOG_I("Start Play : %s  FileType: WAV\r\n",SongName[AUDIO_PlayIndex]);
 
-                WAV_PlaySong("1:/Music/", SongName[AUDIO_PlayIndex]);
+                WAV_PlaySong(AUDIO_MUSIC_PATH "/", SongName[AUDIO_PlayIndex]);
             }
             else if((strstr(SongName[AUDIO_PlayIndex], "mp3") != NULL) || (strstr(SongName[AUDIO_PlayIndex], "MP3") != NULL))
             {
@@ -53,34 +166,31 @@ void Audio_Task(void)
                 AUDIO_Switching = 1;
                 AUDIO_PlayTime  = 0;
 
-								printf("Start Play : %s  FileType: MP3\r\n",SongName[AUDIO_PlayIndex]);
+								LOG_I("Start Play : %s  FileType: MP3\r\n",SongName[AUDIO_PlayIndex]);
 							
-								MP3_libmad_PlaySong("1:/Music/", SongName[AUDIO_PlayIndex]);
+								MP3_PlaySong(AUDIO_MUSIC_PATH "/", SongName[AUDIO_PlayIndex]);
             }
             else
             {
-                printf("\r\nUnknow Audio File!!!\r\n");
+                LOG_W("\r\nUnknow Audio File!!!\r\n");
             }
         }
     }
 		
     if(AUDIO_PlayState == 1)
     {
-        memset(Buffer, 0, sizeof(Buffer));
-
         if(AUDIO_Extension == 0)
         {
 						float res_Back=0;
 						//res_Back = ((WAV_PlaybackProgress) / (WAV_PlaybackTotal)) * 100.0f;
 						//res_Back = ((float)(WAV_PlaybackProgress) / (float)(WAV_PlaybackTotal));
 						//sprintf(Buffer, "%.1f", res_Back);
-					printf(">WAV_PlaybackProgress:%d,WAV_PlaybackTotal:%d\r\n",WAV_PlaybackProgress,WAV_PlaybackTotal);
+					LOG_I(">WAV_PlaybackProgress:%d,WAV_PlaybackTotal:%d\r\n",WAV_PlaybackProgress,WAV_PlaybackTotal);
         }
         else
         {
             AUDIO_PlayTime++;
-            sprintf(Buffer, "%02d:%02d", ((AUDIO_PlayTime/2)/60), ((AUDIO_PlayTime/2)%60));
-						printf(">AUDIO_PlayTime:%s\r\n",Buffer);
+						LOG_I(">AUDIO_PlayTime:%02d:%02d\r\n", ((AUDIO_PlayTime/2)/60), ((AUDIO_PlayTime/2)%60));
         }
     }
     else
@@ -91,11 +201,13 @@ void Audio_Task(void)
 
             for(uint8_t i = 0; i < SongNumber; i++)//printf Song Name
             {
-                memset(Buffer, 0, sizeof(Buffer));
-                sprintf(Buffer, "%02d.%s", i, SongName[i]);
-
-								printf(">SongName:%s\r\n",Buffer);
+								LOG_I(">SongName:%02d.%s\r\n", i, SongName[i]);
             }
+
+#ifdef LOG_TRACE
+            /* between songs, the records of the last one go out for log_decode.py. */
+            LOG_Trace_Dump();
+#endif
         }
     }
 
@@ -113,33 +225,31 @@ FRESULT Audio_ScanFiles(char *path)
     static UINT    i;
 		static FILINFO fno;
 		
-    char   Buffer[30];
-		
-		printf(">f_opendir() Start...\r\n");
+		LOG_D(">f_opendir() Start...\r\n");
     res = f_opendir(&dir, path);                        /* Open the directory */
 		
     if(res == FR_OK)
     {
-				printf(">Path :%s f_opendir() Done!\r\n",path);
+				LOG_D(">Path :%s f_opendir() Done!\r\n",path);
         while(1)
         {
-						printf(">--Read a directory--item f_readdir() Start...\r\n");
+						LOG_D(">--Read a directory--item f_readdir() Start...\r\n");
             res = f_readdir(&dir, &fno);                /* Read a directory item */
 
             if((res != FR_OK) || (fno.fname[0] == 0))   /* Break on error or end of dir */
             {
-								printf(">Break on error or end of dir res=%d\r\n",res);
+								LOG_D(">Break on error or end of dir res=%d\r\n",res);
                 break;
             }
-						printf(">--Read a directory--item f_readdir() Done!\r\n");
+						LOG_D(">--Read a directory--item f_readdir() Done!\r\n");
 						
             if(fno.fattrib & AM_DIR)                    /* It is a directory */
             {
                 i = strlen(path);
 
                 sprintf(&path[i], "/%s", fno.fname);
-								printf(">It is a directory!\r\n");
-								printf(">Enter the directory...\r\n");
+								LOG_D(">It is a directory!\r\n");
+								LOG_D(">Enter the directory...\r\n");
                 res = Audio_ScanFiles(path);            /* Enter the directory */
                 if (res != FR_OK)break;
                 path[i] = 0;
@@ -147,14 +257,11 @@ FRESULT Audio_ScanFiles(char *path)
             else
             {
 							/* It is a file. */
-								printf(">It is a file.\r\n");
+								LOG_D(">It is a file.\r\n");
                 if(SongNumber < 20)
                 {
-                    memset(Buffer, 0, sizeof(Buffer));
-                    sprintf(Buffer, "%02d.%s", SongNumber, fno.fname);
-										
-										printf("%s\r\n",Buffer);
-										printf("Name:%s\r\n",fno.fname);
+										LOG_D("%02d.%s\r\n", SongNumber, fno.fname);
+										LOG_D("Name:%s\r\n",fno.fname);
                     memset(SongName[SongNumber], 0, sizeof(SongName[SongNumber]));
                     strcpy(SongName[SongNumber], fno.fname);
 									
@@ -165,7 +272,7 @@ FRESULT Audio_ScanFiles(char *path)
 
         f_closedir(&dir);
     }else{
-				printf(">f_opendir() Fail! res =%d\r\n",res);
+				LOG_E(">f_opendir() Fail! res =%d\r\n",res);
 		}
 
     return res;
@@ -1,8 +1,38 @@
 #ifndef __AUDIO_H_
 #define __AUDIO_H_
 #include "hal_common.h"
+#include "resample.h"
+
+/* Folder scanned for songs; the host build points this at its RAM disk (0:). */
+#ifndef AUDIO_MUSIC_PATH
+#define AUDIO_MUSIC_PATH    "1:/Music"
+#endif
+
+/*
+ * Output rate. 0 plays every stream at the I2S rate nearest to its own, a
+ * fixed rate keeps I2S running unchanged from song to song. Either way a
+ * stream that ends up off pitch is resampled, unless AUDIO_RESAMPLE is 0.
+ * 46875 Hz is exact from the 60 MHz APB1 clock.
+ */
+#ifndef AUDIO_OUTPUT_RATE
+#define AUDIO_OUTPUT_RATE   0u
+#endif
+
+#ifndef AUDIO_RESAMPLE
+#define AUDIO_RESAMPLE      1
+#endif
+
+/* Work the output dma interrupt hands to thread level, see AUDIO_ProcessEvents(). */
+typedef enum
+{
+    AUDIO_Event_WavRefill = 0u,     /* the dma has moved on, a half of the ring is free. */
+    AUDIO_Event_WavFinished,        /* the ring has played out after the last slot, latched rather than queued. */
+} AUDIO_Event_Type;
 
 extern void Audio_Task(void);
 extern void AUDIO_Init(void);
+extern void AUDIO_PostEvent(AUDIO_Event_Type Event);
+extern void AUDIO_ProcessEvents(void);
+extern RESAMPLE_Type *AUDIO_SetSampleRate(uint32_t SampleRate);
 
 #endif
@@ -0,0 +1,327 @@
+/* Includes ------------------------------------------------------------------*/
+#include "audio_file.h"
+#include "diskio.h"
+#ifdef APP_FREERTOS
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+#include "stream_buffer.h"
+#endif
+
+#define AUDIO_FILE_SECTOR       FF_MIN_SS
+
+#ifdef APP_FREERTOS
+#define AUDIO_FILE_NOTIFY_INDEX 1u          /* AUDIO_File_Start/Stop() wake the reader. */
+#define AUDIO_FILE_POLL_MS      10u         /* how often a blocked transfer checks for stop or end of file. */
+
+typedef struct
+{
+    AUDIO_File_Type * volatile File;        /* the file read ahead, NULL while the reader is free. */
+    volatile uint8_t     Stop;              /* the owner wants the file back. */
+    volatile uint8_t     EndOfFile;         /* the rest of the file, or the error, is in the stream. */
+    volatile FRESULT     Result;
+    TaskHandle_t         Task;
+    StreamBufferHandle_t Stream;
+    SemaphoreHandle_t    Released;          /* given when the reader has let go of File. */
+} AUDIO_File_Reader_Type;
+
+static AUDIO_File_Reader_Type AUDIO_File_Reader;
+static uint8_t                AUDIO_File_Chunk[AUDIO_FILE_CHUNK_SIZE];
+
+static FRESULT AUDIO_File_ReadDirect(AUDIO_File_Type *File, void *Buffer, UINT Length, UINT *Read);
+static void    AUDIO_File_Start(AUDIO_File_Type *File);
+static void    AUDIO_File_Stop(AUDIO_File_Type *File);
+#endif
+
+
+/*******************************************************************************
+ * @brief       Opens a file for reading and maps its clusters.
+ * @param       File : not open.
+ *              Path : full path, with the drive.
+ * @retval      FR_OK or the f_open() error.
+ * @attention   A file with more fragments than AUDIO_FILE_CLMT_SIZE allows is
+ *              read the plain FatFs way. With the scheduler running the file
+ *              goes to the reader task, when that is free.
+*******************************************************************************/
+FRESULT AUDIO_File_Open(AUDIO_File_Type *File, const char *Path)
+{
+    FRESULT Result;
+    FATFS  *Fs;
+
+    File->Sector = 0;
+
+    Result = f_open(&File->File, Path, FA_READ);
+    if(Result != FR_OK)
+    {
+        return Result;
+    }
+
+#if FF_USE_FASTSEEK
+    File->Clmt[0]    = AUDIO_FILE_CLMT_SIZE;
+    File->File.cltbl = File->Clmt;
+
+    if(f_lseek(&File->File, CREATE_LINKMAP) != FR_OK)
+    {
+        File->File.cltbl = NULL;
+    }
+    else if(File->Clmt[0] == 4)
+    {
+        /* size, one fragment (length, first cluster), terminator. */
+        Fs = File->File.obj.fs;
+        File->Sector = Fs->database + (LBA_t)Fs->csize * (File->Clmt[2] - 2);
+    }
+#else
+    (void)Fs;
+#endif
+
+#ifdef APP_FREERTOS
+    File->ReadAhead = 0;
+    AUDIO_File_Start(File);
+#endif
+
+    return FR_OK;
+}
+
+
+/*******************************************************************************
+ * @brief       f_read() for files opened with AUDIO_File_Open().
+ * @param
+ * @retval      FR_OK or the FatFs error, *Read as f_read() sets it.
+ * @attention   After the raw sectors the file pointer is moved on with f_lseek(),
+ *              which the link map makes a lookup with no disk access.
+*******************************************************************************/
+#ifdef APP_FREERTOS
+static FRESULT AUDIO_File_ReadDirect(AUDIO_File_Type *File, void *Buffer, UINT Length, UINT *Read)
+#else
+FRESULT AUDIO_File_Read(AUDIO_File_Type *File, void *Buffer, UINT Length, UINT *Read)
+#endif
+{
+    FIL     *Fp   = &File->File;
+    uint8_t *Data = (uint8_t *)Buffer;
+    FRESULT  Result;
+    UINT     Count, Done;
+    FSIZE_t  Sectors;
+
+    *Read = 0;
+
+    if(File->Sector != 0)
+    {
+        /* up to the next sector boundary through the FatFs sector buffer. */
+        Count = (UINT)((AUDIO_FILE_SECTOR - (f_tell(Fp) % AUDIO_FILE_SECTOR)) % AUDIO_FILE_SECTOR);
+        if(Count > Length)
+        {
+            Count = Length;
+        }
+        if(Count != 0)
+        {
+            Result = f_read(Fp, Data, Count, &Done);
+            *Read += Done;
+            if((Result != FR_OK) || (Done < Count))
+            {
+                return Result;
+            }
+        }
+
+        /* whole sectors, as far as the file has them. */
+        Sectors = (Length - *Read) / AUDIO_FILE_SECTOR;
+        if(Sectors > (f_size(Fp) - f_tell(Fp)) / AUDIO_FILE_SECTOR)
+        {
+            Sectors = (f_size(Fp) - f_tell(Fp)) / AUDIO_FILE_SECTOR;
+        }
+        if(Sectors != 0)
+        {
+            if(disk_read(Fp->obj.fs->pdrv, Data + *Read, File->Sector + f_tell(Fp) / AUDIO_FILE_SECTOR, (UINT)Sectors) != RES_OK)
+            {
+                return FR_DISK_ERR;
+            }
+            *Read += (UINT)Sectors * AUDIO_FILE_SECTOR;
+
+            Result = f_lseek(Fp, f_tell(Fp) + Sectors * AUDIO_FILE_SECTOR);
+            if(Result != FR_OK)
+            {
+                return Result;
+            }
+        }
+    }
+
+    if(*Read < Length)
+    {
+        Result = f_read(Fp, Data + *Read, Length - *Read, &Done);
+        *Read += Done;
+        return Result;
+    }
+
+    return FR_OK;
+}
+
+
+FRESULT AUDIO_File_Seek(AUDIO_File_Type *File, FSIZE_t Offset)
+{
+#ifdef APP_FREERTOS
+    FRESULT Result;
+
+    /* the reader has run ahead of the caller, drop what it has read. */
+    if(File->ReadAhead == 1)
+    {
+        AUDIO_File_Stop(File);
+        Result = f_lseek(&File->File, Offset);
+        AUDIO_File_Start(File);
+        return Result;
+    }
+#endif
+    return f_lseek(&File->File, Offset);
+}
+
+
+FRESULT AUDIO_File_Close(AUDIO_File_Type *File)
+{
+#ifdef APP_FREERTOS
+    if(File->ReadAhead == 1)
+    {
+        AUDIO_File_Stop(File);
+    }
+#endif
+    File->Sector = 0;
+    return f_close(&File->File);
+}
+
+
+#ifdef APP_FREERTOS
+/*******************************************************************************
+ * @brief       Creates the read-ahead stream, before the reader task starts.
+ * @param       None
+ * @retval      None
+ * @attention   Files opened before the scheduler runs are read in place.
+*******************************************************************************/
+void AUDIO_File_ReaderInit(void)
+{
+    AUDIO_File_Reader.Stream   = xStreamBufferCreate(AUDIO_FILE_STREAM_SIZE, 1);
+    AUDIO_File_Reader.Released = xSemaphoreCreateBinary();
+    configASSERT((AUDIO_File_Reader.Stream != NULL) && (AUDIO_File_Reader.Released != NULL));
+}
+
+
+/* Hands File to the reader at its current position, when the reader is free. */
+static void AUDIO_File_Start(AUDIO_File_Type *File)
+{
+    if((AUDIO_File_Reader.Task == NULL) || (xTaskGetSchedulerState() != taskSCHEDULER_RUNNING) ||
+       ((AUDIO_File_Reader.File != NULL) && (AUDIO_File_Reader.File != File)))
+    {
+        return;
+    }
+
+    AUDIO_File_Reader.Stop      = 0;
+    AUDIO_File_Reader.EndOfFile = 0;
+    AUDIO_File_Reader.Result    = FR_OK;
+    AUDIO_File_Reader.File      = File;
+    File->ReadAhead             = 1;
+
+    xTaskNotifyGiveIndexed(AUDIO_File_Reader.Task, AUDIO_FILE_NOTIFY_INDEX);
+}
+
+
+/* Takes File back from the reader and drops what it has read ahead. */
+static void AUDIO_File_Stop(AUDIO_File_Type *File)
+{
+    if(AUDIO_File_Reader.File != File)
+    {
+        return;
+    }
+
+    AUDIO_File_Reader.Stop = 1;
+    xTaskNotifyGiveIndexed(AUDIO_File_Reader.Task, AUDIO_FILE_NOTIFY_INDEX);
+    xSemaphoreTake(AUDIO_File_Reader.Released, portMAX_DELAY);
+
+    xStreamBufferReset(AUDIO_File_Reader.Stream);
+    File->ReadAhead = 0;
+}
+
+
+/*******************************************************************************
+ * @brief       f_read() for files opened with AUDIO_File_Open().
+ * @param
+ * @retval      FR_OK or the FatFs error, *Read as f_read() sets it.
+ * @attention   A file read ahead blocks the caller until Length bytes or the
+ *              end of the file are in the stream.
+*******************************************************************************/
+FRESULT AUDIO_File_Read(AUDIO_File_Type *File, void *Buffer, UINT Length, UINT *Read)
+{
+    uint8_t *Data = (uint8_t *)Buffer;
+
+    if(File->ReadAhead == 0)
+    {
+        return AUDIO_File_ReadDirect(File, Buffer, Length, Read);
+    }
+
+    *Read = 0;
+
+    while(*Read < Length)
+    {
+        *Read += (UINT)xStreamBufferReceive(AUDIO_File_Reader.Stream, Data + *Read, Length - *Read,
+                                            pdMS_TO_TICKS(AUDIO_FILE_POLL_MS));
+
+        /* EndOfFile is set after the last chunk went in, so an empty stream is the end. */
+        if((*Read < Length) && (AUDIO_File_Reader.EndOfFile == 1) && xStreamBufferIsEmpty(AUDIO_File_Reader.Stream))
+        {
+            return AUDIO_File_Reader.Result;
+        }
+    }
+
+    return FR_OK;
+}
+
+
+/*******************************************************************************
+ * @brief       Reads the file handed over by AUDIO_File_Open() into the stream.
+ * @param       Parameter : unused.
+ * @retval      None
+ * @attention   Runs above the decoder, so the stream is topped up as soon as
+ *              there is room; the sd dma wait blocks it, not the cpu.
+*******************************************************************************/
+void AUDIO_File_ReaderTask(void *Parameter)
+{
+    AUDIO_File_Type *File;
+    FRESULT          Result;
+    UINT             Count, Sent;
+
+    (void)Parameter;
+
+    AUDIO_File_Reader.Task = xTaskGetCurrentTaskHandle();
+
+    for(;;)
+    {
+        ulTaskNotifyTakeIndexed(AUDIO_FILE_NOTIFY_INDEX, pdTRUE, portMAX_DELAY);
+
+        /* the stop that ended the last file, still pending. */
+        if((File = AUDIO_File_Reader.File) == NULL)
+        {
+            continue;
+        }
+
+        while((AUDIO_File_Reader.Stop == 0) && (AUDIO_File_Reader.EndOfFile == 0))
+        {
+            Result = AUDIO_File_ReadDirect(File, AUDIO_File_Chunk, AUDIO_FILE_CHUNK_SIZE, &Count);
+
+            for(Sent = 0; (Sent < Count) && (AUDIO_File_Reader.Stop == 0); )
+            {
+                Sent += (UINT)xStreamBufferSend(AUDIO_File_Reader.Stream, &AUDIO_File_Chunk[Sent], Count - Sent,
+                                                pdMS_TO_TICKS(AUDIO_FILE_POLL_MS));
+            }
+
+            if((Result != FR_OK) || (Count < AUDIO_FILE_CHUNK_SIZE))
+            {
+                AUDIO_File_Reader.Result    = Result;
+                AUDIO_File_Reader.EndOfFile = 1;
+            }
+        }
+
+        /* stay off the file until its owner takes it back. */
+        while(AUDIO_File_Reader.Stop == 0)
+        {
+            ulTaskNotifyTakeIndexed(AUDIO_FILE_NOTIFY_INDEX, pdTRUE, portMAX_DELAY);
+        }
+        AUDIO_File_Reader.File = NULL;
+        xSemaphoreGive(AUDIO_File_Reader.Released);
+    }
+}
+#endif
@@ -0,0 +1,51 @@
+#ifndef __AUDIO_FILE_H_
+#define __AUDIO_FILE_H_
+#include "hal_common.h"
+
+/*
+ * Read-only access to the songs. Opening a file builds its FatFs cluster link
+ * map (fast seek), so neither f_lseek() nor a read crossing a cluster has to
+ * follow the FAT chain. When the map shows the file in one piece, the whole
+ * sectors of a read go straight to disk_read() at the file's first sector plus
+ * the offset, only the partial sectors at either end go through f_read().
+ *
+ * With FreeRTOS (APP_FREERTOS) one open file at a time is also read ahead:
+ * AUDIO_File_ReaderTask() reads it in AUDIO_FILE_CHUNK_SIZE pieces into a
+ * stream buffer of AUDIO_FILE_STREAM_SIZE bytes and AUDIO_File_Read() takes
+ * from there, so the card is read while the other tasks decode. Seek and close
+ * stop the reader first; FatFs is only ever used by one task at a time.
+ */
+
+/* DWORDs of cluster link map per file: 2 for each fragment plus 2. */
+#ifndef AUDIO_FILE_CLMT_SIZE
+#define AUDIO_FILE_CLMT_SIZE    64u
+#endif
+
+#ifdef APP_FREERTOS
+#ifndef AUDIO_FILE_STREAM_SIZE
+#define AUDIO_FILE_STREAM_SIZE  (8u * 1024u)
+#endif
+#define AUDIO_FILE_CHUNK_SIZE   (2u * FF_MIN_SS)
+#endif
+
+typedef struct
+{
+    FIL     File;
+    DWORD   Clmt[AUDIO_FILE_CLMT_SIZE];
+    LBA_t   Sector;                     /* first sector of a contiguous file, 0 otherwise. */
+#ifdef APP_FREERTOS
+    uint8_t ReadAhead;                  /* read through the reader task. */
+#endif
+} AUDIO_File_Type;
+
+extern FRESULT AUDIO_File_Open(AUDIO_File_Type *File, const char *Path);
+extern FRESULT AUDIO_File_Read(AUDIO_File_Type *File, void *Buffer, UINT Length, UINT *Read);
+extern FRESULT AUDIO_File_Seek(AUDIO_File_Type *File, FSIZE_t Offset);
+extern FRESULT AUDIO_File_Close(AUDIO_File_Type *File);
+
+#ifdef APP_FREERTOS
+extern void    AUDIO_File_ReaderInit(void);
+extern void    AUDIO_File_ReaderTask(void *Parameter);
+#endif
+
+#endif
@@ -0,0 +1,111 @@
+/* Includes ------------------------------------------------------------------*/
+#include "audio_rtos.h"
+
+#ifdef APP_FREERTOS
+#include "FreeRTOS.h"
+#include "task.h"
+#include "audio.h"
+#include "audio_file.h"
+#include "scheduler.h"
+#include "board_it.h"
+#include "log_port.h"
+
+#define AUDIO_RTOS_NOTIFY_INDEX     1u      /* AUDIO_RTOS_WakeOutputFromISR() wakes the output task. */
+
+static TaskHandle_t AUDIO_RTOS_Output;
+
+
+static void AUDIO_RTOS_OutputTask(void *Parameter)
+{
+    (void)Parameter;
+
+    for(;;)
+    {
+        ulTaskNotifyTakeIndexed(AUDIO_RTOS_NOTIFY_INDEX, pdTRUE, portMAX_DELAY);
+        AUDIO_ProcessEvents();
+    }
+}
+
+
+static void AUDIO_RTOS_DecoderTask(void *Parameter)
+{
+    (void)Parameter;
+
+    for(;;)
+    {
+        uint32_t Delay;
+
+        Scheduler_Run();
+
+        /* blocks until the next periodic task is due, the events run in the output task. */
+        Delay = Scheduler_NextDueMs();
+        Delay = (Delay > 1000U) ? 1000U : Delay;
+        vTaskDelay((Delay != 0U) ? pdMS_TO_TICKS(Delay) : 1);
+    }
+}
+
+
+/*******************************************************************************
+ * @brief       Creates the player tasks and starts the kernel.
+ * @param       None
+ * @retval      None
+ * @attention   Only returns when the heap is too small for the idle task, the
+ *              caller's main loop then runs the player as before, reading the
+ *              files in place.
+*******************************************************************************/
+void AUDIO_RTOS_Start(void)
+{
+    BaseType_t Result;
+
+    AUDIO_File_ReaderInit();
+
+    Result  = xTaskCreate(AUDIO_RTOS_OutputTask,  "output",  AUDIO_RTOS_OUTPUT_STACK,  NULL, AUDIO_RTOS_OUTPUT_PRIO,  &AUDIO_RTOS_Output);
+    Result &= xTaskCreate(AUDIO_File_ReaderTask,  "reader",  AUDIO_RTOS_READER_STACK,  NULL, AUDIO_RTOS_READER_PRIO,  NULL);
+    Result &= xTaskCreate(AUDIO_RTOS_DecoderTask, "decoder", AUDIO_RTOS_DECODER_STACK, NULL, AUDIO_RTOS_DECODER_PRIO, NULL);
+    configASSERT(Result == pdPASS);
+
+    vTaskStartScheduler();
+
+    AUDIO_RTOS_Output = NULL;
+}
+
+
+/* From the i2s dma interrupt, after AUDIO_PostEvent() has queued an event. */
+void AUDIO_RTOS_WakeOutputFromISR(void)
+{
+    BaseType_t Woken = pdFALSE;
+
+    if(AUDIO_RTOS_Output != NULL)
+    {
+        vTaskNotifyGiveIndexedFromISR(AUDIO_RTOS_Output, AUDIO_RTOS_NOTIFY_INDEX, &Woken);
+        portYIELD_FROM_ISR(Woken);
+    }
+}
+
+
+void vApplicationIdleHook(void)
+{
+    WaitForInterrupt();
+}
+
+
+void vApplicationStackOverflowHook(TaskHandle_t Task, char *Name)
+{
+    (void)Task;
+
+    printf("\r\nStack overflow in %s!\r\n", Name);
+    LOG_Port_Flush();
+    taskDISABLE_INTERRUPTS();
+    for(;;);
+}
+
+
+void vApplicationMallocFailedHook(void)
+{
+    printf("\r\nFreeRTOS heap exhausted, raise configTOTAL_HEAP_SIZE!\r\n");
+    LOG_Port_Flush();
+    taskDISABLE_INTERRUPTS();
+    for(;;);
+}
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef __AUDIO_RTOS_H_
+#define __AUDIO_RTOS_H_
+#include "hal_common.h"
+
+/*
+ * FreeRTOS build of the player (APP_FREERTOS). AUDIO_RTOS_Start() replaces the
+ * main loop with three tasks, by priority:
+ *
+ *  - output  : does the work AUDIO_PostEvent() queues from the i2s dma
+ *              interrupt, i.e. refills the ring from the wav stream, so the
+ *              ring is topped up first whatever else is running;
+ *  - reader  : AUDIO_File_ReaderTask(), reads the open song ahead into a
+ *              stream buffer, blocked while the sd dma runs;
+ *  - decoder : runs the scheduler loops, Audio_Task() and with it the mp3
+ *              decode, which blocks in I2S_Ring_Wait() while the ring is full.
+ *
+ * The idle task sleeps with WFI.
+ */
+
+/* priorities, the idle task is 0. */
+#define AUDIO_RTOS_OUTPUT_PRIO      3u
+#define AUDIO_RTOS_READER_PRIO      2u
+#define AUDIO_RTOS_DECODER_PRIO     1u
+
+/* stack depths in words; libmad keeps a granule's spectrum (4.5 KiB) on the stack. */
+#define AUDIO_RTOS_OUTPUT_STACK     384u
+#define AUDIO_RTOS_READER_STACK     384u
+#define AUDIO_RTOS_DECODER_STACK    2048u
+
+extern void AUDIO_RTOS_Start(void);
+extern void AUDIO_RTOS_WakeOutputFromISR(void);
+
+#endif
@@ -0,0 +1,44 @@
+/* Includes ------------------------------------------------------------------*/
+#include "event_queue.h"
+
+
+/* Producer side, safe from an interrupt. false when the queue is full. */
+bool EVENT_Queue_Put(EVENT_Queue_Type *Queue, uint8_t Event)
+{
+    uint32_t Head = Queue->Head;
+
+    if((Head - Queue->Tail) >= EVENT_QUEUE_SIZE)
+    {
+        Queue->Dropped++;
+        return false;
+    }
+
+    /* the event is in place before Head lets the consumer see it. */
+    Queue->Events[Head % EVENT_QUEUE_SIZE] = Event;
+    Queue->Head = Head + 1u;
+
+    return true;
+}
+
+
+/* Consumer side. false when there is nothing queued. */
+bool EVENT_Queue_Get(EVENT_Queue_Type *Queue, uint8_t *Event)
+{
+    uint32_t Tail = Queue->Tail;
+
+    if(Tail == Queue->Head)
+    {
+        return false;
+    }
+
+    *Event      = Queue->Events[Tail % EVENT_QUEUE_SIZE];
+    Queue->Tail = Tail + 1u;
+
+    return true;
+}
+
+
+bool EVENT_Queue_Empty(const EVENT_Queue_Type *Queue)
+{
+    return (Queue->Tail == Queue->Head);
+}
@@ -0,0 +1,26 @@
+#ifndef __EVENT_QUEUE_H_
+#define __EVENT_QUEUE_H_
+#include "hal_common.h"
+
+/*
+ * Lock-free single producer, single consumer queue of one byte events, used to
+ * hand work from an interrupt to thread level. The producer only writes Head,
+ * the consumer only writes Tail, and every access is volatile, so on a single
+ * core neither side needs to mask interrupts. A full queue drops the event and
+ * counts it; the consumer sees the queue as empty again once it catches up.
+ */
+#define EVENT_QUEUE_SIZE        16u                 /* power of two. */
+
+typedef struct
+{
+    volatile uint32_t Head;                         /* events put, producer only. */
+    volatile uint32_t Tail;                         /* events taken, consumer only. */
+    volatile uint32_t Dropped;                      /* producer only. */
+    volatile uint8_t  Events[EVENT_QUEUE_SIZE];
+} EVENT_Queue_Type;
+
+extern bool EVENT_Queue_Put(EVENT_Queue_Type *Queue, uint8_t Event);
+extern bool EVENT_Queue_Get(EVENT_Queue_Type *Queue, uint8_t *Event);
+extern bool EVENT_Queue_Empty(const EVENT_Queue_Type *Queue);
+
+#endif
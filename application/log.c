@@ -0,0 +1,90 @@
+/* Includes ------------------------------------------------------------------*/
+#include "log.h"
+
+#ifdef LOG_TRACE
+#include <stdarg.h>
+#include "board_it.h"
+#include "log_port.h"
+
+LOG_Trace_Type LOG_Trace =
+{
+    LOG_TRACE_MAGIC, 0u, 0u, LOG_TRACE_RECORD_NUM, LOG_TRACE_ARG_MAX
+};
+
+
+/*******************************************************************************
+ * @brief       Stores one record in place of printf, from any task or interrupt.
+ * @param       Level : LOG_LEVEL_xxx
+ * @param       Nargs : arguments after Fmt
+ * @param       Fmt   : printf format, only its address is kept
+ * @retval      None
+ * @attention   The record is filled with interrupts masked, a few dozen cycles.
+*******************************************************************************/
+void LOG_Trace_Write(uint32_t Level, uint32_t Nargs, const char *Fmt, ...)
+{
+    LOG_Record_Type *Record;
+    va_list Args;
+    uint32_t Mask, Index;
+
+    Mask = __get_PRIMASK();
+    __disable_irq();
+
+    LOG_Trace.Freq = GetCycleCountFreq();
+    Record = &LOG_Trace.Record[LOG_Trace.Count % LOG_TRACE_RECORD_NUM];
+    Record->Fmt   = (uint32_t)Fmt;
+    Record->Time  = GetCycleCount();
+    Record->Seq   = LOG_Trace.Count++;
+    Record->Level = (uint8_t)Level;
+    Record->Nargs = (uint8_t)Nargs;
+
+    va_start(Args, Fmt);
+    for(Index = 0; (Index < Nargs) && (Index < LOG_TRACE_ARG_MAX); Index++)
+    {
+        Record->Args[Index] = va_arg(Args, uint32_t);
+    }
+    va_end(Args);
+
+    __set_PRIMASK(Mask);
+}
+
+
+/*******************************************************************************
+ * @brief       Prints the records, oldest first, for log_decode.py.
+ * @param       None
+ * @retval      None
+ * @attention   Waits for the console after every line, the dump is larger than
+ *              the log ring. Records written meanwhile may replace old ones.
+*******************************************************************************/
+void LOG_Trace_Dump(void)
+{
+    LOG_Record_Type Record;
+    uint32_t Count = LOG_Trace.Count;
+    uint32_t Seq   = (Count > LOG_TRACE_RECORD_NUM) ? (Count - LOG_TRACE_RECORD_NUM) : 0u;
+    uint32_t Mask, Index;
+
+    printf("#trace %lu %lu\r\n", (unsigned long)LOG_Trace.Freq, (unsigned long)Count);
+
+    for(; Seq != Count; Seq++)
+    {
+        Mask = __get_PRIMASK();
+        __disable_irq();
+        Record = LOG_Trace.Record[Seq % LOG_TRACE_RECORD_NUM];
+        __set_PRIMASK(Mask);
+
+        if(Record.Seq != Seq)
+        {
+            continue;
+        }
+
+        printf("#T %lu %u %08lx %08lx %u", (unsigned long)Record.Seq, Record.Level,
+               (unsigned long)Record.Fmt, (unsigned long)Record.Time, Record.Nargs);
+        for(Index = 0; Index < LOG_TRACE_ARG_MAX; Index++)
+        {
+            printf(" %08lx", (unsigned long)Record.Args[Index]);
+        }
+        printf("\r\n");
+        LOG_Port_Flush();
+    }
+}
+
+#endif
@@ -0,0 +1,92 @@
+#ifndef __LOG_H_
+#define __LOG_H_
+#include "hal_common.h"
+#include <stdio.h>
+
+/*
+ * Logging macros for the player. LOG_E/W/I/D(fmt, ...) take printf arguments;
+ * a level above LOG_LEVEL compiles to nothing, its arguments included. Set
+ * LOG_LEVEL for the build, or before including this file for one module.
+ *
+ * With LOG_TRACE defined nothing is formatted on the target: each call stores
+ * the format string's address, the cycle counter and up to LOG_TRACE_ARG_MAX
+ * raw 32-bit arguments in LOG_Trace, a ring that overwrites the oldest record.
+ * host/log_decode.py formats them from the image's .axf and either a memory
+ * dump of LOG_Trace or the LOG_Trace_Dump() console output. Arguments must be
+ * 32-bit (integers, pointers); a %s prints only if its string is in the image.
+ */
+#define LOG_LEVEL_NONE          0u
+#define LOG_LEVEL_ERROR         1u
+#define LOG_LEVEL_WARN          2u
+#define LOG_LEVEL_INFO          3u
+#define LOG_LEVEL_DEBUG         4u
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL               LOG_LEVEL_INFO
+#endif
+
+#define LOG_TRACE_RECORD_NUM    128u                /* power of two, 5 KiB. */
+#define LOG_TRACE_ARG_MAX       6u                  /* the most any call in the player passes. */
+#define LOG_TRACE_MAGIC         0x54474F4Cu         /* "LOGT", marks the dump for the decoder. */
+
+typedef struct
+{
+    uint32_t Fmt;                                   /* address of the format string. */
+    uint32_t Time;                                  /* GetCycleCount(). */
+    uint32_t Seq;                                   /* LOG_Trace.Count when written. */
+    uint8_t  Level;
+    uint8_t  Nargs;                                 /* arguments passed, may exceed LOG_TRACE_ARG_MAX. */
+    uint16_t Reserved;
+    uint32_t Args[LOG_TRACE_ARG_MAX];
+} LOG_Record_Type;
+
+typedef struct
+{
+    uint32_t        Magic;
+    uint32_t        Freq;                           /* GetCycleCountFreq(). */
+    uint32_t        Count;                          /* records written, the next goes to Count % RECORD_NUM. */
+    uint16_t        RecordNum;
+    uint16_t        ArgMax;
+    LOG_Record_Type Record[LOG_TRACE_RECORD_NUM];
+} LOG_Trace_Type;
+
+/* number of arguments, the format included, up to 9. */
+#define LOG_NARGS(...)          LOG_NARGS_(__VA_ARGS__, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define LOG_NARGS_(_1, _2, _3, _4, _5, _6, _7, _8, _9, N, ...)  N
+
+#ifdef LOG_TRACE
+#define LOG_EMIT(Level, ...)    LOG_Trace_Write((Level), LOG_NARGS(__VA_ARGS__) - 1u, __VA_ARGS__)
+#else
+#define LOG_EMIT(Level, ...)    printf(__VA_ARGS__)
+#endif
+
+#if (LOG_LEVEL >= LOG_LEVEL_ERROR)
+#define LOG_E(...)              LOG_EMIT(LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define LOG_E(...)              ((void)0)
+#endif
+
+#if (LOG_LEVEL >= LOG_LEVEL_WARN)
+#define LOG_W(...)              LOG_EMIT(LOG_LEVEL_WARN, __VA_ARGS__)
+#else
+#define LOG_W(...)              ((void)0)
+#endif
+
+#if (LOG_LEVEL >= LOG_LEVEL_INFO)
+#define LOG_I(...)              LOG_EMIT(LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define LOG_I(...)              ((void)0)
+#endif
+
+#if (LOG_LEVEL >= LOG_LEVEL_DEBUG)
+#define LOG_D(...)              LOG_EMIT(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define LOG_D(...)              ((void)0)
+#endif
+
+extern LOG_Trace_Type LOG_Trace;
+
+extern void LOG_Trace_Write(uint32_t Level, uint32_t Nargs, const char *Fmt, ...);
+extern void LOG_Trace_Dump(void);
+
+#endif
@@ -11,6 +11,9 @@
 #include "ff.h"
 #include "scheduler.h"
 #include "board_it.h"
+#include "mp3_bench.h"
+#include "audio.h"
+#include "audio_rtos.h"
 /*
  * Macros.
  */
@@ -37,15 +40,28 @@ int main(void)
 		printf(">fatFs_init() Start...\r\n");
 		fatFs_init();
 		printf(">fatFs_init() Done!\r\n");
+#ifdef APP_MP3_BENCH
+		/* decoder benchmark over the music folder, build libmad with MAD_PROFILE for per stage figures. */
+		CycleCounter_Init();
+		MP3_Bench_Run(AUDIO_MUSIC_PATH, 1);
+#endif
 		printf(">Scheduler_Setup() Start...\r\n");
 		Scheduler_Setup();
 		printf(">Scheduler_Setup() Done!\r\n");
 		printf("**********Init END************\r\n");
 		AUDIO_Init();
+#ifdef APP_FREERTOS
+		printf("---------------vTaskStartScheduler-------------------\r\n");
+		/* output, reader and decoder tasks, see audio_rtos.h. */
+		AUDIO_RTOS_Start();
+#endif
 		printf("---------------Scheduler_Run-------------------\r\n");
     while (1)
     {
+			/* wav refills and the other work the dma interrupts defer run as event tasks. */
 			Scheduler_Run();
+			/* WFI until the next task is due or an interrupt triggers one. */
+			Scheduler_Sleep();
     }
 }
 
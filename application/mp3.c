@@ -1,100 +1,32 @@
 /* Includes ------------------------------------------------------------------*/
 #include "mp3.h"
-#include "mad.h"
+#include "mp3_decoder.h"
 #include "i2s_port.h"
+#include "audio.h"
 #include "scheduler.h"
+#include "board_it.h"
+#include "log.h"
 
-#define MP3_LIBMAD_I_BUFFER_SIZE    (10 * 1024)
-#define MP3_LIBMAD_O_BUFFER_SIZE    (5  * 1024)
+#ifndef MP3_DECODER_DEFAULT
+#define MP3_DECODER_DEFAULT         MP3_Decoder_Auto
+#endif
 
-FIL     MP3_libmad_File;
-UINT    MP3_libmad_BR;
-FRESULT MP3_libmad_RES;
+#define MP3_STAGE_FRAMES            576u        /* decoder output ahead of the resampler, half a Layer III frame. */
 
-DTCM_RAM unsigned short MP3_libmad_oBuffer[2][MP3_LIBMAD_O_BUFFER_SIZE];
-unsigned char  MP3_libmad_iBuffer[MP3_LIBMAD_I_BUFFER_SIZE+MAD_BUFFER_GUARD];
+MP3_Decoder_Backend_Type MP3_Backend = MP3_DECODER_DEFAULT;   /* decoder for the next song. */
+MP3_Economy_Type         MP3_Economy = MP3_ECONOMY_DEFAULT;   /* half rate synthesis for the next song. */
 
-uint8_t  MP3_libmad_NextIndex  = 0;
-uint8_t  MP3_libmad_PlayEnded  = 0;
-uint32_t MP3_libmad_SampleRate = 0;
-uint32_t MP3_libmad_BufferSize = 0;
+uint16_t *MP3_oBuffer    = NULL;        /* output ring slot being filled. */
+uint32_t  MP3_SampleRate = 0;           /* rate of the stream's first frame, I2S is set up for it. */
+uint32_t  MP3_RateErrors = 0;           /* frames decoded at another rate, played at MP3_SampleRate. */
+uint32_t  MP3_BufferSize = 0;
+uint64_t  MP3_IdleTicks  = 0;           /* cycles slept waiting for a free slot. */
 
-struct mad_stream MP3_libmad_Stream;
-struct mad_frame  MP3_libmad_Frame;
-struct mad_synth  MP3_libmad_Synth;
-mad_timer_t       MP3_libmad_Timer;
-
-extern uint8_t I2S_DMA_Finish;
-
-
-/*******************************************************************************
- * @brief       
- * @param       
- * @retval      
- * @attention   
-*******************************************************************************/
-const char *MP3_libmad_MadErrorString(const struct mad_stream *Stream)
-{
-    switch(Stream->error)
-    {
-        /* Generic unrecoverable errors */
-        case MAD_ERROR_BUFLEN:          return("input buffer too small (or EOF)");
-        case MAD_ERROR_BUFPTR:          return("invalid (null) buffer pointer");
-        case MAD_ERROR_NOMEM:           return("not enough memory");
-
-        /* Frame header related unrecoverable errors */
-        case MAD_ERROR_LOSTSYNC:        return("lost synchronization");
-        case MAD_ERROR_BADLAYER:        return("reserved header layer value");
-        case MAD_ERROR_BADBITRATE:      return("forbidden bitrate value");
-        case MAD_ERROR_BADSAMPLERATE:   return("reserved sample frequency value");
-        case MAD_ERROR_BADEMPHASIS:     return("reserved emphasis value");
-
-        /* Recoverable errors */
-        case MAD_ERROR_BADCRC:          return("CRC check failed");
-        case MAD_ERROR_BADBITALLOC:     return("forbidden bit allocation value");
-        case MAD_ERROR_BADSCALEFACTOR:  return("bad scalefactor index");
-        case MAD_ERROR_BADFRAMELEN:     return("bad frame length");
-        case MAD_ERROR_BADBIGVALUES:    return("bad big_values count");
-        case MAD_ERROR_BADBLOCKTYPE:    return("reserved block_type");
-        case MAD_ERROR_BADSCFSI:        return("bad scalefactor selection info");
-        case MAD_ERROR_BADDATAPTR:      return("bad main_data_begin pointer");
-        case MAD_ERROR_BADPART3LEN:     return("bad audio data length");
-        case MAD_ERROR_BADHUFFTABLE:    return("bad Huffman table select");
-        case MAD_ERROR_BADHUFFDATA:     return("Huffman data overrun");
-        case MAD_ERROR_BADSTEREO:       return("incompatible block_type for JS");
-
-        /* Unknown error. This switch may be out of sync with libmad's
-         * defined error codes
-         */
-        default:                        return("Unknown error code");
-    }
-}
-
-
-/*******************************************************************************
- * @brief       
- * @param       
- * @retval      
- * @attention   
-*******************************************************************************/
-signed short MP3_libmad_MadFixedToSshort(mad_fixed_t Sample)
-{
-    /* round */
-    Sample += (1L << (MAD_F_FRACBITS - 16));
-
-    /* clip */
-    if(Sample >= MAD_F_ONE)
-    {
-        Sample = MAD_F_ONE - 1;
-    }
-    else if(Sample < -MAD_F_ONE)
-    {
-        Sample = -MAD_F_ONE;
-    }
-
-    /* quantize */
-    return (Sample >> (MAD_F_FRACBITS + 1 - 16));
-}
+static RESAMPLE_Type *MP3_Resampler = NULL;                 /* NULL: decoded straight into the output slot. */
+static uint8_t  MP3_HalfRate   = 0;                         /* the song playing is synthesized at half rate. */
+static uint16_t MP3_LoadPermille = 0;                       /* cpu load of the last song, 1000 - idle. */
+static uint32_t MP3_SynthFull  = 0;                         /* synthesis ticks per frame and channel, last full rate song. */
+static __ALIGNED(4) uint16_t MP3_Stage[2 * MP3_STAGE_FRAMES];
 
 
 /*******************************************************************************
@@ -103,49 +35,38 @@ signed short MP3_libmad_MadFixedToSshort(mad_fixed_t Sample)
  * @retval      
  * @attention   
 *******************************************************************************/
-void MP3_libmad_PrintFrameInfo(struct mad_header *Header)
+void MP3_PrintFrameInfo(const MP3_Decoder_Info_Type *Info)
 {
-    const char *Layer, *Mode, *Emphasis;
+    const char *Layer, *Mode;
 
-    switch(Header->layer)
+    switch(Info->Layer)
     {
-        case MAD_LAYER_I  : Layer = "I";   break;
-        case MAD_LAYER_II : Layer = "II";  break;
-        case MAD_LAYER_III: Layer = "III"; break;
+        case 1 : Layer = "I";   break;
+        case 2 : Layer = "II";  break;
+        case 3 : Layer = "III"; break;
         default:
             Layer = "(unexpected layer value)";
             break;
     }
 
     /* Convert the audio mode to it's printed representation. */
-    switch(Header->mode)
+    switch(Info->Mode)
     {
-        case MAD_MODE_SINGLE_CHANNEL: Mode = "single channel";              break;
-        case MAD_MODE_DUAL_CHANNEL  : Mode = "dual channel";                break;
-        case MAD_MODE_JOINT_STEREO  : Mode = "joint (MS/intensity) stereo"; break;
-        case MAD_MODE_STEREO        : Mode = "normal LR stereo";            break;
+        case 0 : Mode = "single channel";              break;
+        case 1 : Mode = "dual channel";                break;
+        case 2 : Mode = "joint (MS/intensity) stereo"; break;
+        case 3 : Mode = "normal LR stereo";            break;
         default:
             Mode = "(unexpected mode value)";
             break;
     }
 
-    switch(Header->emphasis)
-    {
-        case MAD_EMPHASIS_NONE      : Emphasis = "no";         break;
-        case MAD_EMPHASIS_50_15_US  : Emphasis = "50/15 us";   break;
-        case MAD_EMPHASIS_CCITT_J_17: Emphasis = "CCITT J.17"; break;
-        default:
-            Emphasis = "(unexpected emphasis value)";
-            break;
-    }
-
-    printf("\r\n");
-    printf("%lu bp/s audio MPEG layer %s stream %s CRC, "
-           "%s with %s emphasis at %d Hz sample rate\r\n",
-            Header->bitrate, Layer,
-            Header->flags & MAD_FLAG_PROTECTION ? "with" : "without",
-            Mode,Emphasis, Header->samplerate);
-    printf("\r\n");
+    LOG_I("\r\n");
+    LOG_I("%lu bp/s audio MPEG layer %s stream, "
+           "%s at %lu Hz sample rate, %s decoder\r\n",
+            (unsigned long)Info->Bitrate, Layer, Mode, (unsigned long)Info->SampleRate,
+            MP3_Decoder_GetName(Info->Backend));
+    LOG_I("\r\n");
 }
 
 
@@ -155,30 +76,86 @@ void MP3_libmad_PrintFrameInfo(struct mad_header *Header)
  * @retval      
  * @attention   
 *******************************************************************************/
-void MP3_libmad_PlayHandler(uint32_t SampleRate)
+void MP3_PlayHandler(void)
 {
-    if(MP3_libmad_BufferSize == MP3_LIBMAD_O_BUFFER_SIZE)
+    if(MP3_BufferSize == I2S_RING_SLOT_SIZE)
     {
-        if(SampleRate != MP3_libmad_SampleRate)  
+        I2S_Ring_Commit();
+
+        /* ring full: keep the other tasks going and sleep until the dma frees a slot. */
+        while((MP3_oBuffer = I2S_Ring_GetWriteSlot()) == NULL)
         {
-            MP3_libmad_SampleRate = SampleRate;
+            uint32_t Start;
 
-            I2S_Configure(I2S_Protocol_PHILIPS, I2S_DataWidth_16b,I2S_AudioFreq_44k, I2S_XferMode_TxOnly);
+            Scheduler_Run();
+
+            Start = GetCycleCount();
+            I2S_Ring_Wait();
+            MP3_IdleTicks += GetCycleCount() - Start;
         }
 
-       // I2S_DMA_WaitEOT();
-				while(I2S_DMA_Finish!=1)
-				{
-					Scheduler_Run();
-					printf("-----Wait-----\r\n");
-				}
+        MP3_BufferSize = 0;
+    }
+}
 
-        I2S_DMA_Transfer(MP3_libmad_oBuffer[MP3_libmad_NextIndex], MP3_LIBMAD_O_BUFFER_SIZE);
 
-        if(MP3_libmad_NextIndex == 0) MP3_libmad_NextIndex = 1;
-        else                          MP3_libmad_NextIndex = 0;
+/* Full or half rate synthesis for the next song, see MP3_Economy_Type. */
+static uint8_t MP3_UseHalfRate(void)
+{
+    switch(MP3_Economy)
+    {
+        case MP3_Economy_On:
+            return 1;
+
+        case MP3_Economy_Auto:
+            return (MP3_LoadPermille >= ((MP3_HalfRate == 1) ? MP3_ECONOMY_OFF_PERMILLE : MP3_ECONOMY_ON_PERMILLE)) ? 1 : 0;
 
-        MP3_libmad_BufferSize = 0;
+        default:
+            return 0;
+    }
+}
+
+/* Synthesis cost of the song, against the last full rate one for a half rate song. */
+static void MP3_PrintSynthesis(const MP3_Decoder_Info_Type *Info)
+{
+    uint32_t Ticks;
+
+    if((Info->SynthTicks == 0) || (Info->Frames == 0) || (Info->Channels == 0))
+    {
+        return;
+    }
+    Ticks = (uint32_t)(Info->SynthTicks / Info->Frames / Info->Channels);
+
+    if(MP3_HalfRate == 0)
+    {
+        MP3_SynthFull = Ticks;
+        LOG_I("\r\nsynthesis %lu ticks per frame and channel\r\n", (unsigned long)Ticks);
+    }
+    else if((MP3_SynthFull != 0) && (Ticks < MP3_SynthFull))
+    {
+        LOG_I("\r\nhalf rate synthesis %lu ticks per frame and channel, %lu%% saved\r\n",
+              (unsigned long)Ticks, (unsigned long)((MP3_SynthFull - Ticks) * 100 / MP3_SynthFull));
+    }
+    else
+    {
+        LOG_I("\r\nhalf rate synthesis %lu ticks per frame and channel\r\n", (unsigned long)Ticks);
+    }
+}
+
+/* Resamples Count decoded frames into the output slots, queuing each one filled. */
+static void MP3_Resample(const uint16_t *Input, uint32_t Count)
+{
+    uint32_t Used;
+
+    while(Count != 0)
+    {
+        Used = Count;
+        MP3_BufferSize += 2 * RESAMPLE_Process(MP3_Resampler, Input, &Used,
+                                               &MP3_oBuffer[MP3_BufferSize], (I2S_RING_SLOT_SIZE - MP3_BufferSize) / 2);
+        Input += 2 * Used;
+        Count -= Used;
+
+        MP3_PlayHandler();
     }
 }
 
@@ -189,150 +166,131 @@ void MP3_libmad_PlayHandler(uint32_t SampleRate)
  * @retval      
  * @attention   
 *******************************************************************************/
-void MP3_libmad_PlaySong(char *Path, char *Name)
+void MP3_PlaySong(char *Path, char *Name)
 {
     static char     FilePath[100];
-    static int      TagSize   = 0;
-    static uint32_t FrameCount  = 0;
-
-    /* First the structures used by libmad must be initialized. */
-    mad_stream_init(&MP3_libmad_Stream);
-    mad_frame_init( &MP3_libmad_Frame );
-    mad_synth_init( &MP3_libmad_Synth );
-    mad_timer_reset(&MP3_libmad_Timer );
+    const MP3_Decoder_Info_Type *Info = MP3_Decoder_GetInfo();
+    uint32_t        SongTime, Count, Capacity, PlayMs, Idle;
+    uint16_t       *Output;
+    MP3_Decoder_Backend_Type Backend = MP3_Backend;
+    uint64_t        Samples;
+    I2S_Ring_Stats_Type RingStats;
 
     memset( FilePath, 0x00, sizeof(FilePath));
     sprintf(FilePath, "%s%s",   Path,   Name);
 
-    if(f_open(&MP3_libmad_File, FilePath, FA_READ) == FR_OK)
+    /* only libmad has half rate synthesis. */
+    MP3_HalfRate = MP3_UseHalfRate();
+    if((MP3_HalfRate == 1) && (MP3_DECODER_LIBMAD_ENABLE != 0))
     {
-        I2S_PowerON(1);
-
-        MP3_libmad_PlayEnded = 0;
-        I2S_DMA_Finish       = 1;
-
-
-        MP3_libmad_RES = f_read(&MP3_libmad_File, MP3_libmad_iBuffer, MP3_LIBMAD_I_BUFFER_SIZE, &MP3_libmad_BR);
+        Backend = MP3_Decoder_Libmad;
+    }
 
-        if(strncmp("ID3", (char *)MP3_libmad_iBuffer, 3) == 0)
+    if(MP3_Decoder_Open(FilePath, Backend) == 0)
+    {
+        if((MP3_HalfRate == 1) && (MP3_Decoder_SetHalfRate(true) != 0))
         {
-            /*ǩϢܴС  ǩͷ10ֽ*/
-            TagSize =  ((unsigned int)MP3_libmad_iBuffer[6] << 21) |
-                       ((unsigned int)MP3_libmad_iBuffer[7] << 14) |
-                       ((unsigned int)MP3_libmad_iBuffer[8] << 7)  |
-                       ((unsigned int)MP3_libmad_iBuffer[9] << 0);
-
-            TagSize += 10;
-
-            printf("\r\nMP3 TAG Size : %d\r\n", TagSize);
+            MP3_HalfRate = 0;
+            LOG_W("\r\nno half rate synthesis with %s\r\n", MP3_Decoder_GetName(Info->Backend));
         }
 
-        f_lseek(&MP3_libmad_File, TagSize);   /* TAGϢ */
+        I2S_PowerON(1);
+
+        MP3_SampleRate = 0;
+        MP3_RateErrors = 0;
+        MP3_BufferSize = 0;
+        MP3_IdleTicks  = 0;
+        MP3_Resampler  = NULL;
+        SongTime       = GetSysRunTimeMs();
+        Samples        = 0;
 
+        I2S_Ring_Reset();
+        MP3_oBuffer = I2S_Ring_GetWriteSlot();
 
-        while(1)
+        for(;;)
         {
-            if((MP3_libmad_Stream.buffer == NULL) || (MP3_libmad_Stream.error == MAD_ERROR_BUFLEN))
+            /* straight into the output slot, through MP3_Stage for the first call and when resampling. */
+            Output   = ((MP3_Resampler != NULL) || (Samples == 0)) ? MP3_Stage : &MP3_oBuffer[MP3_BufferSize];
+            Capacity = (Output == MP3_Stage) ? MP3_STAGE_FRAMES : ((I2S_RING_SLOT_SIZE - MP3_BufferSize) / 2);
+
+            /* a frame that does not fit continues in the next call. */
+            if((Count = MP3_Decoder_DecodeFrame(Output, Capacity)) == 0)
             {
-                size_t         ReadSize, Remaining;		
-                unsigned char *ReadStart = NULL;
-
-                if(MP3_libmad_Stream.next_frame != NULL)
-                {
-                    Remaining = MP3_libmad_Stream.bufend - MP3_libmad_Stream.next_frame;
-                    memmove(MP3_libmad_iBuffer, MP3_libmad_Stream.next_frame, Remaining);
-
-                    ReadStart = MP3_libmad_iBuffer       + Remaining;
-                    ReadSize  = MP3_LIBMAD_I_BUFFER_SIZE - Remaining;
-                }
-                else
-                {
-                    ReadSize  = MP3_LIBMAD_I_BUFFER_SIZE,
-                    ReadStart = MP3_libmad_iBuffer,
-                    Remaining = 0;
-                }
-
-                MP3_libmad_RES = f_read(&MP3_libmad_File, (char *)ReadStart, ReadSize, &MP3_libmad_BR);
-
-                if((MP3_libmad_BR <= 0) || (MP3_libmad_BR < ReadSize))
-                {
-                    printf("\r\nEnd Of File\r\n");  break;
-                }
-
-                mad_stream_buffer(&MP3_libmad_Stream, MP3_libmad_iBuffer, MP3_libmad_BR + Remaining);
-                MP3_libmad_Stream.error = MAD_ERROR_NONE;
+                break;
             }
 
-            if(mad_frame_decode(&MP3_libmad_Frame, &MP3_libmad_Stream))
+            /* the rate is negotiated once, from the first frame of the stream. */
+            if(Samples == 0)
             {
-                if(MAD_RECOVERABLE(MP3_libmad_Stream.error))
-                {
-                    if((MP3_libmad_Stream.error != MAD_ERROR_LOSTSYNC) || (MP3_libmad_Stream.this_frame != NULL))
-                    {
-                        printf("\r\nRecoverable   Frame Level Error (%s)\r\n", MP3_libmad_MadErrorString(&MP3_libmad_Stream));
-                    }
-
-                    continue;
-                }
-                else
-                {
-                    if(MP3_libmad_Stream.error == MAD_ERROR_BUFLEN)
-                    {
-                        continue;
-                    }
-                    else
-                    {
-                        printf("\r\nUnrecoverable Frame Level Error (%s)\r\n", MP3_libmad_MadErrorString(&MP3_libmad_Stream));
-                        break;
-                    }
-                }
-             }
-
-            if(FrameCount == 0)
+                MP3_PrintFrameInfo(Info);
+
+                MP3_SampleRate = Info->SampleRate;
+                MP3_Resampler  = AUDIO_SetSampleRate(MP3_SampleRate);
+            }
+            else if(Info->SampleRate != MP3_SampleRate)
             {
-                MP3_libmad_PrintFrameInfo(&MP3_libmad_Frame.header);
+                MP3_RateErrors++;
             }
 
-            FrameCount++;
-            mad_timer_add(&MP3_libmad_Timer, MP3_libmad_Frame.header.duration);
-
-            mad_synth_frame(&MP3_libmad_Synth, &MP3_libmad_Frame);
+            Samples += Count;
 
-            for(uint32_t i = 0; i < MP3_libmad_Synth.pcm.length; i++)
+            if(MP3_Resampler != NULL)
             {
-                short Sample = MP3_libmad_MadFixedToSshort(MP3_libmad_Synth.pcm.samples[0][i]);
-
-                MP3_libmad_oBuffer[MP3_libmad_NextIndex][MP3_libmad_BufferSize++] = Sample;
-
-                if(MAD_NCHANNELS(&MP3_libmad_Frame.header) == 2)	
-                {
-                    Sample = MP3_libmad_MadFixedToSshort(MP3_libmad_Synth.pcm.samples[1][i]);
-                }
-
-                MP3_libmad_oBuffer[MP3_libmad_NextIndex][MP3_libmad_BufferSize++] = Sample;
-
-                MP3_libmad_PlayHandler(MP3_libmad_Synth.pcm.samplerate);
+                MP3_Resample(MP3_Stage, Count);
+                continue;
             }
 
-            if(MP3_libmad_PlayEnded == 1)
+            if(Output == MP3_Stage)
             {
-                break;
+                memcpy(&MP3_oBuffer[MP3_BufferSize], MP3_Stage, Count * 2 * sizeof(uint16_t));
             }
+            MP3_BufferSize += 2 * Count;
+
+            MP3_PlayHandler();
+        }
+
+        /* play out what is queued, the last partial slot padded with silence. */
+        if(MP3_BufferSize != 0)
+        {
+            memset(&MP3_oBuffer[MP3_BufferSize], 0, (I2S_RING_SLOT_SIZE - MP3_BufferSize) * sizeof(uint16_t));
+            MP3_BufferSize = I2S_RING_SLOT_SIZE;
+            MP3_PlayHandler();
+        }
+        I2S_Ring_Flush();
+        while(I2S_Ring_Busy())
+        {
+            I2S_Ring_Wait();
         }
 
         DMA_EnableChannel(DMA1,DMA_REQ_DMA1_SPI2_TX,false);
 
-        f_close(&MP3_libmad_File);
+        SongTime = GetSysRunTimeMs() - SongTime;
+        Idle     = (SongTime != 0) ? (uint32_t)(MP3_IdleTicks * 1000 / ((uint64_t)SongTime * (GetCycleCountFreq() / 1000))) : 0;
+        MP3_LoadPermille = (Idle < 1000) ? (uint16_t)(1000 - Idle) : 0;
+
+        I2S_Ring_GetStats(&RingStats);
+        LOG_I("\r\n%lu slots played, %lu underruns, %lu%% idle\r\n",
+              (unsigned long)RingStats.Played, (unsigned long)RingStats.Underruns, (unsigned long)(Idle / 10));
+        MP3_PrintSynthesis(Info);
+
+        MP3_Decoder_Close();
 
         I2S_PowerON(0);
-    }
 
-    mad_synth_finish( &MP3_libmad_Synth );
-    mad_frame_finish( &MP3_libmad_Frame );
-    mad_stream_finish(&MP3_libmad_Stream);
+        PlayMs = (MP3_SampleRate != 0) ? (uint32_t)(Samples * 1000 / MP3_SampleRate) : 0;
 
-    static char Buffer[80];
-    mad_timer_string(MP3_libmad_Timer, Buffer, "%lu:%02lu.%03u", MAD_UNITS_MINUTES, MAD_UNITS_MILLISECONDS, 0);
-    printf("\r\n%d Frames Decoded (%s).\r\n", FrameCount, Buffer);
-}
+        if(MP3_RateErrors != 0)
+        {
+            LOG_W("\r\n%lu frames not at %lu Hz, played at that rate\r\n",
+                  (unsigned long)MP3_RateErrors, (unsigned long)MP3_SampleRate);
+        }
 
+        LOG_I("\r\n%lu Frames Decoded, %lu skipped (%lu:%02lu.%03lu).\r\n",
+               (unsigned long)Info->Frames, (unsigned long)Info->Errors,
+               (unsigned long)(PlayMs / 60000), (unsigned long)((PlayMs / 1000) % 60), (unsigned long)(PlayMs % 1000));
+    }
+    else
+    {
+        LOG_E("\r\nMP3 File Open Error : %s\r\n", FilePath);
+    }
+}
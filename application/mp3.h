@@ -1,6 +1,31 @@
 #ifndef __MP3_H_
 #define __MP3_H_
 #include "hal_common.h"
+#include "mp3_decoder.h"
 
-extern void MP3_libmad_PlaySong(char *Path, char *Name);
+/*
+ * Economy decoding for small speakers and battery units: libmad synthesizes at
+ * half the stream's sample rate (MAD_OPTION_HALFSAMPLERATE) and I2S is set up
+ * for that rate, about half the synthesis cycles for a quarter-rate bandwidth.
+ * MP3_Economy_Auto turns it on for the next song after one whose CPU load went
+ * over MP3_ECONOMY_ON_PERMILLE, and off again after one under OFF_PERMILLE.
+ * Economy songs always use libmad, helix has no half rate synthesis.
+ */
+#ifndef MP3_ECONOMY_DEFAULT
+#define MP3_ECONOMY_DEFAULT         MP3_Economy_Off
+#endif
+#define MP3_ECONOMY_ON_PERMILLE     800u
+#define MP3_ECONOMY_OFF_PERMILLE    400u
+
+typedef enum
+{
+    MP3_Economy_Off = 0u,
+    MP3_Economy_On,
+    MP3_Economy_Auto,
+} MP3_Economy_Type;
+
+extern MP3_Decoder_Backend_Type MP3_Backend;
+extern MP3_Economy_Type         MP3_Economy;
+
+extern void MP3_PlaySong(char *Path, char *Name);
 #endif
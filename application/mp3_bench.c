@@ -0,0 +1,346 @@
+/* Includes ------------------------------------------------------------------*/
+#include "mp3_bench.h"
+#include "board_it.h"
+#if defined(MAD_PROFILE)
+#include "synth.h"
+#endif
+
+static __ALIGNED(4) uint16_t MP3_Bench_oBuffer[2 * MP3_DECODER_FRAME_MAX];
+
+/* stage counters filled in by libmad when it is built with MAD_PROFILE. */
+unsigned long long mad_prof_ticks[MAD_PROF_NSTAGES];
+
+/* rows per file, libmad once more at half rate. */
+static const struct
+{
+    MP3_Decoder_Backend_Type Backend;
+    bool                     HalfRate;
+} MP3_Bench_Rows[] =
+{
+    { MP3_Decoder_Libmad, false },
+    { MP3_Decoder_Libmad, true  },
+    { MP3_Decoder_Helix,  false },
+};
+
+static const char *MP3_Bench_StageName[MP3_BENCH_STAGE_NUM] =
+{
+    "header", "sideinfo", "huffman", "stereo", "imdct", "synth"
+};
+
+#if defined(MAD_PROFILE)
+#define MP3_BENCH_DCT32_VECTORS 16u
+#define MP3_BENCH_DCT32_PASSES  16u
+#endif
+
+
+/*******************************************************************************
+ * @brief       libmad profiling clock.
+ * @param       None
+ * @retval      free-running tick count.
+ * @attention   
+*******************************************************************************/
+mad_prof_clock_t mad_prof_clock(void)
+{
+    return GetCycleCount();
+}
+
+
+/*******************************************************************************
+ * @brief       CRC-32 (IEEE 802.3) of the 16-bit output.
+ * @param       
+ * @retval      
+ * @attention   
+*******************************************************************************/
+static uint32_t MP3_Bench_Crc32(uint32_t Crc, const uint16_t *Pcm, uint32_t Length, uint32_t Channels)
+{
+    static const uint32_t Table[16] =
+    {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+    };
+
+    /* interleaved stereo, mono streams only count the first of each pair. */
+    for(uint32_t i = 0; i < Length; i++)
+    {
+        for(uint32_t ch = 0; ch < Channels; ch++)
+        {
+            uint16_t Sample = Pcm[2 * i + ch];
+            uint8_t  Byte[2] = { (uint8_t)Sample, (uint8_t)(Sample >> 8) };
+
+            for(uint32_t b = 0; b < 2; b++)
+            {
+                Crc ^= Byte[b];
+                Crc  = (Crc >> 4) ^ Table[Crc & 0x0F];
+                Crc  = (Crc >> 4) ^ Table[Crc & 0x0F];
+            }
+        }
+    }
+
+    return Crc;
+}
+
+
+#if defined(MAD_PROFILE)
+/*******************************************************************************
+ * @brief       Times libmad's dct32() on its own, every vector into every slot.
+ * @param       None
+ * @retval      None
+ * @attention   Prints "# dct32 ticks_call=<n> crc32=<crc>". The inputs are the
+ *              same in every build, so the crc32 only changes with the kernel.
+*******************************************************************************/
+static void MP3_Bench_Dct32(void)
+{
+    static mad_fixed_t In[MP3_BENCH_DCT32_VECTORS][32];
+    static mad_fixed_t Lo[16][8], Hi[16][8];
+    mad_prof_clock_t   Start, Ticks, Best = 0xFFFFFFFF;
+    uint32_t Seed = 1, Crc = 0xFFFFFFFF;
+
+    /* subband samples up to +-4.0, more than a loud frame reaches. */
+    for(uint32_t v = 0; v < MP3_BENCH_DCT32_VECTORS; v++)
+    {
+        for(uint32_t i = 0; i < 32; i++)
+        {
+            Seed = Seed * 1664525u + 1013904223u;
+            In[v][i] = (mad_fixed_t)Seed >> 1;
+        }
+    }
+
+    for(uint32_t v = 0; v < MP3_BENCH_DCT32_VECTORS; v++)
+    {
+        for(uint32_t Slot = 0; Slot < 8; Slot++)
+        {
+            mad_synth_dct32(In[v], Slot, Lo, Hi);
+        }
+        Crc = MP3_Bench_Crc32(Crc, (const uint16_t *)Lo, sizeof(Lo) / 4, 2);
+        Crc = MP3_Bench_Crc32(Crc, (const uint16_t *)Hi, sizeof(Hi) / 4, 2);
+    }
+
+    for(uint32_t Pass = 0; Pass < MP3_BENCH_DCT32_PASSES; Pass++)
+    {
+        Start = mad_prof_clock();
+        for(uint32_t v = 0; v < MP3_BENCH_DCT32_VECTORS; v++)
+        {
+            for(uint32_t Slot = 0; Slot < 8; Slot++)
+            {
+                mad_synth_dct32(In[v], Slot, Lo, Hi);
+            }
+        }
+        Ticks = (mad_prof_clock_t)(mad_prof_clock() - Start);
+        Best  = (Ticks < Best) ? Ticks : Best;
+    }
+
+    printf("# dct32 ticks_call=%lu crc32=%08lx\r\n", (unsigned long)(Best / (MP3_BENCH_DCT32_VECTORS * 8)),
+           (unsigned long)(Crc ^ 0xFFFFFFFF));
+}
+#endif
+
+
+/*******************************************************************************
+ * @brief       Decodes one file and accumulates the per stage cost.
+ * @param       Path     : file to decode.
+ *              Backend  : decoder to use.
+ *              HalfRate : synthesis at half the sample rate.
+ *              Result   : filled in, zeroed first.
+ * @retval      0 on success, -1 when the file cannot be opened or the decoder
+ *              is not built in or has no half rate synthesis.
+ * @attention   Input goes through the same front end as the player; file reads
+ *              are taken out of the timed region.
+*******************************************************************************/
+int MP3_Bench_File(const char *Path, MP3_Decoder_Backend_Type Backend, bool HalfRate, MP3_Bench_Result_Type *Result)
+{
+    const MP3_Decoder_Info_Type *Info = MP3_Decoder_GetInfo();
+    uint64_t Decode = 0;
+
+    memset(Result, 0, sizeof(MP3_Bench_Result_Type));
+    memset(mad_prof_ticks, 0, sizeof(mad_prof_ticks));
+
+    if(MP3_Decoder_Open(Path, Backend) != 0)
+    {
+        return -1;
+    }
+
+    if(HalfRate && (MP3_Decoder_SetHalfRate(true) != 0))
+    {
+        MP3_Decoder_Close();
+        return -1;
+    }
+
+    Result->Backend  = Info->Backend;
+    Result->HalfRate = HalfRate;
+    Result->Crc32    = 0xFFFFFFFF;
+
+    while(1)
+    {
+        mad_prof_clock_t Start;
+        uint32_t         Count;
+
+        /* room for a whole frame, so every call hands out exactly one. */
+        Start  = mad_prof_clock();
+        Count  = MP3_Decoder_DecodeFrame(MP3_Bench_oBuffer, MP3_DECODER_FRAME_MAX);
+        Decode += (mad_prof_clock_t)(mad_prof_clock() - Start);
+
+        if(Count == 0)
+        {
+            break;
+        }
+
+        if(Info->Frames == 1)
+        {
+            Result->SampleRate = Info->SampleRate;
+            Result->Samples    = Info->Samples;
+            Result->Channels   = Info->Channels;
+            Result->Mode       = Info->Mode;
+            Result->MinBitrate = Info->Bitrate;
+            Result->MaxBitrate = Info->Bitrate;
+        }
+
+        Result->SumBitrate += Info->Bitrate;
+
+        if(Info->Bitrate < Result->MinBitrate) Result->MinBitrate = Info->Bitrate;
+        if(Info->Bitrate > Result->MaxBitrate) Result->MaxBitrate = Info->Bitrate;
+
+        Result->Crc32 = MP3_Bench_Crc32(Result->Crc32, MP3_Bench_oBuffer, Count, Info->Channels);
+    }
+
+    Result->Crc32 ^= 0xFFFFFFFF;
+
+    Result->Frames = Info->Frames;
+    Result->Errors = Info->Errors;
+    Result->Output = Info->OutputTicks;
+    Result->Total  = (Decode > Info->ReadTicks) ? (Decode - Info->ReadTicks) : 0;
+
+    for(uint32_t i = 0; (i < MP3_BENCH_STAGE_NUM) && (Result->Backend == MP3_Decoder_Libmad); i++)
+    {
+        Result->Ticks[i] = mad_prof_ticks[i];
+    }
+
+    MP3_Decoder_Close();
+
+    return 0;
+}
+
+
+/*******************************************************************************
+ * @brief       Prints the clock line and the column names.
+ * @param       None
+ * @retval      None
+ * @attention   
+*******************************************************************************/
+void MP3_Bench_PrintHeader(void)
+{
+#if defined(MAD_PROFILE)
+    const int Profile = 1;
+#else
+    const int Profile = 0;
+#endif
+
+    printf("# mp3bench tick_hz=%lu profile=%d\r\n", (unsigned long)GetCycleCountFreq(), Profile);
+    printf("file\tdec\trate\tch\tmode\tkbps\tvbr\tframes\terrors");
+
+    for(uint32_t i = 0; i < MP3_BENCH_STAGE_NUM; i++)
+    {
+        printf("\t%s", MP3_Bench_StageName[i]);
+    }
+
+    printf("\toutput\tother\ttotal\tus_frame\tfps\tload_pct\tcrc32\r\n");
+}
+
+
+/*******************************************************************************
+ * @brief       Prints one table row, stage columns in ticks per frame.
+ * @param       
+ * @retval      
+ * @attention   load_pct is decode time over play time of the same frames.
+*******************************************************************************/
+void MP3_Bench_PrintResult(const char *Name, const MP3_Bench_Result_Type *Result)
+{
+    static const char *ModeName[4] = { "mono", "dual", "joint", "stereo" };
+    uint32_t Frames = (Result->Frames != 0) ? Result->Frames : 1;
+    uint64_t Staged = Result->Output;
+    double   Hz     = (double)GetCycleCountFreq();
+    double   Us     = (double)Result->Total * 1e6 / Hz / Frames;
+    double   Play   = (Result->SampleRate != 0) ? (Result->Samples * 1e6 / Result->SampleRate) : 0.0;
+
+    printf("%s\t%s%s\t%lu\t%lu\t%s\t%lu\t%d\t%lu\t%lu", Name, MP3_Decoder_GetName(Result->Backend), Result->HalfRate ? "/2" : "",
+           (unsigned long)Result->SampleRate, (unsigned long)Result->Channels, ModeName[Result->Mode & 3],
+           (unsigned long)(Result->SumBitrate / Frames / 1000), (Result->MinBitrate != Result->MaxBitrate),
+           (unsigned long)Result->Frames, (unsigned long)Result->Errors);
+
+    for(uint32_t i = 0; i < MP3_BENCH_STAGE_NUM; i++)
+    {
+        Staged += Result->Ticks[i];
+        printf("\t%lu", (unsigned long)(Result->Ticks[i] / Frames));
+    }
+
+    printf("\t%lu\t%lu\t%lu\t%.1f\t%.1f\t%.1f\t%08lx\r\n",
+           (unsigned long)(Result->Output / Frames),
+           (unsigned long)((Result->Total > Staged) ? ((Result->Total - Staged) / Frames) : 0),
+           (unsigned long)(Result->Total / Frames), Us, (Us > 0.0) ? (1e6 / Us) : 0.0,
+           (Play > 0.0) ? (Us * 100.0 / Play) : 0.0, (unsigned long)Result->Crc32);
+}
+
+
+/*******************************************************************************
+ * @brief       Benchmarks every .MP3 file in a folder with every built-in decoder,
+ *              libmad also at half rate.
+ * @param       Path   : folder, e.g. AUDIO_MUSIC_PATH.
+ *              Passes : decodes per file and decoder, the fastest one is reported.
+ * @retval      number of rows printed.
+ * @attention   One pass is enough on the board, the cycle count is stable;
+ *              the host needs a few to filter out scheduling noise.
+*******************************************************************************/
+uint32_t MP3_Bench_Run(const char *Path, uint32_t Passes)
+{
+    static DIR                   Dir;
+    static FILINFO               Info;
+    static char                  FilePath[100];
+    static MP3_Bench_Result_Type Result, Best;
+    uint32_t Count = 0;
+
+    if(f_opendir(&Dir, Path) != FR_OK)
+    {
+        printf("\r\nf_opendir(%s) Fail!\r\n", Path);
+        return 0;
+    }
+
+    MP3_Bench_PrintHeader();
+#if defined(MAD_PROFILE)
+    MP3_Bench_Dct32();
+#endif
+
+    while((f_readdir(&Dir, &Info) == FR_OK) && (Info.fname[0] != 0))
+    {
+        if((Info.fattrib & AM_DIR) || ((strstr(Info.fname, ".MP3") == NULL) && (strstr(Info.fname, ".mp3") == NULL)))
+        {
+            continue;
+        }
+
+        sprintf(FilePath, "%s/%s", Path, Info.fname);
+
+        for(uint32_t Row = 0; Row < (sizeof(MP3_Bench_Rows) / sizeof(MP3_Bench_Rows[0])); Row++)
+        {
+            MP3_Decoder_Backend_Type Backend  = MP3_Bench_Rows[Row].Backend;
+            bool                     HalfRate = MP3_Bench_Rows[Row].HalfRate;
+
+            if(MP3_Bench_File(FilePath, Backend, HalfRate, &Best) != 0)
+            {
+                continue;
+            }
+
+            for(uint32_t i = 1; i < Passes; i++)
+            {
+                if((MP3_Bench_File(FilePath, Backend, HalfRate, &Result) == 0) && (Result.Total < Best.Total))
+                {
+                    Best = Result;
+                }
+            }
+
+            MP3_Bench_PrintResult(Info.fname, &Best);
+            Count++;
+        }
+    }
+
+    f_closedir(&Dir);
+
+    return Count;
+}
@@ -0,0 +1,45 @@
+#ifndef __MP3_BENCH_H_
+#define __MP3_BENCH_H_
+#include "hal_common.h"
+#include "prof.h"
+#include "mp3_decoder.h"
+
+/*
+ * MP3 decoder benchmark: decodes every .MP3 in a folder through MP3_Decoder_DecodeFrame()
+ * only (no I2S), once per built-in decoder, and prints one tab separated row per file
+ * and decoder with the cost of each stage in clock ticks per frame.
+ * The clock is the DWT cycle counter on the board and nanoseconds on the host,
+ * see the "# mp3bench" line ahead of the table. Per stage figures need libmad built with MAD_PROFILE,
+ * and are only filled in for libmad rows, helix rows only have "output" and "total".
+ * The crc32 column covers the 16-bit PCM, so a changed output shows up as well as a slower one.
+ * libmad runs a second time with half rate synthesis, as "libmad/2", for the economy mode.
+ * With MAD_PROFILE a "# dct32" line after the column names times the synthesis DCT kernel alone.
+ */
+
+#define MP3_BENCH_STAGE_NUM     MAD_PROF_NSTAGES
+
+typedef struct
+{
+    MP3_Decoder_Backend_Type Backend;
+    bool     HalfRate;
+    uint32_t Frames;
+    uint32_t Errors;                        /* recoverable frame errors. */
+    uint32_t SampleRate;
+    uint32_t Samples;                       /* per channel and frame. */
+    uint32_t Channels;
+    uint32_t Mode;                          /* MP3_Decoder_Info_Type.Mode of the first frame. */
+    uint32_t MinBitrate;                    /* bit/s. */
+    uint32_t MaxBitrate;
+    uint64_t SumBitrate;
+    uint64_t Ticks[MP3_BENCH_STAGE_NUM];    /* per stage, all frames. */
+    uint64_t Output;                        /* conversion to 16-bit PCM. */
+    uint64_t Total;                         /* MP3_Decoder_DecodeFrame() without the file reads. */
+    uint32_t Crc32;
+} MP3_Bench_Result_Type;
+
+extern int      MP3_Bench_File(const char *Path, MP3_Decoder_Backend_Type Backend, bool HalfRate, MP3_Bench_Result_Type *Result);
+extern void     MP3_Bench_PrintHeader(void);
+extern void     MP3_Bench_PrintResult(const char *Name, const MP3_Bench_Result_Type *Result);
+extern uint32_t MP3_Bench_Run(const char *Path, uint32_t Passes);
+
+#endif
@@ -0,0 +1,394 @@
+/* Includes ------------------------------------------------------------------*/
+#include "mp3_decoder.h"
+#include "board_it.h"
+#include "audio_file.h"
+
+#define MP3_DECODER_GUARD           8u              /* libmad's MAD_BUFFER_GUARD. */
+
+typedef struct
+{
+    const MP3_Decoder_Ops_Type *Ops;                /* NULL while no stream is open. */
+    AUDIO_File_Type File;
+    const uint8_t  *Data;                           /* next undecoded byte in the input buffer. */
+    uint32_t        Length;                         /* bytes from Data to the end of the input. */
+    uint32_t        DataStart;                      /* file offset of the first frame, behind the ID3v2 tag. */
+    uint32_t        Pending;                        /* samples of the current frame not handed out yet. */
+    uint32_t        Position;                       /* the first of them. */
+    uint8_t         EndOfFile;
+    uint8_t         HalfRate;                       /* MP3_Decoder_SetHalfRate(), kept over a seek. */
+} MP3_Decoder_Type;
+
+/* seam area, ring, and room for the guard behind the last sector. */
+static __ALIGNED(4) uint8_t     MP3_Decoder_Input[MP3_DECODER_I_SEAM_SIZE + MP3_DECODER_I_BUFFER_SIZE + MP3_DECODER_GUARD];
+static MP3_Decoder_Type         MP3_Decoder;
+static MP3_Decoder_Info_Type    MP3_Decoder_Info;
+
+static const MP3_Decoder_Ops_Type *const MP3_Decoder_Backends[MP3_Decoder_Num] =
+{
+    NULL,
+#if MP3_DECODER_LIBMAD_ENABLE
+    &MP3_Decoder_LibmadOps,
+#else
+    NULL,
+#endif
+#if MP3_DECODER_HELIX_ENABLE
+    &MP3_Decoder_HelixOps,
+#else
+    NULL,
+#endif
+};
+
+static const char *MP3_Decoder_Names[MP3_Decoder_Num] =
+{
+    "auto", "libmad", "helix"
+};
+
+
+/*******************************************************************************
+ * @brief       Reads the next sectors of the file into the ring.
+ * @param       None
+ * @retval      None
+ * @attention   The ring is filled to its end in one read. Once the decoder has
+ *              reached the end, what is left there, at most a frame, moves to
+ *              the seam area and the ring is read again from the start. At the
+ *              end of the file the last frame gets MP3_DECODER_GUARD zero bytes
+ *              behind it, libmad does not decode it otherwise.
+*******************************************************************************/
+static void MP3_Decoder_Refill(void)
+{
+    uint32_t Remaining = MP3_Decoder.Length;
+    uint32_t Fill      = (uint32_t)(MP3_Decoder.Data - MP3_Decoder_Input) + Remaining;
+    uint32_t End       = MP3_DECODER_I_SEAM_SIZE + MP3_DECODER_I_BUFFER_SIZE;
+    uint32_t Start;
+    UINT     BR;
+
+    if(Fill == End)
+    {
+        /* no frame is longer: drop the oldest bytes, the decoder resyncs behind them. */
+        if(Remaining > MP3_DECODER_I_SEAM_SIZE)
+        {
+            Remaining = MP3_DECODER_I_SEAM_SIZE;
+        }
+
+        memcpy(&MP3_Decoder_Input[MP3_DECODER_I_SEAM_SIZE - Remaining], &MP3_Decoder_Input[End - Remaining], Remaining);
+        Fill = MP3_DECODER_I_SEAM_SIZE;
+    }
+
+    Start = GetCycleCount();
+    if(AUDIO_File_Read(&MP3_Decoder.File, &MP3_Decoder_Input[Fill], End - Fill, &BR) != FR_OK)
+    {
+        BR = 0;
+    }
+    MP3_Decoder_Info.ReadTicks += GetCycleCount() - Start;
+
+    if(BR < (End - Fill))
+    {
+        MP3_Decoder.EndOfFile = 1;
+        memset(&MP3_Decoder_Input[Fill + BR], 0, MP3_DECODER_GUARD);
+        BR += MP3_DECODER_GUARD;
+    }
+
+    MP3_Decoder.Data   = &MP3_Decoder_Input[Fill - Remaining];
+    MP3_Decoder.Length = Remaining + BR;
+}
+
+
+/*******************************************************************************
+ * @brief       Reads the file again from Offset on.
+ * @param       Offset : of the next byte for the decoder.
+ * @retval      FR_OK or the seek error.
+ * @attention   Reading starts at the sector Offset is in, the bytes before it
+ *              are read into the ring and skipped.
+*******************************************************************************/
+static FRESULT MP3_Decoder_Restart(FSIZE_t Offset)
+{
+    uint32_t Skip = (uint32_t)(Offset % MP3_DECODER_I_SECTOR);
+    FRESULT  Result;
+
+    Result = AUDIO_File_Seek(&MP3_Decoder.File, Offset - Skip);
+    if(Result != FR_OK)
+    {
+        return Result;
+    }
+
+    MP3_Decoder.Data      = &MP3_Decoder_Input[MP3_DECODER_I_SEAM_SIZE];
+    MP3_Decoder.Length    = 0;
+    MP3_Decoder.EndOfFile = 0;
+    MP3_Decoder_Refill();
+
+    if(Skip > MP3_Decoder.Length)
+    {
+        Skip = MP3_Decoder.Length;
+    }
+    MP3_Decoder.Data   += Skip;
+    MP3_Decoder.Length -= Skip;
+
+    return FR_OK;
+}
+
+
+/*******************************************************************************
+ * @brief       Picks the backend for MP3_Decoder_Auto from the first frame header.
+ * @param       None
+ * @retval      a backend that is built in.
+ * @attention   helix for Layer III, it is cheaper than libmad at every bitrate
+ *              of the mp3bench corpus (64 to 320 kbit/s, mono and stereo), so
+ *              there is no bitrate to switch at. helix only decodes Layer III,
+ *              libmad takes Layer I and II.
+*******************************************************************************/
+static MP3_Decoder_Backend_Type MP3_Decoder_Choose(void)
+{
+    if(MP3_Decoder_Backends[MP3_Decoder_Libmad] == NULL) return MP3_Decoder_Helix;
+    if(MP3_Decoder_Backends[MP3_Decoder_Helix]  == NULL) return MP3_Decoder_Libmad;
+
+    for(uint32_t i = 0; (i + 4) <= MP3_Decoder.Length; i++)
+    {
+        const uint8_t *Header  = &MP3_Decoder.Data[i];
+        uint32_t       Version = (Header[1] >> 3) & 0x03;   /* 3 MPEG-1, 2 MPEG-2, 0 MPEG-2.5. */
+        uint32_t       Layer   = 4 - ((Header[1] >> 1) & 0x03);
+        uint32_t       Index   = Header[2] >> 4;
+
+        if((Header[0] != 0xFF) || ((Header[1] & 0xE0) != 0xE0) ||
+           (Version == 1) || (Layer == 4) || (Index == 15) || (((Header[2] >> 2) & 0x03) == 3))
+        {
+            continue;
+        }
+
+        if(Layer == 3)
+        {
+            return MP3_Decoder_Helix;
+        }
+        break;
+    }
+
+    return MP3_Decoder_Libmad;
+}
+
+
+/*******************************************************************************
+ * @brief       Opens a file for decoding.
+ * @param       Path    : the .mp3 file.
+ *              Backend : decoder to use, MP3_Decoder_Auto to pick one per file.
+ * @retval      0 on success, -1 when the file cannot be opened or the requested
+ *              decoder is not built in.
+ * @attention   Closes the stream that was open before.
+*******************************************************************************/
+int MP3_Decoder_Open(const char *Path, MP3_Decoder_Backend_Type Backend)
+{
+    UINT BR;
+
+    MP3_Decoder_Close();
+
+    if((Backend >= MP3_Decoder_Num) || ((Backend != MP3_Decoder_Auto) && (MP3_Decoder_Backends[Backend] == NULL)))
+    {
+        return -1;
+    }
+
+    memset(&MP3_Decoder,      0, sizeof(MP3_Decoder));
+    memset(&MP3_Decoder_Info, 0, sizeof(MP3_Decoder_Info));
+
+    if(AUDIO_File_Open(&MP3_Decoder.File, Path) != FR_OK)
+    {
+        return -1;
+    }
+
+    /* ID3v2 tag: 10 byte header with a syncsafe size that does not include it. */
+    if((AUDIO_File_Read(&MP3_Decoder.File, MP3_Decoder_Input, 10, &BR) == FR_OK) && (BR == 10) &&
+       (strncmp("ID3", (char *)MP3_Decoder_Input, 3) == 0))
+    {
+        MP3_Decoder.DataStart = ((uint32_t)MP3_Decoder_Input[6] << 21) | ((uint32_t)MP3_Decoder_Input[7] << 14) |
+                                ((uint32_t)MP3_Decoder_Input[8] << 7)  | ((uint32_t)MP3_Decoder_Input[9] << 0);
+        MP3_Decoder.DataStart += 10;
+    }
+
+    if(MP3_Decoder_Restart(MP3_Decoder.DataStart) != FR_OK)
+    {
+        AUDIO_File_Close(&MP3_Decoder.File);
+        return -1;
+    }
+
+    if(Backend == MP3_Decoder_Auto)
+    {
+        Backend = MP3_Decoder_Choose();
+    }
+
+    MP3_Decoder.Ops          = MP3_Decoder_Backends[Backend];
+    MP3_Decoder_Info.Backend = Backend;
+    MP3_Decoder.Ops->Open();
+
+    return 0;
+}
+
+
+/*******************************************************************************
+ * @brief       Hands out the next PCM samples.
+ * @param       Output   : 4-byte aligned, interleaved 16-bit stereo.
+ *              Capacity : room in Output, in samples per channel.
+ * @retval      samples per channel written, 0 at the end of the stream.
+ * @attention   A frame that does not fit Capacity is handed out over several
+ *              calls. With room for a whole frame, helix decodes straight into
+ *              Output and libmad converts straight into it.
+*******************************************************************************/
+uint32_t MP3_Decoder_DecodeFrame(uint16_t *Output, uint32_t Capacity)
+{
+    uint32_t Count, Start;
+    int      Status;
+
+    if((MP3_Decoder.Ops == NULL) || (Capacity == 0))
+    {
+        return 0;
+    }
+
+    while(MP3_Decoder.Pending == 0)
+    {
+        Status = MP3_Decoder.Ops->Decode(&MP3_Decoder.Data, &MP3_Decoder.Length, Output, Capacity, &MP3_Decoder_Info);
+
+        if(Status == MP3_DECODER_UNDERFLOW)
+        {
+            if(MP3_Decoder.EndOfFile == 1)
+            {
+                return 0;
+            }
+
+            MP3_Decoder_Refill();
+        }
+        else if(Status == MP3_DECODER_SKIP)
+        {
+            MP3_Decoder_Info.Errors++;
+        }
+        else if(Status == MP3_DECODER_RESYNC)
+        {
+            continue;
+        }
+        else if(Status == MP3_DECODER_FATAL)
+        {
+            return 0;
+        }
+        else if(Status == MP3_DECODER_OK)
+        {
+            MP3_Decoder_Info.Frames++;
+            MP3_Decoder.Pending  = MP3_Decoder_Info.Samples;
+            MP3_Decoder.Position = 0;
+        }
+        else if(Status == MP3_DECODER_DIRECT)
+        {
+            MP3_Decoder_Info.Frames++;
+            return MP3_Decoder_Info.Samples;
+        }
+    }
+
+    Count = (MP3_Decoder.Pending < Capacity) ? MP3_Decoder.Pending : Capacity;
+
+    Start = GetCycleCount();
+    MP3_Decoder.Ops->Convert(Output, MP3_Decoder.Position, Count);
+    MP3_Decoder_Info.OutputTicks += GetCycleCount() - Start;
+
+    MP3_Decoder.Position += Count;
+    MP3_Decoder.Pending  -= Count;
+
+    return Count;
+}
+
+
+/*******************************************************************************
+ * @brief       Stream and decoder statistics, updated by every call.
+ * @param       None
+ * @retval
+ * @attention
+*******************************************************************************/
+const MP3_Decoder_Info_Type *MP3_Decoder_GetInfo(void)
+{
+    return &MP3_Decoder_Info;
+}
+
+
+/*******************************************************************************
+ * @brief       Continues decoding at about TimeMs into the stream.
+ * @param       TimeMs : from the first frame.
+ * @retval      0 on success, -1 before the first frame or on a file error.
+ * @attention   The file offset is estimated from the last frame's bitrate,
+ *              exact for CBR only. The decoder restarts with empty state, so
+ *              the first frames behind the new position may be skipped until
+ *              the bit reservoir has refilled.
+*******************************************************************************/
+int MP3_Decoder_Seek(uint32_t TimeMs)
+{
+    uint64_t Offset;
+
+    if((MP3_Decoder.Ops == NULL) || (MP3_Decoder_Info.Bitrate == 0))
+    {
+        return -1;
+    }
+
+    Offset = MP3_Decoder.DataStart + (uint64_t)TimeMs * (MP3_Decoder_Info.Bitrate / 8u) / 1000u;
+
+    if(MP3_Decoder_Restart((FSIZE_t)Offset) != FR_OK)
+    {
+        return -1;
+    }
+
+    MP3_Decoder.Ops->Close();
+    MP3_Decoder.Ops->Open();
+    if(MP3_Decoder.HalfRate == 1)
+    {
+        MP3_Decoder.Ops->SetHalfRate(true);
+    }
+
+    MP3_Decoder.Pending = 0;
+
+    return 0;
+}
+
+
+/*******************************************************************************
+ * @brief       Synthesizes the open stream at half its sample rate, or back at
+ *              the full rate.
+ * @param       Enable : half rate.
+ * @retval      0 on success, -1 with no stream open or a decoder that cannot.
+ * @attention   Call before the first frame: the rate changes with the next
+ *              frame decoded, Info->SampleRate and Info->Samples follow it.
+ *              Only libmad can, its filterbank then works out every other
+ *              output sample.
+*******************************************************************************/
+int MP3_Decoder_SetHalfRate(bool Enable)
+{
+    if((MP3_Decoder.Ops == NULL) || (MP3_Decoder.Ops->SetHalfRate == NULL))
+    {
+        return -1;
+    }
+
+    MP3_Decoder.Ops->SetHalfRate(Enable);
+    MP3_Decoder.HalfRate = Enable ? 1 : 0;
+
+    return 0;
+}
+
+
+/*******************************************************************************
+ * @brief       Closes the stream, MP3_Decoder_GetInfo() stays valid.
+ * @param       None
+ * @retval      None
+ * @attention
+*******************************************************************************/
+void MP3_Decoder_Close(void)
+{
+    if(MP3_Decoder.Ops != NULL)
+    {
+        MP3_Decoder.Ops->Close();
+        MP3_Decoder.Ops = NULL;
+
+        AUDIO_File_Close(&MP3_Decoder.File);
+    }
+}
+
+
+/*******************************************************************************
+ * @brief
+ * @param
+ * @retval      "auto", "libmad" or "helix".
+ * @attention
+*******************************************************************************/
+const char *MP3_Decoder_GetName(MP3_Decoder_Backend_Type Backend)
+{
+    return (Backend < MP3_Decoder_Num) ? MP3_Decoder_Names[Backend] : "?";
+}
@@ -0,0 +1,88 @@
+#ifndef __MP3_DECODER_H_
+#define __MP3_DECODER_H_
+#include "hal_common.h"
+
+/*
+ * MP3 decoder front end: one streaming API over the libmad and helix decoders.
+ * MP3_Decoder_Open() opens a file, skips its ID3v2 tag and picks a backend;
+ * MP3_Decoder_DecodeFrame() then hands out interleaved 16-bit stereo PCM frame
+ * by frame (mono is duplicated to both channels) until the stream ends.
+ *
+ * The file is read through one shared input buffer, each backend keeps its own
+ * static state, so one stream is open at a time. The buffer is a ring of whole
+ * sectors, read at sector boundaries of the file so that FatFs hands them
+ * straight to the card. When the ring is used up, the part of a frame left at
+ * its end is copied to the seam area in front of it and the ring is read again
+ * from the start, so the decoder always sees the current frame in one piece.
+ *
+ * Either backend can be left out of the build with MP3_DECODER_LIBMAD_ENABLE /
+ * MP3_DECODER_HELIX_ENABLE.
+ */
+
+#ifndef MP3_DECODER_LIBMAD_ENABLE
+#define MP3_DECODER_LIBMAD_ENABLE   1
+#endif
+
+#ifndef MP3_DECODER_HELIX_ENABLE
+#define MP3_DECODER_HELIX_ENABLE    1
+#endif
+
+#define MP3_DECODER_I_SECTOR        FF_MIN_SS
+#define MP3_DECODER_I_BUFFER_SIZE   (16u * MP3_DECODER_I_SECTOR)    /* the ring. */
+#define MP3_DECODER_I_SEAM_SIZE     (4u * MP3_DECODER_I_SECTOR)     /* the longest frame carried over the seam. */
+#define MP3_DECODER_FRAME_MAX       1152u           /* samples per channel in one frame. */
+
+/* backend Decode() results. */
+#define MP3_DECODER_OK              0               /* frame decoded, fetch it with Convert(). */
+#define MP3_DECODER_DIRECT          1               /* frame decoded straight into Output. */
+#define MP3_DECODER_UNDERFLOW       (-1)            /* the next frame is not in the input yet. */
+#define MP3_DECODER_SKIP            (-2)            /* bad or undecodable frame, input consumed. */
+#define MP3_DECODER_RESYNC          (-3)            /* no frame header here, input consumed. */
+#define MP3_DECODER_FATAL           (-4)
+
+typedef enum
+{
+    MP3_Decoder_Auto = 0u,          /* helix for Layer III, libmad for Layer I and II. */
+    MP3_Decoder_Libmad,
+    MP3_Decoder_Helix,
+    MP3_Decoder_Num,
+} MP3_Decoder_Backend_Type;
+
+typedef struct
+{
+    MP3_Decoder_Backend_Type Backend;
+    uint32_t SampleRate;
+    uint32_t Channels;              /* in the stream, the output is always stereo. */
+    uint32_t Layer;                 /* 1 to 3. */
+    uint32_t Mode;                  /* 0 mono, 1 dual channel, 2 joint stereo, 3 stereo. */
+    uint32_t Bitrate;               /* bit/s of the last frame. */
+    uint32_t Samples;               /* per channel in the last frame. */
+    uint32_t Frames;                /* decoded so far. */
+    uint32_t Errors;                /* frames skipped. */
+    uint64_t ReadTicks;             /* GetCycleCount() ticks spent in f_read(). */
+    uint64_t OutputTicks;           /* ticks spent in Convert(). */
+    uint64_t SynthTicks;            /* ticks spent in libmad's subband synthesis, helix does not tell. */
+} MP3_Decoder_Info_Type;
+
+/* Backend interface, one static instance per decoder library. */
+typedef struct
+{
+    void      (*Open)(void);
+    void      (*Close)(void);
+    int       (*Decode)(const uint8_t **Data, uint32_t *Length, uint16_t *Output, uint32_t Capacity, MP3_Decoder_Info_Type *Info);
+    void      (*Convert)(uint16_t *Output, uint32_t Offset, uint32_t Count);
+    void      (*SetHalfRate)(bool Enable);  /* NULL when the decoder cannot synthesize at half rate. */
+} MP3_Decoder_Ops_Type;
+
+extern const MP3_Decoder_Ops_Type MP3_Decoder_LibmadOps;
+extern const MP3_Decoder_Ops_Type MP3_Decoder_HelixOps;
+
+extern int                          MP3_Decoder_Open(const char *Path, MP3_Decoder_Backend_Type Backend);
+extern uint32_t                     MP3_Decoder_DecodeFrame(uint16_t *Output, uint32_t Capacity);
+extern const MP3_Decoder_Info_Type *MP3_Decoder_GetInfo(void);
+extern int                          MP3_Decoder_Seek(uint32_t TimeMs);
+extern int                          MP3_Decoder_SetHalfRate(bool Enable);
+extern void                         MP3_Decoder_Close(void);
+extern const char                  *MP3_Decoder_GetName(MP3_Decoder_Backend_Type Backend);
+
+#endif
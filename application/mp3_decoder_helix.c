@@ -0,0 +1,137 @@
+/* Includes ------------------------------------------------------------------*/
+#include "mp3_decoder.h"
+#include "mp3dec.h"
+#include "coder.h"
+
+#if MP3_DECODER_HELIX_ENABLE
+
+static HMP3Decoder          MP3_Helix_Handle;
+static __ALIGNED(4) int16_t MP3_Helix_Frame[2 * MP3_DECODER_FRAME_MAX];    /* frames that do not fit the caller's buffer. */
+
+
+static void MP3_Helix_Open(void)
+{
+    MP3_Helix_Handle = MP3InitDecoder();
+}
+
+
+static void MP3_Helix_Close(void)
+{
+    MP3FreeDecoder(MP3_Helix_Handle);
+    MP3_Helix_Handle = NULL;
+}
+
+
+/* Spreads Count mono samples to both channels in place, back to front. */
+static void MP3_Helix_MonoToStereo(int16_t *Pcm, uint32_t Count)
+{
+    while(Count-- != 0)
+    {
+        Pcm[2 * Count + 1] = Pcm[Count];
+        Pcm[2 * Count + 0] = Pcm[Count];
+    }
+}
+
+
+/*******************************************************************************
+ * @brief       Decodes one Layer III frame to 16-bit PCM.
+ * @param
+ * @retval      MP3_DECODER_xxx
+ * @attention   helix writes the whole frame at once, into Output when it fits
+ *              and into MP3_Helix_Frame otherwise.
+*******************************************************************************/
+static int MP3_Helix_Decode(const uint8_t **Data, uint32_t *Length, uint16_t *Output, uint32_t Capacity, MP3_Decoder_Info_Type *Info)
+{
+    MP3FrameInfo   Frame;
+    unsigned char *Ptr;
+    int            Left, Offset, Error;
+    uint32_t       Samples;
+    int16_t       *Pcm;
+
+    Offset = MP3FindSyncWord((unsigned char *)*Data, (int)*Length);
+    if(Offset < 0)
+    {
+        /* keep the last byte, it may start a sync word. */
+        if(*Length > 1)
+        {
+            *Data  += *Length - 1;
+            *Length = 1;
+        }
+        return MP3_DECODER_UNDERFLOW;
+    }
+
+    *Data   += Offset;
+    *Length -= Offset;
+
+    if(*Length < 4)
+    {
+        return MP3_DECODER_UNDERFLOW;
+    }
+
+    if(MP3GetNextFrameInfo(MP3_Helix_Handle, &Frame, (unsigned char *)*Data) != ERR_MP3_NONE)
+    {
+        *Data   += 1;
+        *Length -= 1;
+        return MP3_DECODER_RESYNC;
+    }
+
+    Samples = Frame.outputSamps / Frame.nChans;
+    Pcm     = (Samples <= Capacity) ? (int16_t *)Output : MP3_Helix_Frame;
+
+    Ptr   = (unsigned char *)*Data;
+    Left  = (int)*Length;
+    Error = MP3Decode(MP3_Helix_Handle, &Ptr, &Left, Pcm, 0);
+
+    if(Error == ERR_MP3_INDATA_UNDERFLOW)
+    {
+        return MP3_DECODER_UNDERFLOW;
+    }
+    else if((Error == ERR_MP3_INVALID_FRAMEHEADER) || (Error == ERR_MP3_INVALID_SIDEINFO) || (Error == ERR_MP3_FREE_BITRATE_SYNC))
+    {
+        /* most likely a false sync word, look again from the next byte. */
+        *Data   += 1;
+        *Length -= 1;
+        return MP3_DECODER_SKIP;
+    }
+
+    /* the frame was read, also when its main data was not usable. */
+    *Data   = Ptr;
+    *Length = (uint32_t)Left;
+
+    if(Error != ERR_MP3_NONE)
+    {
+        return MP3_DECODER_SKIP;
+    }
+
+    if(Frame.nChans == 1)
+    {
+        MP3_Helix_MonoToStereo(Pcm, Samples);
+    }
+
+    Info->SampleRate = Frame.samprate;
+    Info->Channels   = Frame.nChans;
+    Info->Layer      = Frame.layer;
+    Info->Mode       = 3 - ((FrameHeader *)((MP3DecInfo *)MP3_Helix_Handle)->FrameHeaderPS)->sMode;
+    Info->Bitrate    = Frame.bitrate;
+    Info->Samples    = Samples;
+
+    return (Pcm == (int16_t *)Output) ? MP3_DECODER_DIRECT : MP3_DECODER_OK;
+}
+
+
+static void MP3_Helix_Convert(uint16_t *Output, uint32_t Offset, uint32_t Count)
+{
+    memcpy(Output, &MP3_Helix_Frame[2 * Offset], 2 * Count * sizeof(int16_t));
+}
+
+
+const MP3_Decoder_Ops_Type MP3_Decoder_HelixOps =
+{
+    MP3_Helix_Open,
+    MP3_Helix_Close,
+    MP3_Helix_Decode,
+    MP3_Helix_Convert,
+    NULL,
+};
+
+#endif
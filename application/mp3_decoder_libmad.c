@@ -0,0 +1,113 @@
+/* Includes ------------------------------------------------------------------*/
+#include "mp3_decoder.h"
+#include "mad.h"
+#include "pcm.h"
+#include "board_it.h"
+
+#if MP3_DECODER_LIBMAD_ENABLE
+
+static struct mad_stream MP3_Libmad_Stream;
+static struct mad_frame  MP3_Libmad_Frame;
+static struct mad_synth  MP3_Libmad_Synth;
+
+
+static void MP3_Libmad_Open(void)
+{
+    mad_stream_init(&MP3_Libmad_Stream);
+    mad_frame_init( &MP3_Libmad_Frame );
+    mad_synth_init( &MP3_Libmad_Synth );
+}
+
+
+static void MP3_Libmad_Close(void)
+{
+    mad_synth_finish( &MP3_Libmad_Synth );
+    mad_frame_finish( &MP3_Libmad_Frame );
+    mad_stream_finish(&MP3_Libmad_Stream);
+}
+
+
+/*******************************************************************************
+ * @brief       Decodes and synthesizes one frame, the PCM stays in the synth.
+ * @param
+ * @retval      MP3_DECODER_xxx
+ * @attention   The stream is only re-pointed when the front end has moved or
+ *              refilled its buffer, so libmad keeps its sync state otherwise.
+*******************************************************************************/
+static int MP3_Libmad_Decode(const uint8_t **Data, uint32_t *Length, uint16_t *Output, uint32_t Capacity, MP3_Decoder_Info_Type *Info)
+{
+    int      Status;
+    uint32_t Start;
+
+    (void)Output;
+    (void)Capacity;
+
+    if((MP3_Libmad_Stream.next_frame != *Data) || (MP3_Libmad_Stream.bufend != (*Data + *Length)))
+    {
+        mad_stream_buffer(&MP3_Libmad_Stream, *Data, *Length);
+    }
+
+    Status = mad_frame_decode(&MP3_Libmad_Frame, &MP3_Libmad_Stream);
+
+    /* libmad carries on from next_frame, also after an error. */
+    *Length -= (uint32_t)(MP3_Libmad_Stream.next_frame - *Data);
+    *Data    = MP3_Libmad_Stream.next_frame;
+
+    if(Status != 0)
+    {
+        if(MP3_Libmad_Stream.error == MAD_ERROR_BUFLEN)
+        {
+            return MP3_DECODER_UNDERFLOW;
+        }
+        else if(MP3_Libmad_Stream.error == MAD_ERROR_LOSTSYNC)
+        {
+            return MP3_DECODER_RESYNC;
+        }
+        else if(MAD_RECOVERABLE(MP3_Libmad_Stream.error))
+        {
+            return MP3_DECODER_SKIP;
+        }
+        return MP3_DECODER_FATAL;
+    }
+
+    Start = GetCycleCount();
+    mad_synth_frame(&MP3_Libmad_Synth, &MP3_Libmad_Frame);
+    Info->SynthTicks += GetCycleCount() - Start;
+
+    Info->SampleRate = MP3_Libmad_Synth.pcm.samplerate;
+    Info->Channels   = MP3_Libmad_Synth.pcm.channels;
+    Info->Layer      = MP3_Libmad_Frame.header.layer;
+    Info->Mode       = MP3_Libmad_Frame.header.mode;
+    Info->Bitrate    = MP3_Libmad_Frame.header.bitrate;
+    Info->Samples    = MP3_Libmad_Synth.pcm.length;
+
+    return MP3_DECODER_OK;
+}
+
+
+static void MP3_Libmad_Convert(uint16_t *Output, uint32_t Offset, uint32_t Count)
+{
+    const mad_fixed_t *Left  = &MP3_Libmad_Synth.pcm.samples[0][Offset];
+    const mad_fixed_t *Right = &MP3_Libmad_Synth.pcm.samples[(MP3_Libmad_Synth.pcm.channels == 2) ? 1 : 0][Offset];
+
+    PCM_MadFixedToS16(Output, Left, Right, Count);
+}
+
+
+/* From the next frame on, the pcm has half the samples at half the rate. */
+static void MP3_Libmad_SetHalfRate(bool Enable)
+{
+    mad_stream_options(&MP3_Libmad_Stream, Enable ? MAD_OPTION_HALFSAMPLERATE : 0);
+}
+
+
+const MP3_Decoder_Ops_Type MP3_Decoder_LibmadOps =
+{
+    MP3_Libmad_Open,
+    MP3_Libmad_Close,
+    MP3_Libmad_Decode,
+    MP3_Libmad_Convert,
+    MP3_Libmad_SetHalfRate,
+};
+
+#endif
@@ -0,0 +1,313 @@
+/* Includes ------------------------------------------------------------------*/
+#include "pcm.h"
+
+#define PCM_ROUND       (1L << (MAD_F_FRACBITS - 16))
+#define PCM_SHIFT       (MAD_F_FRACBITS + 1 - 16)
+
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+
+/* the rounding add saturates too, SSAT then clips and quantizes in one go. */
+#define PCM_SCALE(Sample)   __SSAT(__QADD((Sample), PCM_ROUND) >> PCM_SHIFT, 16)
+#define PCM_PACK(L, R)      __PKHBT((L), (R), 16)
+#define PCM_PACK_TOP(T, B)  __PKHTB((T), (B), 16)
+#define PCM_DITHER(Sample, Noise)   (__QADD((Sample), (Noise)) >> 16)
+
+#else
+
+static inline int32_t PCM_Scale(mad_fixed_t Sample)
+{
+    /* round */
+    Sample += PCM_ROUND;
+
+    /* clip */
+    if(Sample >= MAD_F_ONE)
+    {
+        Sample = MAD_F_ONE - 1;
+    }
+    else if(Sample < -MAD_F_ONE)
+    {
+        Sample = -MAD_F_ONE;
+    }
+
+    /* quantize */
+    return (Sample >> PCM_SHIFT);
+}
+
+/* left justified sample plus dither and rounding, saturated to 16 bits. */
+static inline int32_t PCM_Dither(int32_t Sample, int32_t Noise)
+{
+    int64_t Sum = (int64_t)Sample + Noise;
+
+    if(Sum > INT32_MAX)
+    {
+        Sum = INT32_MAX;
+    }
+    else if(Sum < INT32_MIN)
+    {
+        Sum = INT32_MIN;
+    }
+    return (int32_t)(Sum >> 16);
+}
+
+#define PCM_SCALE(Sample)   PCM_Scale(Sample)
+#define PCM_PACK(L, R)      (((uint32_t)(L) & 0x0000FFFFUL) | ((uint32_t)(R) << 16))
+#define PCM_PACK_TOP(T, B)  (((uint32_t)(T) & 0xFFFF0000UL) | ((uint32_t)(B) >> 16))
+#define PCM_DITHER(Sample, Noise)   PCM_Dither((Sample), (Noise))
+
+#endif
+
+
+/*******************************************************************************
+ * @brief       Converts Count samples per channel to interleaved 16-bit PCM.
+ * @param       Output : 4-byte aligned, 2 * Count halfwords.
+ *              Left   : first channel.
+ *              Right  : second channel, Left again for mono.
+ *              Count  : samples per channel.
+ * @retval      None
+ * @attention   Two stereo frames per pass, each stored as one 32-bit word.
+*******************************************************************************/
+void PCM_MadFixedToS16(uint16_t *Output, const mad_fixed_t *Left, const mad_fixed_t *Right, uint32_t Count)
+{
+    uint32_t *Word = (uint32_t *)Output;
+
+    for(; Count >= 2; Count -= 2)
+    {
+        int32_t L0 = PCM_SCALE(Left[0]);
+        int32_t R0 = PCM_SCALE(Right[0]);
+        int32_t L1 = PCM_SCALE(Left[1]);
+        int32_t R1 = PCM_SCALE(Right[1]);
+
+        Word[0] = PCM_PACK(L0, R0);
+        Word[1] = PCM_PACK(L1, R1);
+
+        Word  += 2;
+        Left  += 2;
+        Right += 2;
+    }
+
+    if(Count != 0)
+    {
+        Word[0] = PCM_PACK(PCM_SCALE(Left[0]), PCM_SCALE(Right[0]));
+    }
+}
+
+
+/* xorshift32, seeded once; dither only needs to be white, not reproducible. */
+static uint32_t PCM_DitherState = 0x9E3779B9UL;
+
+/* TPDF noise of +-1 output LSB, the difference of two uniform 16-bit values, plus half an LSB to round. */
+static inline int32_t PCM_Noise(void)
+{
+    uint32_t State = PCM_DitherState;
+
+    State ^= State << 13;
+    State ^= State >> 17;
+    State ^= State << 5;
+    PCM_DitherState = State;
+
+    return (int32_t)(State & 0xFFFFu) - (int32_t)(State >> 16) + 0x8000;
+}
+
+/* four left justified samples from three words of packed 24-bit input. */
+#define PCM_UNPACK24(W0, W1, W2, A, B, C, D)                                \
+    do {                                                                    \
+        (A) = (int32_t)((W0) << 8);                                         \
+        (B) = (int32_t)(((W1) << 16) | (((W0) >> 16) & 0x0000FF00UL));      \
+        (C) = (int32_t)(((W2) << 24) | (((W1) >>  8) & 0x00FFFF00UL));      \
+        (D) = (int32_t)((W2) & 0xFFFFFF00UL);                               \
+    } while(0)
+
+/* Dithers four left justified samples to 16 bits and stores them as 4 mono or 2 stereo frames. */
+static inline uint32_t *PCM_Put4(uint32_t *Word, int32_t A, int32_t B, int32_t C, int32_t D, uint32_t Mono)
+{
+    A = PCM_DITHER(A, PCM_Noise());
+    B = PCM_DITHER(B, PCM_Noise());
+    C = PCM_DITHER(C, PCM_Noise());
+    D = PCM_DITHER(D, PCM_Noise());
+
+    if(Mono != 0)
+    {
+        Word[0] = PCM_PACK(A, A);
+        Word[1] = PCM_PACK(B, B);
+        Word[2] = PCM_PACK(C, C);
+        Word[3] = PCM_PACK(D, D);
+        return Word + 4;
+    }
+
+    Word[0] = PCM_PACK(A, B);
+    Word[1] = PCM_PACK(C, D);
+    return Word + 2;
+}
+
+/* Dithers the last frame or two, fewer than four samples, each given left justified. */
+static void PCM_PutTail(uint32_t *Word, const int32_t *Sample, uint32_t Count, uint32_t Mono)
+{
+    uint32_t Index;
+
+    for(Index = 0; Index < Count; Index += (Mono != 0) ? 1u : 2u)
+    {
+        int32_t L = PCM_DITHER(Sample[Index], PCM_Noise());
+        int32_t R = (Mono != 0) ? L : PCM_DITHER(Sample[Index + 1u], PCM_Noise());
+
+        *Word++ = PCM_PACK(L, R);
+    }
+}
+
+/* unsigned 8-bit: recentred, four samples per word, each byte lands in the top half of a halfword. */
+static void PCM_U8ToS16(uint32_t *Word, const uint8_t *Input, uint32_t Frames, uint32_t Mono)
+{
+    const uint32_t *In = (const uint32_t *)Input;
+    uint32_t Samples   = (Mono != 0) ? Frames : (2u * Frames);
+    uint32_t W, Even, Odd;
+    int32_t  S;
+
+    for(; Samples >= 4; Samples -= 4)
+    {
+        W    = *In++ ^ 0x80808080UL;
+        Even = (W & 0x00FF00FFUL) << 8;             /* samples 0 and 2. */
+        Odd  =  W & 0xFF00FF00UL;                   /* samples 1 and 3. */
+
+        if(Mono != 0)
+        {
+            Word[0] = PCM_PACK(Even, Even);
+            Word[1] = PCM_PACK(Odd, Odd);
+            Word[2] = PCM_PACK_TOP(Even, Even);
+            Word[3] = PCM_PACK_TOP(Odd, Odd);
+            Word   += 4;
+        }
+        else
+        {
+            Word[0] = PCM_PACK(Even, Odd);
+            Word[1] = PCM_PACK_TOP(Odd, Even);
+            Word   += 2;
+        }
+    }
+
+    for(Input = (const uint8_t *)In; Samples != 0; Samples -= (Mono != 0) ? 1u : 2u)
+    {
+        S = (int32_t)((uint32_t)(Input[0] ^ 0x80u) << 24) >> 16;
+
+        *Word++ = (Mono != 0) ? PCM_PACK(S, S) : PCM_PACK(S, (int32_t)((uint32_t)(Input[1] ^ 0x80u) << 24) >> 16);
+        Input  += (Mono != 0) ? 1u : 2u;
+    }
+}
+
+/* packed 24-bit: three words hold four samples. */
+static void PCM_S24ToS16(uint32_t *Word, const uint8_t *Input, uint32_t Frames, uint32_t Mono)
+{
+    const uint32_t *In = (const uint32_t *)Input;
+    uint32_t Samples   = (Mono != 0) ? Frames : (2u * Frames);
+    int32_t  A, B, C, D, Tail[3];
+    uint32_t Index;
+
+    for(; Samples >= 4; Samples -= 4)
+    {
+        PCM_UNPACK24(In[0], In[1], In[2], A, B, C, D);
+        Word = PCM_Put4(Word, A, B, C, D, Mono);
+        In  += 3;
+    }
+
+    for(Input = (const uint8_t *)In, Index = 0; Index < Samples; Index++, Input += 3)
+    {
+        Tail[Index] = (int32_t)(((uint32_t)Input[0] << 8) | ((uint32_t)Input[1] << 16) | ((uint32_t)Input[2] << 24));
+    }
+    PCM_PutTail(Word, Tail, Samples, Mono);
+}
+
+/* 32-bit: already left justified. */
+static void PCM_S32ToS16(uint32_t *Word, const uint8_t *Input, uint32_t Frames, uint32_t Mono)
+{
+    const int32_t *In = (const int32_t *)Input;
+    uint32_t Samples  = (Mono != 0) ? Frames : (2u * Frames);
+
+    for(; Samples >= 4; Samples -= 4)
+    {
+        Word = PCM_Put4(Word, In[0], In[1], In[2], In[3], Mono);
+        In  += 4;
+    }
+    PCM_PutTail(Word, In, Samples, Mono);
+}
+
+static void PCM_U8MonoToS16(uint16_t *Output, const uint8_t *Input, uint32_t Frames)
+{
+    PCM_U8ToS16((uint32_t *)Output, Input, Frames, 1);
+}
+
+static void PCM_U8StereoToS16(uint16_t *Output, const uint8_t *Input, uint32_t Frames)
+{
+    PCM_U8ToS16((uint32_t *)Output, Input, Frames, 0);
+}
+
+/* 16-bit mono: each word holds two samples, each becomes a frame. */
+static void PCM_S16MonoToS16(uint16_t *Output, const uint8_t *Input, uint32_t Frames)
+{
+    const uint32_t *In = (const uint32_t *)Input;
+    uint32_t *Word     = (uint32_t *)Output;
+
+    for(; Frames >= 2; Frames -= 2)
+    {
+        uint32_t W = *In++;
+
+        Word[0] = PCM_PACK(W, W);
+        Word[1] = PCM_PACK_TOP(W, W);
+        Word   += 2;
+    }
+
+    if(Frames != 0)
+    {
+        uint32_t S = *(const uint16_t *)In;
+
+        Word[0] = PCM_PACK(S, S);
+    }
+}
+
+static void PCM_S16StereoToS16(uint16_t *Output, const uint8_t *Input, uint32_t Frames)
+{
+    memcpy(Output, Input, 4u * Frames);
+}
+
+static void PCM_S24MonoToS16(uint16_t *Output, const uint8_t *Input, uint32_t Frames)
+{
+    PCM_S24ToS16((uint32_t *)Output, Input, Frames, 1);
+}
+
+static void PCM_S24StereoToS16(uint16_t *Output, const uint8_t *Input, uint32_t Frames)
+{
+    PCM_S24ToS16((uint32_t *)Output, Input, Frames, 0);
+}
+
+static void PCM_S32MonoToS16(uint16_t *Output, const uint8_t *Input, uint32_t Frames)
+{
+    PCM_S32ToS16((uint32_t *)Output, Input, Frames, 1);
+}
+
+static void PCM_S32StereoToS16(uint16_t *Output, const uint8_t *Input, uint32_t Frames)
+{
+    PCM_S32ToS16((uint32_t *)Output, Input, Frames, 0);
+}
+
+
+/*******************************************************************************
+ * @brief       Picks the conversion of a WAV PCM format to 16-bit stereo.
+ * @param       BitsPerSample : 8, 16, 24 or 32.
+ *              Channels      : 1 or 2.
+ * @retval      NULL when the format is not supported.
+ * @attention   The converters take whole frames from a 4-byte aligned Input and
+ *              write Frames words to a 4-byte aligned Output.
+*******************************************************************************/
+PCM_Converter_Type PCM_GetConverter(uint16_t BitsPerSample, uint16_t Channels)
+{
+    static const PCM_Converter_Type Converters[4][2] =
+    {
+        {PCM_U8MonoToS16,  PCM_U8StereoToS16 },
+        {PCM_S16MonoToS16, PCM_S16StereoToS16},
+        {PCM_S24MonoToS16, PCM_S24StereoToS16},
+        {PCM_S32MonoToS16, PCM_S32StereoToS16},
+    };
+
+    if((Channels < 1) || (Channels > 2) || (BitsPerSample < 8) || (BitsPerSample > 32) || ((BitsPerSample % 8) != 0))
+    {
+        return NULL;
+    }
+    return Converters[BitsPerSample / 8 - 1][Channels - 1];
+}
@@ -0,0 +1,25 @@
+#ifndef __PCM_H_
+#define __PCM_H_
+#include "hal_common.h"
+#include "mad.h"
+
+/*
+ * Block conversion of libmad synthesis output to the I2S sample format: rounded,
+ * clipped, interleaved 16-bit stereo, written straight into an output ring slot.
+ * On cores with the DSP extension each sample is one QADD and one SSAT and each
+ * stereo pair one PKHBT and a word store; the C version gives the same result.
+ */
+
+/*
+ * WAV sample formats to the same 16-bit stereo: mono is duplicated, unsigned
+ * 8-bit recentred, 24 and 32-bit rounded with TPDF dither. The input is read a
+ * word at a time and two samples are handled per 32-bit operation where the
+ * format allows (SIMD within a register), so a 24-bit/96 kHz stream costs a
+ * few cycles per sample.
+ */
+typedef void (*PCM_Converter_Type)(uint16_t *Output, const uint8_t *Input, uint32_t Frames);
+
+extern void PCM_MadFixedToS16(uint16_t *Output, const mad_fixed_t *Left, const mad_fixed_t *Right, uint32_t Count);
+extern PCM_Converter_Type PCM_GetConverter(uint16_t BitsPerSample, uint16_t Channels);
+
+#endif
@@ -0,0 +1,235 @@
+/* Includes ------------------------------------------------------------------*/
+#include "resample.h"
+#include "hal_common.h"
+
+#define RESAMPLE_HALF           (RESAMPLE_TAPS / 2u)
+#define RESAMPLE_MU_SHIFT       (16u - RESAMPLE_PHASE_BITS)
+#define RESAMPLE_ROLLOFF        0.90                /* cutoff, of half the lower rate. */
+#define RESAMPLE_PI             3.14159265358979323846
+
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+
+/* two taps of both coefficient sets on both channels, four SMLALD. */
+#define RESAMPLE_MAC(L0, L1, R0, R1, Left, Right, C0, C1, Tap)                  \
+    do                                                                          \
+    {                                                                           \
+        uint32_t A = *(const uint32_t *)&(C0)[Tap];                             \
+        uint32_t B = *(const uint32_t *)&(C1)[Tap];                             \
+        uint32_t X = __UNALIGNED_UINT32_READ(&(Left)[Tap]);                     \
+        uint32_t Y = __UNALIGNED_UINT32_READ(&(Right)[Tap]);                    \
+        (L0) = (int64_t)__SMLALD(X, A, (uint64_t)(L0));                         \
+        (L1) = (int64_t)__SMLALD(X, B, (uint64_t)(L1));                         \
+        (R0) = (int64_t)__SMLALD(Y, A, (uint64_t)(R0));                         \
+        (R1) = (int64_t)__SMLALD(Y, B, (uint64_t)(R1));                         \
+    } while(0)
+
+#define RESAMPLE_CLIP(Sample)   __SSAT((Sample), 16)
+
+#else
+
+#define RESAMPLE_MAC(L0, L1, R0, R1, Left, Right, C0, C1, Tap)                  \
+    do                                                                          \
+    {                                                                           \
+        (L0) += (int32_t)(Left)[Tap]  * (C0)[Tap] + (int32_t)(Left)[(Tap) + 1]  * (C0)[(Tap) + 1]; \
+        (L1) += (int32_t)(Left)[Tap]  * (C1)[Tap] + (int32_t)(Left)[(Tap) + 1]  * (C1)[(Tap) + 1]; \
+        (R0) += (int32_t)(Right)[Tap] * (C0)[Tap] + (int32_t)(Right)[(Tap) + 1] * (C0)[(Tap) + 1]; \
+        (R1) += (int32_t)(Right)[Tap] * (C1)[Tap] + (int32_t)(Right)[(Tap) + 1] * (C1)[(Tap) + 1]; \
+    } while(0)
+
+static inline int32_t RESAMPLE_Clip(int32_t Sample)
+{
+    return (Sample > INT16_MAX) ? INT16_MAX : ((Sample < INT16_MIN) ? INT16_MIN : Sample);
+}
+
+#define RESAMPLE_CLIP(Sample)   RESAMPLE_Clip(Sample)
+
+#endif
+
+
+/*
+ * sin(x) from + - * / alone. Doubles are software on the target and IEEE on
+ * the host, so both build the same coefficient tables, bit for bit.
+ */
+static double RESAMPLE_Sin(double X)
+{
+    double   Term, Sum;
+    uint32_t Index;
+
+    /* to [-pi, pi], then [-pi/2, pi/2]. */
+    X -= 2.0 * RESAMPLE_PI * (double)(int32_t)((X / (2.0 * RESAMPLE_PI)) + ((X < 0.0) ? -0.5 : 0.5));
+    if(X > (RESAMPLE_PI / 2.0))
+    {
+        X = RESAMPLE_PI - X;
+    }
+    else if(X < (-RESAMPLE_PI / 2.0))
+    {
+        X = -RESAMPLE_PI - X;
+    }
+
+    for(Term = X, Sum = X, Index = 1; Index < 10; Index++)
+    {
+        Term *= -(X * X) / (double)((2 * Index) * (2 * Index + 1));
+        Sum  += Term;
+    }
+    return Sum;
+}
+
+/* Blackman windowed sinc for every phase, each set scaled to a DC gain of one. */
+static void RESAMPLE_Design(RESAMPLE_Type *Resampler)
+{
+    double   Taps[RESAMPLE_TAPS];
+    double   Cutoff, Tau, Sum;
+    uint32_t Phase, Tap;
+    int32_t  Coef;
+
+    /* in cycles per input sample. */
+    Cutoff = 0.5 * RESAMPLE_ROLLOFF;
+    if(Resampler->OutRate < Resampler->InRate)
+    {
+        Cutoff = Cutoff * Resampler->OutRate / Resampler->InRate;
+    }
+
+    for(Phase = 0; Phase <= RESAMPLE_PHASES; Phase++)
+    {
+        for(Sum = 0.0, Tap = 0; Tap < RESAMPLE_TAPS; Tap++)
+        {
+            /* input of the tap to the output, in input samples, -HALF..HALF. */
+            Tau = (double)Tap - (double)(RESAMPLE_HALF - 1u) - (double)Phase / RESAMPLE_PHASES;
+
+            Taps[Tap] = (Tau == 0.0) ? (2.0 * Cutoff) : (RESAMPLE_Sin(2.0 * RESAMPLE_PI * Cutoff * Tau) / (RESAMPLE_PI * Tau));
+            Taps[Tap] = Taps[Tap] * (0.42 + 0.50 * RESAMPLE_Sin(RESAMPLE_PI * Tau / RESAMPLE_HALF + RESAMPLE_PI / 2.0)
+                                          + 0.08 * RESAMPLE_Sin(2.0 * RESAMPLE_PI * Tau / RESAMPLE_HALF + RESAMPLE_PI / 2.0));
+            Sum += Taps[Tap];
+        }
+
+        for(Tap = 0; Tap < RESAMPLE_TAPS; Tap++)
+        {
+            Coef = (int32_t)((Taps[Tap] * 32768.0 / Sum) + ((Taps[Tap] < 0.0) ? -0.5 : 0.5));
+            Resampler->Coef[Phase][Tap] = (int16_t)((Coef > INT16_MAX) ? INT16_MAX : Coef);
+        }
+    }
+}
+
+/* One output frame from the window at Pos, between coefficient sets Phase and Phase + 1. */
+static void RESAMPLE_Frame(const RESAMPLE_Type *Resampler, uint16_t *Output)
+{
+    const int16_t *C0    = Resampler->Coef[Resampler->Frac >> (32u - RESAMPLE_PHASE_BITS)];
+    const int16_t *C1    = C0 + RESAMPLE_TAPS;
+    const int16_t *Left  = &Resampler->History[0][Resampler->Pos];
+    const int16_t *Right = &Resampler->History[1][Resampler->Pos];
+    int64_t  L0 = 0, L1 = 0, R0 = 0, R1 = 0;
+    int64_t  Mu = (Resampler->Frac >> RESAMPLE_MU_SHIFT) & 0xFFFFu;
+    uint32_t Tap;
+
+    for(Tap = 0; Tap < RESAMPLE_TAPS; Tap += 2)
+    {
+        RESAMPLE_MAC(L0, L1, R0, R1, Left, Right, C0, C1, Tap);
+    }
+
+    /* interpolate between the two phases, then Q15 back to 16 bits, rounded. */
+    L0 += ((L1 - L0) * Mu) >> 16;
+    R0 += ((R1 - R0) * Mu) >> 16;
+    Output[0] = (uint16_t)RESAMPLE_CLIP((int32_t)((L0 + (1 << 14)) >> 15));
+    Output[1] = (uint16_t)RESAMPLE_CLIP((int32_t)((R0 + (1 << 14)) >> 15));
+}
+
+
+/*******************************************************************************
+ * @brief       Sets up a conversion from InRate to OutRate and clears the history.
+ * @param       Resampler : state, about 5 KiB.
+ *              InRate    : Hz.
+ *              OutRate   : Hz.
+ * @retval      None
+ * @attention   The tables are rebuilt only when the rates change, once takes
+ *              a few tens of milliseconds on the target.
+*******************************************************************************/
+void RESAMPLE_Init(RESAMPLE_Type *Resampler, uint32_t InRate, uint32_t OutRate)
+{
+    uint64_t Step = ((uint64_t)InRate << 32) / OutRate;
+
+    if((Resampler->InRate != InRate) || (Resampler->OutRate != OutRate))
+    {
+        Resampler->InRate  = InRate;
+        Resampler->OutRate = OutRate;
+        RESAMPLE_Design(Resampler);
+    }
+
+    Resampler->StepInt  = (uint32_t)(Step >> 32);
+    Resampler->StepFrac = (uint32_t)Step;
+    Resampler->Frac     = 0;
+    Resampler->Pos      = 0;
+
+    /* silence before the stream, the first output falls on the first input. */
+    Resampler->Fill = RESAMPLE_HALF - 1u;
+    memset(Resampler->History, 0, sizeof(Resampler->History));
+}
+
+
+/*******************************************************************************
+ * @brief       Converts interleaved 16-bit stereo until the input is used up
+ *              or the output full.
+ * @param       Input     : *InFrames frames.
+ *              InFrames  : frames available, returns the frames taken.
+ *              Output    : room for OutFrames frames.
+ * @retval      Frames written to Output.
+ * @attention   Input is taken up to RESAMPLE_BLOCK frames at a time and kept,
+ *              the last TAPS/2 frames of a stream come out only once followed
+ *              by more input.
+*******************************************************************************/
+uint32_t RESAMPLE_Process(RESAMPLE_Type *Resampler, const uint16_t *Input, uint32_t *InFrames,
+                          uint16_t *Output, uint32_t OutFrames)
+{
+    uint32_t Used = 0, Made = 0, Count, Frac;
+
+    while(Made < OutFrames)
+    {
+        /* the window is in the history: one output, then step on. */
+        if((Resampler->Pos + RESAMPLE_TAPS) <= Resampler->Fill)
+        {
+            RESAMPLE_Frame(Resampler, &Output[2 * Made]);
+            Made++;
+
+            Frac = Resampler->Frac + Resampler->StepFrac;
+            Resampler->Pos += Resampler->StepInt + ((Frac < Resampler->Frac) ? 1u : 0u);
+            Resampler->Frac = Frac;
+            continue;
+        }
+
+        if(Used == *InFrames)
+        {
+            break;
+        }
+
+        /* history full: drop what the window has passed, with downsampling maybe all of it. */
+        if(Resampler->Fill == RESAMPLE_HISTORY)
+        {
+            Count = (Resampler->Pos < Resampler->Fill) ? Resampler->Pos : Resampler->Fill;
+
+            memmove(&Resampler->History[0][0], &Resampler->History[0][Count], (Resampler->Fill - Count) * sizeof(int16_t));
+            memmove(&Resampler->History[1][0], &Resampler->History[1][Count], (Resampler->Fill - Count) * sizeof(int16_t));
+            Resampler->Fill -= Count;
+            Resampler->Pos  -= Count;
+        }
+
+        /* inputs before the window are skipped, the rest split into the channels. */
+        for(; (Resampler->Pos > Resampler->Fill) && (Used < *InFrames); Used++)
+        {
+            Resampler->Pos--;
+        }
+
+        Count = RESAMPLE_HISTORY - Resampler->Fill;
+        if(Count > (*InFrames - Used))
+        {
+            Count = *InFrames - Used;
+        }
+
+        for(; Count != 0; Count--, Used++, Resampler->Fill++)
+        {
+            Resampler->History[0][Resampler->Fill] = (int16_t)Input[2 * Used];
+            Resampler->History[1][Resampler->Fill] = (int16_t)Input[2 * Used + 1];
+        }
+    }
+
+    *InFrames = Used;
+    return Made;
+}
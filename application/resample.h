@@ -0,0 +1,39 @@
+#ifndef __RESAMPLE_H_
+#define __RESAMPLE_H_
+#include <stdint.h>
+
+/*
+ * Polyphase sample rate converter for the 16-bit stereo output, any ratio.
+ * Each output sample is a RESAMPLE_TAPS point windowed sinc over the input,
+ * its coefficients interpolated between the two nearest of RESAMPLE_PHASES
+ * sets computed for the ratio by RESAMPLE_Init(). The cutoff follows the lower
+ * of the two rates, so downsampling does not alias. On cores with the DSP
+ * extension SMLALD multiplies two taps per instruction into a 64-bit sum; the
+ * C version gives the same result bit for bit.
+ */
+#ifndef RESAMPLE_TAPS
+#define RESAMPLE_TAPS           32u                 /* per output sample, even. */
+#endif
+#define RESAMPLE_PHASE_BITS     6u
+#define RESAMPLE_PHASES         (1u << RESAMPLE_PHASE_BITS)
+#define RESAMPLE_BLOCK          128u                /* input frames taken per refill. */
+#define RESAMPLE_HISTORY        (RESAMPLE_TAPS + RESAMPLE_BLOCK)
+
+typedef struct
+{
+    uint32_t InRate;
+    uint32_t OutRate;
+    uint32_t StepInt;       /* input frames per output frame, integer part, */
+    uint32_t StepFrac;      /* and fraction in 1/2^32. */
+    uint32_t Frac;          /* position of the next output past History[Pos + TAPS/2 - 1]. */
+    uint32_t Pos;           /* first input of its window, may run past Fill. */
+    uint32_t Fill;          /* inputs held in History. */
+    int16_t  History[2][RESAMPLE_HISTORY];
+    int16_t  Coef[RESAMPLE_PHASES + 1u][RESAMPLE_TAPS];    /* Q15, the last set is the next input's first. */
+} RESAMPLE_Type;
+
+extern void     RESAMPLE_Init(RESAMPLE_Type *Resampler, uint32_t InRate, uint32_t OutRate);
+extern uint32_t RESAMPLE_Process(RESAMPLE_Type *Resampler, const uint16_t *Input, uint32_t *InFrames,
+                                 uint16_t *Output, uint32_t OutFrames);
+
+#endif
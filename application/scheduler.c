@@ -2,78 +2,111 @@
  *     ƴ
  *     
 **********************************************************************************/
-#include "Scheduler.h"
+#include "scheduler.h"
 #include "stdio.h"
 #include "board_it.h"
+#include "audio.h"
 
 //////////////////////////////////////////////////////////////////////
 //û
 //////////////////////////////////////////////////////////////////////
 
-static void Loop_1000Hz(void) //1msִһ
+static void Loop_2Hz(void) //500msִһ
 {
-	//////////////////////////////////////////////////////////////////////
+	Audio_Task();
+	//printf("Test 2Hz\r\n");
 
-	//////////////////////////////////////////////////////////////////////
-}
+#if SCHED_REPORT_PERIOD_S
+	static uint16_t report_count = 0;
 
-static void Loop_500Hz(void) //2msִһ
-{
-	//////////////////////////////////////////////////////////////////////
-	//Audio_Task();
-	//////////////////////////////////////////////////////////////////////
+	if (++report_count >= 2 * SCHED_REPORT_PERIOD_S)
+	{
+		report_count = 0;
+		Scheduler_Report();
+	}
+#endif
 }
 
-static void Loop_200Hz(void) //5msִһ
-{
-	//////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////
+//ʼ
+//////////////////////////////////////////////////////////////////////
+//ϵͳãִͬƵʵġ̡߳
+/* only loops with work belong here: each periodic entry wakes Scheduler_Sleep() at its rate.
+ * Scheduler_Setup() fills in the intervals and the timing fields. */
+static sched_task_t sched_tasks[] =
+	{
+		{.task_func = AUDIO_ProcessEvents, .rate_hz = 0, .event = SCHED_EVENT_AUDIO},
+		{.task_func = Loop_2Hz,            .rate_hz = 2, .event = SCHED_EVENT_NONE},
+};
+//鳤ȣж߳
+#define TASK_NUM (sizeof(sched_tasks) / sizeof(sched_task_t))
 
-	//////////////////////////////////////////////////////////////////////
-}
+static uint64_t sched_clock;			/* GetCycleCount() extended to 64 bits. */
+static uint32_t sched_clock_last;
+static uint64_t sched_stats_start;
+static uint64_t sched_nested;			/* execution time of the tasks run inside the current one. */
+static uint64_t sched_idle;				/* time spent in Scheduler_Sleep(). */
 
-static void Loop_100Hz(void) //10msִһ
+/* per event: Scheduler_Trigger() counts posted up from the interrupts, Scheduler_Run()
+ * catches handled up, so neither side has to clear what the other one sets. */
+static volatile uint32_t sched_posted[SCHED_EVENT_NUM];
+static uint32_t sched_handled[SCHED_EVENT_NUM];
+
+/* Needs a call at least once per counter wrap (35 s at 120 MHz), Scheduler_Run() makes them. */
+static uint64_t sched_now(void)
 {
-	//////////////////////////////////////////////////////////////////////
+	uint32_t now = GetCycleCount();
 
-	//////////////////////////////////////////////////////////////////////
+	sched_clock += (uint32_t)(now - sched_clock_last);
+	sched_clock_last = now;
+	return sched_clock;
 }
 
-static void Loop_50Hz(void) //20msִһ
+static uint32_t sched_us(uint64_t ticks)
 {
-	//////////////////////////////////////////////////////////////////////
-	
-	//////////////////////////////////////////////////////////////////////
+	return (uint32_t)(ticks / (GetCycleCountFreq() / 1000000u));
 }
 
-static void Loop_20Hz(void) //50msִһ
+static uint32_t sched_clamp(uint64_t ticks)
 {
-	//////////////////////////////////////////////////////////////////////
-
-	//////////////////////////////////////////////////////////////////////
+	return (ticks > UINT32_MAX) ? UINT32_MAX : (uint32_t)ticks;
 }
 
-static void Loop_2Hz(void) //500msִһ
+/* Runs one task and updates its timing, due says it started for its interval. */
+static void sched_task_exec(sched_task_t *task, bool due)
 {
-	Audio_Task();
-	//printf("Test 2Hz\r\n");
-}
+	uint64_t interval = (uint64_t)task->interval_ticks * (GetCycleCountFreq() / TICK_PER_SECOND);
+	uint64_t start, late, total, saved;
+	uint32_t exec;
 
-//////////////////////////////////////////////////////////////////////
-//ʼ
-//////////////////////////////////////////////////////////////////////
-//ϵͳãִͬƵʵġ̡߳
-static sched_task_t sched_tasks[] =
+	start = sched_now();
+	if (due && (task->runs != 0))
 	{
-		{Loop_1000Hz, 1000, 0, 0},
-		{Loop_500Hz, 500, 0, 0},
-		{Loop_200Hz, 200, 0, 0},
-		{Loop_100Hz, 100, 0, 0},
-		{Loop_50Hz, 50, 0, 0},
-		{Loop_20Hz, 20, 0, 0},
-		{Loop_2Hz, 2, 0, 0},
-};
-//鳤ȣж߳
-#define TASK_NUM (sizeof(sched_tasks) / sizeof(sched_task_t))
+		late = start - task->last_start;
+		late = (late > interval) ? (late - interval) : 0;
+
+		task->jitter_total += late;
+		task->jitter_max    = (late > task->jitter_max) ? sched_clamp(late) : task->jitter_max;
+		task->missed       += (uint32_t)(late / interval);
+	}
+	task->last_start = start;
+
+	saved = sched_nested;
+	sched_nested = 0;
+
+	task->task_func();
+
+	/* a task that calls Scheduler_Run() itself is not charged for what that runs. */
+	total = sched_now() - start;
+	exec  = sched_clamp(total - sched_nested);
+
+	task->exec_total += total - sched_nested;
+	task->exec_min    = (exec < task->exec_min) ? exec : task->exec_min;
+	task->exec_max    = (exec > task->exec_max) ? exec : task->exec_max;
+	task->runs++;
+
+	sched_nested = saved + total;
+}
 
 void Scheduler_Setup(void)
 {
@@ -81,6 +114,10 @@ void Scheduler_Setup(void)
 	//ʼ
 	for (index = 0; index < TASK_NUM; index++)
 	{
+		if (sched_tasks[index].rate_hz == 0)
+		{
+			continue;
+		}
 		//ÿʱ
 		sched_tasks[index].interval_ticks = TICK_PER_SECOND / sched_tasks[index].rate_hz;
 		//Ϊ1Ҳ1ms
@@ -89,27 +126,182 @@ void Scheduler_Setup(void)
 			sched_tasks[index].interval_ticks = 1;
 		}
 	}
+
+	/* the timing statistics count DWT cycles. */
+	CycleCounter_Init();
+	Scheduler_ResetStats();
 }
 //ŵmainwhile(1)УͣжǷ߳Ӧִ
 void Scheduler_Run(void)
 {
 	uint8_t index = 0;
+	bool due, triggered;
+	//ȡϵͳǰʱ䣬λMS
+	uint32_t tnow = GetSysRunTimeMs();
 	//ѭж̣߳ǷӦִ
 
 	for (index = 0; index < TASK_NUM; index++)
 	{
-		//ȡϵͳǰʱ䣬λMS
-		uint32_t tnow = GetSysRunTimeMs();
+		sched_task_t *task = &sched_tasks[index];
 		//жϣǰʱȥһִеʱ䣬ڵڸ̵ִ߳ڣִ߳
-		if (tnow - sched_tasks[index].last_run >= sched_tasks[index].interval_ticks)
-		{
+		due       = (task->interval_ticks != 0) && (tnow - task->last_run >= task->interval_ticks);
+		triggered = (task->event != SCHED_EVENT_NONE) && (sched_posted[task->event] != sched_handled[task->event]);
 
+		if (due || triggered)
+		{
 			//̵ִ߳ʱ䣬һж
-			sched_tasks[index].last_run = tnow;
+			if (due)
+			{
+				task->last_run = tnow;
+			}
+			/* caught up before the run, a trigger during it runs the task again. */
+			if (triggered)
+			{
+				sched_handled[task->event] = sched_posted[task->event];
+			}
 			//ִ̺߳ʹõǺָ
-			sched_tasks[index].task_func();
+			sched_task_exec(task, due);
+		}
+	}
+}
+
+/* From an interrupt (or anywhere): runs the tasks of event at the next pass. */
+void Scheduler_Trigger(sched_event_t event)
+{
+	if ((event != SCHED_EVENT_NONE) && (event < SCHED_EVENT_NUM))
+	{
+		sched_posted[event]++;
+	}
+}
+
+/* Milliseconds until the next task is due, 0 when one is due or triggered now. */
+uint32_t Scheduler_NextDueMs(void)
+{
+	uint32_t tnow = GetSysRunTimeMs();
+	uint32_t next = UINT32_MAX;
+	uint32_t elapsed;
+	uint8_t index = 0;
+
+	for (index = 0; index < TASK_NUM; index++)
+	{
+		const sched_task_t *task = &sched_tasks[index];
+
+		if ((task->event != SCHED_EVENT_NONE) && (sched_posted[task->event] != sched_handled[task->event]))
+		{
+			return 0;
+		}
+		if (task->interval_ticks != 0)
+		{
+			elapsed = tnow - task->last_run;
+			if (elapsed >= task->interval_ticks)
+			{
+				return 0;
+			}
+			next = (task->interval_ticks - elapsed < next) ? (task->interval_ticks - elapsed) : next;
+		}
+	}
+
+	return next;
+}
+
+/*
+ * Sleeps (WFI, the dma keeps running) until a task is due or triggered. Every
+ * interrupt ends a WFI, SysTick at least once a millisecond, so an event posted
+ * between the test and the WFI waits for one tick at most.
+ */
+void Scheduler_Sleep(void)
+{
+	uint64_t start = sched_now();
+
+	while (Scheduler_NextDueMs() != 0)
+	{
+		WaitForInterrupt();
+	}
+
+	sched_idle += sched_now() - start;
+}
+
+uint8_t Scheduler_GetTaskNum(void)
+{
+	return TASK_NUM;
+}
+
+bool Scheduler_GetStats(uint8_t index, sched_stats_t *stats)
+{
+	const sched_task_t *task;
+	uint64_t elapsed;
+
+	if (index >= TASK_NUM)
+	{
+		return false;
+	}
+
+	task    = &sched_tasks[index];
+	elapsed = sched_now() - sched_stats_start;
+
+	stats->rate_hz       = task->rate_hz;
+	stats->runs          = task->runs;
+	stats->missed        = task->missed;
+	stats->exec_min_us   = (task->runs != 0) ? sched_us(task->exec_min) : 0;
+	stats->exec_avg_us   = (task->runs != 0) ? sched_us(task->exec_total / task->runs) : 0;
+	stats->exec_max_us   = sched_us(task->exec_max);
+	stats->jitter_avg_us = (task->runs > 1) ? sched_us(task->jitter_total / (task->runs - 1)) : 0;
+	stats->jitter_max_us = sched_us(task->jitter_max);
+	stats->cpu_permille  = (elapsed != 0) ? (uint16_t)(task->exec_total * 1000u / elapsed) : 0;
+
+	return true;
+}
+
+void Scheduler_ResetStats(void)
+{
+	uint8_t index = 0;
+
+	for (index = 0; index < TASK_NUM; index++)
+	{
+		sched_tasks[index].exec_total   = 0;
+		sched_tasks[index].jitter_total = 0;
+		sched_tasks[index].exec_min     = UINT32_MAX;
+		sched_tasks[index].exec_max     = 0;
+		sched_tasks[index].jitter_max   = 0;
+		sched_tasks[index].runs         = 0;
+		sched_tasks[index].missed       = 0;
+	}
+	sched_idle        = 0;
+	sched_stats_start = sched_now();
+}
+
+/* Share of the time since the reset spent in Scheduler_Sleep(). */
+uint16_t Scheduler_GetIdlePermille(void)
+{
+	uint64_t elapsed = sched_now() - sched_stats_start;
+
+	return (elapsed != 0) ? (uint16_t)(sched_idle * 1000u / elapsed) : 0;
+}
+
+void Scheduler_Report(void)
+{
+	sched_stats_t stats;
+	uint8_t index = 0;
+
+	printf(">   rate     runs missed  exec min/    avg/     max us  jitter avg/     max us    cpu\r\n");
+	for (index = 0; index < TASK_NUM; index++)
+	{
+		Scheduler_GetStats(index, &stats);
+		if (stats.rate_hz == 0)
+		{
+			printf(">  event");
+		}
+		else
+		{
+			printf("> %4uHz", stats.rate_hz);
 		}
+		printf(" %8lu %6lu  %8lu/%8lu/%8lu     %8lu/%8lu %4u.%u%%\r\n",
+		       (unsigned long)stats.runs, (unsigned long)stats.missed,
+		       (unsigned long)stats.exec_min_us, (unsigned long)stats.exec_avg_us, (unsigned long)stats.exec_max_us,
+		       (unsigned long)stats.jitter_avg_us, (unsigned long)stats.jitter_max_us,
+		       stats.cpu_permille / 10u, stats.cpu_permille % 10u);
 	}
+	printf(">   idle %u.%u%%\r\n", Scheduler_GetIdlePermille() / 10u, Scheduler_GetIdlePermille() % 10u);
 }
 
 /******************* (C) COPYRIGHT 2014 ANO TECH *****END OF FILE************/
@@ -3,20 +3,68 @@
 #include "hal_common.h"
 
 #define TICK_PER_SECOND	1000
+
+/* seconds between the timing reports on the console, 0 for none. */
+#ifndef SCHED_REPORT_PERIOD_S
+#define SCHED_REPORT_PERIOD_S	10
+#endif
 #ifdef __cplusplus
  extern "C" {
 #endif 
 
+/* Scheduler_Trigger() events, each runs the tasks that name it at the next pass. */
+typedef enum
+{
+SCHED_EVENT_NONE = 0,
+SCHED_EVENT_AUDIO,					/* AUDIO_PostEvent() has queued dma work. */
+SCHED_EVENT_NUM,
+}sched_event_t;
+
 typedef struct
 {
 void(*task_func)(void);
-uint16_t rate_hz;
+uint16_t rate_hz;					/* 0 for a task that only runs on its event. */
 uint16_t interval_ticks;
 uint32_t last_run;
+uint8_t event;
+/* timing, in GetCycleCount() ticks, see Scheduler_GetStats(). */
+uint64_t last_start;
+uint64_t exec_total;
+uint64_t jitter_total;
+uint32_t exec_min;
+uint32_t exec_max;
+uint32_t jitter_max;
+uint32_t runs;
+uint32_t missed;
 }sched_task_t;
 
+/* Timing of one task since Scheduler_Setup() or Scheduler_ResetStats(). The
+ * execution time leaves out the tasks the task runs itself through a nested
+ * Scheduler_Run(); jitter is how much later than one interval after its last
+ * start a task started; missed counts the whole intervals it was late by. */
+typedef struct
+{
+uint16_t rate_hz;
+uint32_t runs;
+uint32_t missed;
+uint32_t exec_min_us;
+uint32_t exec_avg_us;
+uint32_t exec_max_us;
+uint32_t jitter_avg_us;
+uint32_t jitter_max_us;
+uint16_t cpu_permille;			/* share of the time since the reset. */
+}sched_stats_t;
+
 void Scheduler_Setup(void);
 void Scheduler_Run(void);
+void Scheduler_Trigger(sched_event_t event);
+uint32_t Scheduler_NextDueMs(void);
+void Scheduler_Sleep(void);
+uint16_t Scheduler_GetIdlePermille(void);
+uint8_t Scheduler_GetTaskNum(void);
+bool Scheduler_GetStats(uint8_t index, sched_stats_t *stats);
+void Scheduler_ResetStats(void);
+void Scheduler_Report(void);
 
 
 #ifdef __cplusplus
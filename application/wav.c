@@ -1,191 +1,338 @@
 #include "wav.h"
 #include "i2s_port.h"
+#include "audio.h"
+#include "audio_file.h"
+#include "log.h"
+#include "pcm.h"
 
-FIL     WAV_File;
-UINT    WAV_BR[2];
+/* whole frames of every format (1, 2, 3, 4, 6 and 8 bytes) and whole sectors. */
+#define WAV_STAGE_SIZE          (6u * FF_MIN_SS)
+#define WAV_SLOT_BYTES          (I2S_RING_SLOT_SIZE * sizeof(uint16_t))
+#define WAV_RATE_MIN            8000u
+#define WAV_RATE_MAX            192000u
+#define WAV_PCM_FRAMES          256u                /* 16-bit stereo ahead of the resampler. */
+
+AUDIO_File_Type WAV_File;
+UINT    WAV_BR;
 FRESULT WAV_RES;
 
-DTCM_RAM uint8_t WAV_DataBuffer[2][WAV_BUFFER_SIZE];
-uint8_t WAV_NextIndex = 0;
 uint8_t WAV_PlayEnded = 0;
 
 uint32_t WAV_PlaybackTotal     = 0;
 uint32_t WAV_PlaybackProgress  = 0;
 
+static PCM_Converter_Type WAV_Convert;      /* NULL for 16-bit stereo, read straight into the slot. */
+static uint16_t           WAV_BlockAlign;
+static __ALIGNED(4) uint8_t WAV_Stage[WAV_STAGE_SIZE];
+
+static RESAMPLE_Type *WAV_Resampler;                /* NULL: played at the file's rate. */
+static __ALIGNED(4) uint16_t WAV_Pcm[2 * WAV_PCM_FRAMES];
+static uint32_t       WAV_PcmCount;                 /* frames in WAV_Pcm, */
+static uint32_t       WAV_PcmUsed;                  /* of which resampled. */
+
+/* Reads Length bytes at the current position, FR_INT_ERR if the file ends first. */
+static FRESULT WAV_ReadExact(void *Buffer, UINT Length)
+{
+    WAV_RES = AUDIO_File_Read(&WAV_File, Buffer, Length, &WAV_BR);
+
+    if((WAV_RES == FR_OK) && (WAV_BR != Length))
+    {
+        WAV_RES = FR_INT_ERR;
+    }
+    return WAV_RES;
+}
+
+/*
+ * Opens the song and walks its RIFF chunks, seeking over the ones it does not
+ * need (LIST, bext, id3, fact...) whatever their size. On success WAV_File is
+ * left open at the first sample of the data chunk; on failure it is closed.
+ * Result: 0 ok, 1 open error, 2 not a WAV file, 3 no data chunk, 4 no fmt chunk.
+ */
 static uint8_t WAV_DecodeFile(WAV_TypeDef *pWav, char *Path, char *Name)
 {
-    static ChunkRIFF_TypeDef *WAV_RIFF;
-    static ChunkFMT_TypeDef  *WAV_FMT ;
-    static ChunkFACT_TypeDef *WAV_FACT;
-    static ChunkDATA_TypeDef *WAV_DATA;
+    static struct
+    {
+        ChunkFMT_TypeDef    Base;
+        ChunkFMTExt_TypeDef Ext;
+    } WAV_Fmt;
 
-		static uint8_t WAV_HeadBuffer[512];
+    ChunkRIFF_TypeDef RIFF;
+    ChunkHEAD_TypeDef Chunk;
+    FSIZE_t Offset, FileSize;
+    UINT    Length;
+    uint8_t FmtFound = 0;
 
-    static uint8_t Result = 0;
     static char FilePath[ 100];
 
+    /* a file without a fmt chunk fails below, the fields are only read after a success. */
+    memset(pWav, 0, sizeof(WAV_TypeDef));
     memset( FilePath, 0x00, sizeof(FilePath));
     sprintf(FilePath, "%s%s",   Path,   Name);
-		printf("%s\r\n",FilePath);
-    WAV_RES = f_open(&WAV_File, FilePath, FA_READ);
+		LOG_D("%s\r\n",FilePath);
+    WAV_RES = AUDIO_File_Open(&WAV_File, FilePath);
 
-    if(WAV_RES == FR_OK)
+    if(WAV_RES != FR_OK)
     {
-        /* ȡ512ֽ */
-        WAV_RES = f_read(&WAV_File, WAV_HeadBuffer, 512, &WAV_BR[0]);
+        return 1;
+    }
+    FileSize = f_size(&WAV_File.File);
 
-        if((WAV_RES == FR_OK) && (WAV_BR[0] != 0))
+    if((WAV_ReadExact(&RIFF, sizeof(RIFF)) != FR_OK) ||
+       (RIFF.ChunkID != WAV_ID_RIFF) || (RIFF.Format != WAV_ID_WAVE))
+    {
+        AUDIO_File_Close(&WAV_File);
+        return 2;
+    }
+
+    /* the file is at Offset, the start of a chunk header. */
+    for(Offset = sizeof(RIFF); (Offset + sizeof(Chunk)) <= FileSize; )
+    {
+        if(WAV_ReadExact(&Chunk, sizeof(Chunk)) != FR_OK)
         {
-            /* ȡRIFF */
-            WAV_RIFF = (ChunkRIFF_TypeDef *)WAV_HeadBuffer;
+            break;
+        }
+        Offset += sizeof(Chunk);
 
-            /* WAVʽļ */
-            if(WAV_RIFF->Format == 0x45564157)
+        if(Chunk.ChunkID == WAV_ID_DATA)
+        {
+            if(FmtFound == 0)
             {
-                /* ȡFMT */
-                WAV_FMT  = (ChunkFMT_TypeDef *)(WAV_HeadBuffer+12);
-
-                /* ȡFACT */
-                WAV_FACT = (ChunkFACT_TypeDef *)(WAV_HeadBuffer+12+8+WAV_FMT->ChunkSize);
-
-                if((WAV_FACT->ChunkID == 0x74636166) || (WAV_FACT->ChunkID == 0x5453494C))
-                {
-                    /* FACT/LISTʱ(δ) */
-                    pWav->DataStart=12+8+WAV_FMT->ChunkSize+8+WAV_FACT->ChunkSize;
-                }
-                else
-                {
-                    pWav->DataStart=12+8+WAV_FMT->ChunkSize;
-                }
-
-                /* ȡDATA */
-                WAV_DATA = (ChunkDATA_TypeDef *)(WAV_HeadBuffer+pWav->DataStart);
-
-                /* ɹ */
-                if(WAV_DATA->ChunkID == 0x61746164)
-                {
-                    pWav->AudioFormat   = WAV_FMT->AudioFormat;     /* Ƶʽ */
-                    pWav->nChannels     = WAV_FMT->NumOfChannels;   /* ͨ */
-                    pWav->SampleRate    = WAV_FMT->SampleRate;      /*  */
-                    pWav->BitRate       = WAV_FMT->ByteRate*8;      /* õλ */
-                    pWav->BlockAlign    = WAV_FMT->BlockAlign;      /*  */
-                    pWav->BitsPerSample = WAV_FMT->BitsPerSample;   /* λ,16/24/32λ */
-
-                    pWav->DataSize      = WAV_DATA->ChunkSize;      /* ݿС */
-                    pWav->DataStart     = pWav->DataStart+8;        /* ʼĵط */
-
-                    printf("\r\npWav->AudioFormat   : %d", pWav->AudioFormat);
-                    printf("\r\npWav->nChannels     : %d", pWav->nChannels);
-                    printf("\r\npWav->SampleRate    : %d", pWav->SampleRate);
-                    printf("\r\npWav->BitRate       : %d", pWav->BitRate);
-                    printf("\r\npWav->BlockAlign    : %d", pWav->BlockAlign);
-                    printf("\r\npWav->BitsPerSample : %d", pWav->BitsPerSample);
-                    printf("\r\npWav->DataSize      : %d", pWav->DataSize);
-                    printf("\r\npWav->DataStart     : %d", pWav->DataStart);
-
-                    WAV_PlaybackTotal = pWav->DataSize;
-                }
-                else
-                {
-                    Result = 3; /* DATAδҵ */
-                }
+                break;
             }
-            else
+
+            pWav->DataStart = Offset;
+            /* 0 or oversized: a stream that never patched the size in, play to the end. */
+            pWav->DataSize  = ((Chunk.ChunkSize == 0) || (Chunk.ChunkSize > (FileSize - Offset))) ?
+                              (uint32_t)(FileSize - Offset) : Chunk.ChunkSize;
+
+            LOG_D("\r\npWav->AudioFormat   : %d", pWav->AudioFormat);
+            LOG_D("\r\npWav->nChannels     : %d", pWav->nChannels);
+            LOG_D("\r\npWav->SampleRate    : %d", pWav->SampleRate);
+            LOG_D("\r\npWav->BitRate       : %d", pWav->BitRate);
+            LOG_D("\r\npWav->BlockAlign    : %d", pWav->BlockAlign);
+            LOG_D("\r\npWav->BitsPerSample : %d", pWav->BitsPerSample);
+            LOG_D("\r\npWav->DataSize      : %d", pWav->DataSize);
+            LOG_D("\r\npWav->DataStart     : %d\r\n", pWav->DataStart);
+
+            WAV_PlaybackTotal = pWav->DataSize;
+            return 0;
+        }
+
+        Length = 0;
+        if((Chunk.ChunkID == WAV_ID_FMT) && (Chunk.ChunkSize >= (sizeof(WAV_Fmt.Base) - sizeof(Chunk))))
+        {
+            memset(&WAV_Fmt, 0, sizeof(WAV_Fmt));
+            Length = (Chunk.ChunkSize < (sizeof(WAV_Fmt) - sizeof(Chunk))) ? Chunk.ChunkSize : (sizeof(WAV_Fmt) - sizeof(Chunk));
+            if(WAV_ReadExact(&WAV_Fmt.Base.AudioFormat, Length) != FR_OK)
             {
-                Result = 2;     /* WAVʽļ */
+                break;
             }
+
+            pWav->AudioFormat   = WAV_Fmt.Base.AudioFormat;
+            pWav->nChannels     = WAV_Fmt.Base.NumOfChannels;
+            pWav->SampleRate    = WAV_Fmt.Base.SampleRate;
+            pWav->BitRate       = WAV_Fmt.Base.ByteRate * 8;
+            pWav->BlockAlign    = WAV_Fmt.Base.BlockAlign;
+            pWav->BitsPerSample = WAV_Fmt.Base.BitsPerSample;
+
+            /* the format code of an extensible file is in its SubFormat GUID. */
+            if((pWav->AudioFormat == WAV_FORMAT_EXTENSIBLE) && (WAV_Fmt.Ext.ExtraSize >= 22))
+            {
+                pWav->AudioFormat = WAV_Fmt.Ext.SubFormat;
+            }
+            FmtFound = 1;
         }
 
-       f_close(&WAV_File);
+        /* bodies are word aligned, an odd one is followed by a pad byte. */
+        Offset += (FSIZE_t)Chunk.ChunkSize + (Chunk.ChunkSize & 1u);
+        if(Length != (Chunk.ChunkSize + (Chunk.ChunkSize & 1u)))
+        {
+            if(AUDIO_File_Seek(&WAV_File, Offset) != FR_OK)
+            {
+                break;
+            }
+        }
     }
-    else
+
+    AUDIO_File_Close(&WAV_File);
+    return (FmtFound == 0) ? 4 : 3;
+}
+
+/*
+ * Reads up to Frames frames of 16-bit stereo into Output and returns how many,
+ * fewer at the end of the data. 16-bit stereo is read straight in, other
+ * formats through WAV_Stage and WAV_Convert, a few sectors at a time.
+ */
+static uint32_t WAV_ReadFrames(uint16_t *Output, uint32_t Frames)
+{
+    UINT     Length, Count;
+    uint32_t Done = 0;
+
+    /* the data chunk may be followed by others (LIST, id3), stop at its end. */
+    if(Frames > ((WAV_PlaybackTotal - WAV_PlaybackProgress) / WAV_BlockAlign))
     {
-        Result = 1;             /* ļ */
+        Frames = (WAV_PlaybackTotal - WAV_PlaybackProgress) / WAV_BlockAlign;
     }
 
-    printf("\r\n\r\nWAV Decode File Result : %d\r\n\r\n", Result);
+    if(WAV_Convert == NULL)
+    {
+        WAV_RES = AUDIO_File_Read(&WAV_File, Output, Frames * WAV_BlockAlign, &WAV_BR);
+        if(WAV_RES != FR_OK) WAV_BR = 0;
+
+        WAV_PlaybackProgress += WAV_BR;
+        return WAV_BR / WAV_BlockAlign;
+    }
+
+    while(Done < Frames)
+    {
+        Count = WAV_STAGE_SIZE / WAV_BlockAlign;
+        if(Count > (Frames - Done))
+        {
+            Count = Frames - Done;
+        }
+
+        Length  = Count * WAV_BlockAlign;
+        WAV_RES = AUDIO_File_Read(&WAV_File, WAV_Stage, Length, &WAV_BR);
+        if(WAV_RES != FR_OK) WAV_BR = 0;
 
-    return Result;
+        WAV_PlaybackProgress += WAV_BR;
+        WAV_Convert(&Output[2 * Done], WAV_Stage, WAV_BR / WAV_BlockAlign);
+        Done += WAV_BR / WAV_BlockAlign;
+
+        if(WAV_BR < Length)
+        {
+            break;
+        }
+    }
+
+    return Done;
 }
 
-void WAV_PrepareData(void)
+/*
+ * Fills one output slot and returns the bytes placed in it, fewer than a slot
+ * at the end of the data. A resampled stream is read into WAV_Pcm first.
+ */
+static UINT WAV_FillSlot(uint16_t *Slot)
 {
-    if(WAV_NextIndex == 0)
+    uint32_t Done = 0, Used;
+
+    if(WAV_Resampler == NULL)
     {
-        WAV_RES = f_read(&WAV_File, WAV_DataBuffer[WAV_NextIndex], WAV_BUFFER_SIZE, &WAV_BR[WAV_NextIndex]);
-        if(WAV_BR[0] == 0) WAV_PlayEnded = 1;
+        return WAV_ReadFrames(Slot, I2S_RING_SLOT_SIZE / 2) * 2 * sizeof(uint16_t);
     }
-    else
+
+    while(Done < (I2S_RING_SLOT_SIZE / 2))
     {
-        WAV_RES = f_read(&WAV_File, WAV_DataBuffer[WAV_NextIndex], WAV_BUFFER_SIZE, &WAV_BR[WAV_NextIndex]);
-        if(WAV_BR[1] == 0) WAV_PlayEnded = 1;
+        if(WAV_PcmUsed == WAV_PcmCount)
+        {
+            WAV_PcmUsed  = 0;
+            WAV_PcmCount = WAV_ReadFrames(WAV_Pcm, WAV_PCM_FRAMES);
+
+            if(WAV_PcmCount == 0)
+            {
+                break;
+            }
+        }
+
+        Used  = WAV_PcmCount - WAV_PcmUsed;
+        Done += RESAMPLE_Process(WAV_Resampler, &WAV_Pcm[2 * WAV_PcmUsed], &Used,
+                                 &Slot[2 * Done], (I2S_RING_SLOT_SIZE / 2) - Done);
+        WAV_PcmUsed += Used;
     }
+
+    return Done * 2 * sizeof(uint16_t);
 }
 
-void WAV_PlayHandler(void)
+/* Fills the free slots of the output ring from the file. */
+void WAV_PrepareData(void)
 {
-    if(WAV_PlayEnded == 0)
-    {
-        WAV_PlaybackProgress += WAV_BR[WAV_NextIndex];
+    uint16_t *Slot;
+    UINT      Filled;
 
-        I2S_DMA_Transfer((uint16_t *)&WAV_DataBuffer[WAV_NextIndex][0], (WAV_BR[WAV_NextIndex] /2));
-			
-    }
-    else
+    while((WAV_PlayEnded == 0) && ((Slot = I2S_Ring_GetWriteSlot()) != NULL))
     {
-        DMA_EnableChannel(DMA1,DMA_REQ_DMA1_SPI2_TX,false);
-        f_close(&WAV_File); 
-				I2S_PowerON(0);
-        printf("\r\nWAV Play Finish!\r\n");
+        Filled = WAV_FillSlot(Slot);
+
+        if(Filled < WAV_SLOT_BYTES)
+        {
+            WAV_PlayEnded = 1;
+        }
+
+        if(Filled != 0)
+        {
+            memset((uint8_t *)Slot + Filled, 0, WAV_SLOT_BYTES - Filled);
+            I2S_Ring_Commit();
+        }
+
+        if(WAV_PlayEnded == 1)
+        {
+            I2S_Ring_Flush();
+        }
     }
-//WAV_NextIndex = 1;
-    if(WAV_NextIndex == 0) WAV_NextIndex = 1;
-    else                   WAV_NextIndex = 0;
+}
+
+/* Called from the dma interrupt once the ring has played out. */
+void WAV_PlayHandler(void)
+{
+    AUDIO_File_Close(&WAV_File);
+    I2S_PowerON(0);
+    LOG_I("\r\nWAV Play Finish!\r\n");
 }
 
 void WAV_PlaySong(char *Path, char *Name)
 {
     WAV_TypeDef WaveFile;
-    char FilePath[100];
+    uint8_t     Result;
 
     /* ȡWAVļϢ */
-    if(WAV_DecodeFile(&WaveFile, Path, Name) == 0)
+    Result = WAV_DecodeFile(&WaveFile, Path, Name);
+    LOG_D("\r\n\r\nWAV Decode File Result : %d\r\n\r\n", Result);
+
+    /* the file is open at the first sample from here on. */
+    if(Result == 0)
     {
-        if((WaveFile.BitsPerSample == 16) && (WaveFile.nChannels == 2) &&
-           (WaveFile.SampleRate  > 44000) && (WaveFile.SampleRate < 48100))
+        /* everything is played as 16-bit stereo at the file's own rate. */
+        if((WaveFile.AudioFormat == WAV_FORMAT_PCM) &&
+           (PCM_GetConverter(WaveFile.BitsPerSample, WaveFile.nChannels) != NULL) &&
+           (WaveFile.BlockAlign == (WaveFile.nChannels * WaveFile.BitsPerSample / 8)) &&
+           (WaveFile.SampleRate >= WAV_RATE_MIN) && (WaveFile.SampleRate <= WAV_RATE_MAX))
         {
+            WAV_BlockAlign = WaveFile.BlockAlign;
+            WAV_Convert    = ((WaveFile.BitsPerSample == 16) && (WaveFile.nChannels == 2)) ?
+                             NULL : PCM_GetConverter(WaveFile.BitsPerSample, WaveFile.nChannels);
+
 					I2S_PowerON(1);
-					I2S_Configure(I2S_Protocol_PHILIPS, I2S_DataWidth_16b,I2S_AudioFreq_44k, I2S_XferMode_TxOnly);
+					WAV_Resampler = AUDIO_SetSampleRate(WaveFile.SampleRate);
+					WAV_PcmCount  = 0;
+					WAV_PcmUsed   = 0;
         }
         else
         {
-            printf("\r\nWAV File Error!\r\n");  return;
+            AUDIO_File_Close(&WAV_File);
+            LOG_E("\r\nWAV File Error!\r\n");  return;
         }
     }
+    else if(Result == 1)
+    {
+        LOG_E("\r\nWAV File Open Error : %d", WAV_RES);  return;
+    }
     else
     {
-        printf("\r\nNot WAV File!\r\n");    return;
+        LOG_E("\r\nNot WAV File!\r\n");    return;
     }
 
-    memset( FilePath, 0x00, sizeof(FilePath));
-    sprintf(FilePath, "%s%s",   Path,   Name);
-		printf(">f_open WAV Start...\r\n");
-    WAV_RES = f_open(&WAV_File, FilePath, FA_READ);
+    WAV_PlayEnded = 0;
 
-    if(WAV_RES == FR_OK)
-    {
-				printf(">f_open WAV Done!\r\n");
-        WAV_NextIndex = 0;
-        WAV_PlayEnded = 0;
+    WAV_PlaybackProgress = 0;
 
-        WAV_PlaybackProgress = 0;
+    /* fill the ring, the dma starts with the last slot and refills from its interrupt. */
+    I2S_Ring_Reset();
+    WAV_PrepareData();
 
-        WAV_PrepareData();
-        WAV_PlayHandler();
-    }
-    else
+    /* nothing to play. */
+    if(I2S_Ring_Busy() == false)
     {
-        printf("\r\nWAV File Open Error : %d", WAV_RES);
+        WAV_PlayHandler();
     }
 }
 
@@ -3,7 +3,13 @@
 
 #include "hal_common.h"
 
-#define WAV_BUFFER_SIZE   (5 * 1024)
+#define WAV_ID_RIFF             0x46464952u     /* "RIFF" */
+#define WAV_ID_WAVE             0x45564157u     /* "WAVE" */
+#define WAV_ID_FMT              0x20746D66u     /* "fmt " */
+#define WAV_ID_DATA             0x61746164u     /* "data" */
+
+#define WAV_FORMAT_PCM          0x0001u
+#define WAV_FORMAT_EXTENSIBLE   0xFFFEu
 
 /* Exported types : RIFF Chunk -----------------------------------------------*/
 typedef struct
@@ -41,6 +47,32 @@ typedef struct
 }ChunkFMT_TypeDef;
 
 
+/* Exported types : FMT Chunk extension, WAVE_FORMAT_EXTENSIBLE --------------*/
+typedef struct
+{
+    uint16_t ExtraSize;     /* bytes after the basic fmt fields; 22 */
+
+    uint16_t ValidBits;     /* bits of each sample that carry audio */
+
+    uint32_t ChannelMask;   /* speaker position of each channel */
+
+    uint16_t SubFormat;     /* first two bytes of the SubFormat GUID, the real format code */
+
+    uint8_t  SubFormatGUID[14];
+
+}ChunkFMTExt_TypeDef;
+
+
+/* Exported types : Chunk Header ---------------------------------------------*/
+typedef struct
+{
+    uint32_t ChunkID;
+
+    uint32_t ChunkSize;     /* body size, a pad byte follows an odd body */
+
+}ChunkHEAD_TypeDef;
+
+
 /* Exported types : FACT Chunk -----------------------------------------------*/
 typedef struct 
 {
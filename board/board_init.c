@@ -7,6 +7,7 @@
 
 #include "board_init.h"
 #include "hal_gpio.h"
+#include "log_port.h"
 
 /*
 * Definitions.
@@ -41,15 +42,16 @@ void BOARD_InitDebugConsole(void)
     uart_init.HwFlowControl = UART_HwFlowControl_None;
     UART_Init(BOARD_DEBUG_UART_PORT, &uart_init);
     UART_Enable(BOARD_DEBUG_UART_PORT, true);
+
+    /* printf goes through the dma ring from here on, see log_port.h. */
+    LOG_Port_Init();
 }
 
 #if defined(__ARMCC_VERSION)
 int fputc(int c, FILE *f)
 {
     (void)(f);
-    while ( 0u == (UART_STATUS_TX_EMPTY & UART_GetStatus(BOARD_DEBUG_UART_PORT)) )
-    {}
-    UART_PutData(BOARD_DEBUG_UART_PORT, (uint8_t)(c));
+    LOG_Port_Putc((uint8_t)(c));
     return c;
 }
 
@@ -68,8 +70,6 @@ int fgetc(FILE *f)
  */
 int _write(int fd, char *ptr, int len)
 {
-    int i = 0;
-
     /*
      * write "len" of char from "ptr" to file id "fd"
      * Return number of char written.
@@ -81,16 +81,10 @@ int _write(int fd, char *ptr, int len)
         return -1;
     }
 
-    while (*ptr && (i < len))
-    {
-        while ( 0u == (UART_STATUS_TX_EMPTY & UART_GetStatus(BOARD_DEBUG_UART_PORT)) )
-        {}
-        UART_PutData(BOARD_DEBUG_UART_PORT, (uint8_t)(*ptr));
-        i++;
-        ptr++;
-    }
+    /* queued in one piece, or dropped when the ring is full. */
+    (void)LOG_Port_Write((const uint8_t *)ptr, (uint32_t)len);
 
-    return i;
+    return len;
 }
 
 /*
@@ -130,9 +124,7 @@ int _read(int fd, char *ptr, int len)
 
 int putchar(int c)
 {
-    while ( 0u == (UART_STATUS_TX_EMPTY & UART_GetStatus(BOARD_DEBUG_UART_PORT)) )
-    {}
-    UART_PutData(BOARD_DEBUG_UART_PORT, (uint8_t)(c));
+    LOG_Port_Putc((uint8_t)(c));
     return c;
 }
 
@@ -148,9 +140,7 @@ int getchar(void)
 
 int fputc(int ch, FILE *f)
 {
-    while ( 0u == (UART_STATUS_TX_EMPTY & UART_GetStatus(BOARD_DEBUG_UART_PORT)) )
-    {}
-    UART_PutData(BOARD_DEBUG_UART_PORT, (uint8_t)(ch));
+    LOG_Port_Putc((uint8_t)(ch));
     return ch;
 }
 
@@ -1,5 +1,11 @@
 #include "board_it.h"
 #include "board_init.h"
+#ifdef APP_FREERTOS
+#include "FreeRTOS.h"
+#include "task.h"
+
+extern void xPortSysTickHandler(void);
+#endif
 static uint64_t SysRunTimeMs = 0;
 static uint8_t fac_us = 0;
 static uint32_t fac_ms = 0;
@@ -30,6 +36,14 @@ void SysTick_Init(void)
 void SysTick_Handler(void)
 {
   SysRunTimeMs++;
+
+#ifdef APP_FREERTOS
+  /* the kernel reprograms SysTick to its own 1 kHz tick when it starts. */
+  if (xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED)
+  {
+    xPortSysTickHandler();
+  }
+#endif
 }
 
 uint32_t GetSysRunTimeMs(void)
@@ -101,3 +115,27 @@ void delay_ms(uint16_t nms)
     }
 }
 
+/* DWT cycle counter, used for profiling. */
+void CycleCounter_Init(void)
+{
+    DCB->DEMCR |= DCB_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+uint32_t GetCycleCount(void)
+{
+    return DWT->CYCCNT;
+}
+
+uint32_t GetCycleCountFreq(void)
+{
+    return CLOCK_SYS_FREQ;
+}
+
+/* Sleeps until the next interrupt, SysTick wakes us at least every millisecond. */
+void WaitForInterrupt(void)
+{
+    __WFI();
+}
+
@@ -9,6 +9,10 @@ void SysTick_Handler(void);
 uint32_t GetSysRunTimeMs(void);
 void delay_us(uint16_t nus);
 void delay_ms(uint16_t nms);
+void CycleCounter_Init(void);
+uint32_t GetCycleCount(void);
+uint32_t GetCycleCountFreq(void);
+void WaitForInterrupt(void);
 #ifdef __cplusplus
 }
 #endif
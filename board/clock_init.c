@@ -36,6 +36,10 @@ void BOARD_InitBootClocks(void)
     RCC_EnableAHB1Periphs(RCC_AHB1_PERIPH_DMA1, true);
     RCC_ResetAHB1Periphs(RCC_AHB1_PERIPH_DMA1);
 
+    /* DMA2. */
+    RCC_EnableAHB1Periphs(RCC_AHB1_PERIPH_DMA2, true);
+    RCC_ResetAHB1Periphs(RCC_AHB1_PERIPH_DMA2);
+
     /* GPIOA. */
     RCC_EnableAHB1Periphs(RCC_AHB1_PERIPH_GPIOA, true);
     RCC_ResetAHB1Periphs(RCC_AHB1_PERIPH_GPIOA);
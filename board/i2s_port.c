@@ -1,12 +1,69 @@
 #include "i2s_port.h"
-#include "wav.h"
+#include "board_it.h"
+#include "audio.h"
+#ifdef APP_FREERTOS
+#include "FreeRTOS.h"
+#include "task.h"
 
-uint8_t I2S_DMA_Finish  = 1;
+#define I2S_RING_NOTIFY_INDEX   1u          /* task notification the dma interrupt gives. */
+#define I2S_RING_WAIT_MS        10u         /* bounds the wait of a task that registers late. */
+#endif
+
+typedef struct
+{
+    volatile uint32_t WriteCount;   /* slots queued, producer only. */
+    volatile uint32_t ReadCount;    /* slots played, dma interrupt only. */
+    volatile uint8_t  Running;      /* the circular dma is on. */
+    volatile uint8_t  Flushing;     /* end of stream, running dry stops the dma. */
+    volatile uint8_t  Silent[I2S_RING_SLOT_NUM];    /* zeroed by I2S_Ring_Silence(), not committed since. */
+    uint32_t          Underruns;
+#ifdef APP_FREERTOS
+    TaskHandle_t volatile Waiter;   /* the last task in I2S_Ring_Wait(), woken by every half. */
+#endif
+} I2S_Ring_Type;
+
+DTCM_RAM static __ALIGNED(4) uint16_t I2S_Ring_Buffer[I2S_RING_SLOT_NUM][I2S_RING_SLOT_SIZE];   /* slots take 32-bit stores. */
+static I2S_Ring_Type     I2S_Ring;
 
 extern uint8_t AUDIO_PlayState;
 extern uint8_t AUDIO_Extension;
 
 
+/* Picks the divider whose rate is nearest to SampleRate, see I2S_Clock_Plan_Type. */
+void I2S_ClockPlan(uint32_t SampleRate, I2S_Clock_Plan_Type *Plan)
+{
+    uint32_t Div, Last;
+    uint64_t Mclk;
+    int64_t  Ppm, Best = INT64_MAX;
+
+    memset(Plan, 0, sizeof(I2S_Clock_Plan_Type));
+    Plan->Requested = SampleRate;
+
+    if(SampleRate == 0u)
+    {
+        return;
+    }
+
+    /* the exact ratio lies between Div and Div + 1, fs falls as Div grows. */
+    Div  = CLOCK_APB1_FREQ / (I2S_CLOCK_MCLK_RATIO * SampleRate);
+    Div  = (Div < 1u) ? 1u : ((Div > I2S_CLOCK_DIV_MAX) ? I2S_CLOCK_DIV_MAX : Div);
+    Last = (Div < I2S_CLOCK_DIV_MAX) ? (Div + 1u) : Div;
+
+    for(; Div <= Last; Div++)
+    {
+        Mclk = (uint64_t)I2S_CLOCK_MCLK_RATIO * Div * SampleRate;
+        Ppm  = ((int64_t)CLOCK_APB1_FREQ - (int64_t)Mclk) * 1000000 / (int64_t)Mclk;
+
+        if(((Ppm < 0) ? -Ppm : Ppm) < Best)
+        {
+            Best           = (Ppm < 0) ? -Ppm : Ppm;
+            Plan->Div      = Div;
+            Plan->Actual   = CLOCK_APB1_FREQ / (I2S_CLOCK_MCLK_RATIO * Div);
+            Plan->ErrorPpm = (int32_t)Ppm;
+        }
+    }
+}
+
 void I2S_Configure(I2S_Protocol_Type   Standard,
                          I2S_DataWidth_Type DataFormat,
                          uint32_t AudioFreq,
@@ -14,9 +71,13 @@ void I2S_Configure(I2S_Protocol_Type   Standard,
 {
     /* Setup the I2S. */
     I2S_Master_Init_Type i2s_master_init;
+    I2S_Clock_Plan_Type  Plan;
+
+    /* the driver truncates APB1 / (256 fs), from the planned rate that is the planned divider. */
+    I2S_ClockPlan(AudioFreq, &Plan);
 		
     i2s_master_init.ClockFreqHz  = CLOCK_APB1_FREQ;
-    i2s_master_init.SampleRate   = AudioFreq;
+    i2s_master_init.SampleRate   = Plan.Actual;
     i2s_master_init.DataWidth    = DataFormat;
     i2s_master_init.Protocol     = Standard;
     i2s_master_init.EnableMCLK   = true;
@@ -40,18 +101,174 @@ void I2S_DMA_Transfer(uint16_t *Buffer, uint32_t BufferSize)
     dma_channel_init.Priority          = DMA_Priority_Highest;
     dma_channel_init.XferCount         = BufferSize;
     dma_channel_init.XferMode          = DMA_XferMode_MemoryToPeriph;
-    dma_channel_init.ReloadMode        = DMA_ReloadMode_AutoReload;             /* DMA_AutoReloadMode_Circular */
+    dma_channel_init.ReloadMode        = DMA_ReloadMode_AutoReloadContinuous;   /* circular, runs until disabled. */
     dma_channel_init.XferWidth         = DMA_XferWidth_16b;
     DMA_InitChannel(DMA1, DMA_REQ_DMA1_SPI2_TX, &dma_channel_init);
 	
     /* Enable DMA transfer done interrupt. */
     DMA_EnableChannelInterrupts(DMA1, DMA_REQ_DMA1_SPI2_TX, DMA_CHN_INT_XFER_DONE, true);
 		DMA_EnableChannelInterrupts(DMA1, DMA_REQ_DMA1_SPI2_TX, DMA_CHN_INT_XFER_HALF_DONE, true);
+    NVIC_SetPriority(DMA1_CH5_IRQn, I2S_DMA_IRQ_PRIO);
     NVIC_EnableIRQ(DMA1_CH5_IRQn);
 	
 		DMA_EnableChannel(DMA1, DMA_REQ_DMA1_SPI2_TX, true);
 }
 
+/*
+ * Silences the slots of the half now on the dma that the producer never queued,
+ * the one at WriteCount included: a producer that has stalled before filling it
+ * would otherwise replay the frame it held a lap ago. Slots still silent from an
+ * earlier underrun are skipped, so a long stall only clears each slot once.
+ */
+static void I2S_Ring_Silence(void)
+{
+    uint32_t Write = I2S_Ring.WriteCount;
+    uint32_t Slot  = I2S_Ring.ReadCount;
+    uint32_t End   = I2S_Ring.ReadCount + I2S_RING_HALF_NUM;
+    uint32_t Index;
+
+    if((int32_t)(Write - Slot) >= 0)
+    {
+        Slot = Write;
+    }
+
+    for(; Slot != End; Slot++)
+    {
+        Index = Slot % I2S_RING_SLOT_NUM;
+        if(I2S_Ring.Silent[Index] == 0u)
+        {
+            memset(I2S_Ring_Buffer[Index], 0, I2S_RING_SLOT_SIZE * sizeof(uint16_t));
+            I2S_Ring.Silent[Index] = 1u;
+        }
+    }
+}
+
+/* One half of the ring has been sent and the dma has moved on to the other half. */
+static void I2S_Ring_Advance(void)
+{
+    I2S_Ring.ReadCount += I2S_RING_HALF_NUM;
+
+    /* the half now playing has not been queued in full. */
+    if((int32_t)(I2S_Ring.WriteCount - I2S_Ring.ReadCount) < (int32_t)I2S_RING_HALF_NUM)
+    {
+        I2S_Ring_Silence();
+
+        if(I2S_Ring.Flushing == 1)
+        {
+            DMA_EnableChannel(DMA1, DMA_REQ_DMA1_SPI2_TX, false);
+            I2S_Ring.Running = 0;
+        }
+        else
+        {
+            I2S_Ring.Underruns++;
+        }
+    }
+}
+
+/* Starts the circular transfer over the whole ring, the first half first. */
+static void I2S_Ring_Start(void)
+{
+    I2S_Ring.Running = 1;
+    I2S_DMA_Transfer(&I2S_Ring_Buffer[0][0], I2S_RING_SLOT_NUM * I2S_RING_SLOT_SIZE);
+}
+
+void I2S_Ring_Reset(void)
+{
+    DMA_EnableChannel(DMA1, DMA_REQ_DMA1_SPI2_TX, false);
+    memset(&I2S_Ring, 0, sizeof(I2S_Ring));
+
+#ifdef APP_FREERTOS
+    if(xTaskGetSchedulerState() == taskSCHEDULER_RUNNING)
+    {
+        I2S_Ring.Waiter = xTaskGetCurrentTaskHandle();
+    }
+#endif
+}
+
+/*
+ * Sleeps until the dma hands back a half of the ring, or another interrupt
+ * comes in; callers test their condition again. With FreeRTOS the calling
+ * task blocks instead. Its handle stays registered, so a half that completes
+ * between the caller's test and the next wait is not missed.
+ */
+void I2S_Ring_Wait(void)
+{
+#ifdef APP_FREERTOS
+    if(xTaskGetSchedulerState() == taskSCHEDULER_RUNNING)
+    {
+        I2S_Ring.Waiter = xTaskGetCurrentTaskHandle();
+        ulTaskNotifyTakeIndexed(I2S_RING_NOTIFY_INDEX, pdTRUE, pdMS_TO_TICKS(I2S_RING_WAIT_MS));
+        return;
+    }
+#endif
+    WaitForInterrupt();
+}
+
+/* Next free slot, NULL while all slots are queued. */
+uint16_t *I2S_Ring_GetWriteSlot(void)
+{
+    /* the dma has caught up with the producer: continue in the half it will play next. */
+    if((I2S_Ring.Running == 1) &&
+       ((int32_t)(I2S_Ring.WriteCount - I2S_Ring.ReadCount) < (int32_t)I2S_RING_HALF_NUM))
+    {
+        I2S_Ring.WriteCount = I2S_Ring.ReadCount + I2S_RING_HALF_NUM;
+    }
+
+    if((I2S_Ring.WriteCount - I2S_Ring.ReadCount) >= I2S_RING_SLOT_NUM)
+    {
+        return NULL;
+    }
+    return I2S_Ring_Buffer[I2S_Ring.WriteCount % I2S_RING_SLOT_NUM];
+}
+
+/* Queues the slot from I2S_Ring_GetWriteSlot(), the dma starts once the ring is full. */
+void I2S_Ring_Commit(void)
+{
+    /* cleared before the count moves, an underrun in between silences the slot again. */
+    I2S_Ring.Silent[I2S_Ring.WriteCount % I2S_RING_SLOT_NUM] = 0u;
+    I2S_Ring.WriteCount++;
+
+    if((I2S_Ring.Running == 0) && ((I2S_Ring.WriteCount - I2S_Ring.ReadCount) >= I2S_RING_SLOT_NUM))
+    {
+        I2S_Ring_Start();
+    }
+}
+
+/* End of stream: pads the last half with silence, the dma stops after playing it. */
+void I2S_Ring_Flush(void)
+{
+    uint16_t *Slot;
+
+    I2S_Ring.Flushing = 1;
+
+    while((I2S_Ring.WriteCount % I2S_RING_HALF_NUM) != 0u)
+    {
+        while((Slot = I2S_Ring_GetWriteSlot()) == NULL)
+        {
+            I2S_Ring_Wait();
+        }
+        memset(Slot, 0, I2S_RING_SLOT_SIZE * sizeof(uint16_t));
+        I2S_Ring.WriteCount++;
+    }
+
+    /* shorter than the ring, never started. */
+    if((I2S_Ring.Running == 0) && (I2S_Ring.WriteCount != I2S_Ring.ReadCount))
+    {
+        I2S_Ring_Start();
+    }
+}
+
+bool I2S_Ring_Busy(void)
+{
+    return (I2S_Ring.Running == 1);
+}
+
+void I2S_Ring_GetStats(I2S_Ring_Stats_Type *Stats)
+{
+    Stats->Played    = I2S_Ring.ReadCount;
+    Stats->Underruns = I2S_Ring.Underruns;
+}
+
 void I2S_PowerON(uint8_t Enable)
 {
     if(Enable == 1) /* Power On */
@@ -66,36 +283,37 @@ void I2S_PowerON(uint8_t Enable)
 
 void DMA1_CH5_IRQHandler(void)
 {
-	
-    if(AUDIO_Extension == 0)    /* wav */
-    {
-			  if (0u != (DMA_CHN_INT_XFER_DONE & DMA_GetChannelInterruptStatus(DMA1, DMA_REQ_DMA1_SPI2_TX)) )
-				{
-					DMA_ClearChannelInterruptStatus(DMA1, DMA_REQ_DMA1_SPI2_TX, DMA_CHN_INT_XFER_DONE);
-					WAV_PlayHandler();
-				}
-				
-				if(0u != (DMA_CHN_INT_XFER_HALF_DONE & DMA_GetChannelInterruptStatus(DMA1, DMA_REQ_DMA1_SPI2_TX)) )
-				{
-					DMA_ClearChannelInterruptStatus(DMA1, DMA_REQ_DMA1_SPI2_TX, DMA_CHN_INT_XFER_HALF_DONE);
-					WAV_PrepareData();
-				}
-    }
-    else                        /* mp3 */
-    {
-			
-			 if (0u != (DMA_CHN_INT_XFER_DONE & DMA_GetChannelInterruptStatus(DMA1, DMA_REQ_DMA1_SPI2_TX)) )
-				{
-					DMA_EnableChannel(DMA1, DMA_REQ_DMA1_SPI2_TX, true);
-					I2S_DMA_Finish = 1;
-					DMA_ClearChannelInterruptStatus(DMA1, DMA_REQ_DMA1_SPI2_TX, DMA_CHN_INT_XFER_DONE);	
-				}
-				
-				if(0u != (DMA_CHN_INT_XFER_HALF_DONE & DMA_GetChannelInterruptStatus(DMA1, DMA_REQ_DMA1_SPI2_TX)) )
-				{
-					DMA_ClearChannelInterruptStatus(DMA1, DMA_REQ_DMA1_SPI2_TX, DMA_CHN_INT_XFER_HALF_DONE);
-				}
+    uint32_t Status = DMA_GetChannelInterruptStatus(DMA1, DMA_REQ_DMA1_SPI2_TX);
+
+    /* first half sent, the dma carries on with the second. */
+    if(0u != (DMA_CHN_INT_XFER_HALF_DONE & Status))
+    {
+        DMA_ClearChannelInterruptStatus(DMA1, DMA_REQ_DMA1_SPI2_TX, DMA_CHN_INT_XFER_HALF_DONE);
+        I2S_Ring_Advance();
+    }
+
+    /* second half sent, the dma has wrapped to the first. */
+    if(0u != (DMA_CHN_INT_XFER_DONE & Status))
+    {
+        DMA_ClearChannelInterruptStatus(DMA1, DMA_REQ_DMA1_SPI2_TX, DMA_CHN_INT_XFER_DONE);
+        I2S_Ring_Advance();
+    }
+
+    /* wav: the free half is refilled, or the file closed, from the main loop. */
+    if(AUDIO_Extension == 0)
+    {
+        AUDIO_PostEvent((I2S_Ring.Running == 1) ? AUDIO_Event_WavRefill : AUDIO_Event_WavFinished);
+    }
+
+#ifdef APP_FREERTOS
+    if(I2S_Ring.Waiter != NULL)
+    {
+        BaseType_t Woken = pdFALSE;
+
+        vTaskNotifyGiveIndexedFromISR(I2S_Ring.Waiter, I2S_RING_NOTIFY_INDEX, &Woken);
+        portYIELD_FROM_ISR(Woken);
     }
+#endif
 }
 
 
@@ -2,7 +2,54 @@
 #define __I2S_PORT_H_
 
 #include "hal_common.h"
+
+/*
+ * Audio output ring: I2S_RING_SLOT_NUM blocks of DMA ready 16-bit stereo PCM in
+ * one contiguous buffer, shared by the WAV and MP3 players. The producer fills
+ * the slot returned by I2S_Ring_GetWriteSlot() and queues it with
+ * I2S_Ring_Commit(). Once the ring is full the DMA plays it in circular mode,
+ * set up once per song: HALF_DONE hands back the first half of the slots and
+ * XFER_DONE the second half while the DMA wraps around to the first.
+ */
+#define I2S_RING_SLOT_NUM       4u                  /* even, the dma works in halves. */
+#define I2S_RING_HALF_NUM       (I2S_RING_SLOT_NUM / 2u)
+#define I2S_RING_SLOT_SIZE      (2u * 1152u)        /* halfwords, one stereo Layer III frame. */
+#define I2S_DMA_IRQ_PRIO        2u                  /* below configMAX_SYSCALL_INTERRUPT_PRIORITY, may notify a task. */
+
+/*
+ * I2S clock plan: with MCLK out the codec runs at 256 fs, divided from APB1 by
+ * an integer, fs = CLOCK_APB1_FREQ / (256 * Div). Few rates come out exact.
+ * I2S_ClockPlan() takes the divider nearest to the requested rate, above or
+ * below it, and I2S_Configure() always programs that divider.
+ */
+#define I2S_CLOCK_MCLK_RATIO    256u
+#define I2S_CLOCK_DIV_MAX       0x1FFu              /* I2SCFGR.I2SDIV, 9 bits. */
+#define I2S_CLOCK_PPM_WARN      3000                /* 0.3 %, about 5 cents of pitch, further off is resampled. */
+
+typedef struct
+{
+    uint32_t Requested;     /* sample rate asked for, Hz. */
+    uint32_t Actual;        /* rate the divider gives, Hz rounded down. */
+    int32_t  ErrorPpm;      /* Actual against Requested, parts per million. */
+    uint32_t Div;           /* 0 for a rate of 0, nothing is programmed. */
+} I2S_Clock_Plan_Type;
+
+typedef struct
+{
+    uint32_t Played;        /* slots sent to the codec. */
+    uint32_t Underruns;     /* halves the DMA started before the producer had queued them. */
+} I2S_Ring_Stats_Type;
+
+extern void I2S_ClockPlan(uint32_t SampleRate, I2S_Clock_Plan_Type *Plan);
 extern void I2S_Configure(I2S_Protocol_Type   Standard,I2S_DataWidth_Type DataFormat, uint32_t AudioFreq,I2S_XferMode_Type Mode);
 extern void I2S_DMA_Transfer(uint16_t *Buffer, uint32_t BufferSize);
 extern void I2S_PowerON(uint8_t Enable);
+
+extern void      I2S_Ring_Reset(void);
+extern uint16_t *I2S_Ring_GetWriteSlot(void);
+extern void      I2S_Ring_Commit(void);
+extern void      I2S_Ring_Flush(void);
+extern void      I2S_Ring_Wait(void);
+extern bool      I2S_Ring_Busy(void);
+extern void      I2S_Ring_GetStats(I2S_Ring_Stats_Type *Stats);
 #endif
@@ -0,0 +1,170 @@
+#include "log_port.h"
+#include "board_init.h"
+#include "hal_dma.h"
+
+/* UART1 tx is wired to DMA1 channel 4. */
+#define LOG_PORT_DMA_PORT       DMA1
+#define LOG_PORT_DMA_CHN        DMA_REQ_DMA1_UART1_TX
+#define LOG_PORT_DMA_IRQn       DMA1_CH4_IRQn
+
+typedef struct
+{
+    volatile uint32_t Head;         /* bytes queued, writers only, interrupts masked. */
+    volatile uint32_t Tail;         /* bytes sent, dma done only. */
+    volatile uint32_t InFlight;     /* bytes of the running transfer, 0 while the dma is idle. */
+    uint32_t          Dropped;
+    uint8_t           Ready;        /* dma set up, until then writes are polled. */
+} LOG_Port_Type;
+
+static uint8_t      LOG_Port_Buffer[LOG_PORT_RING_SIZE];
+static LOG_Port_Type LOG_Port;
+
+
+/* Sends the queued bytes up to the end of the buffer, the rest follows from the done interrupt. */
+static void LOG_Port_Start(void)
+{
+    DMA_Channel_Init_Type dma_channel_init;
+    uint32_t Offset = LOG_Port.Tail % LOG_PORT_RING_SIZE;
+    uint32_t Count  = LOG_Port.Head - LOG_Port.Tail;
+
+    if((LOG_Port.InFlight != 0u) || (Count == 0u))
+    {
+        return;
+    }
+    if(Count > (LOG_PORT_RING_SIZE - Offset))
+    {
+        Count = LOG_PORT_RING_SIZE - Offset;
+    }
+
+    dma_channel_init.MemAddr           = (uint32_t)(&LOG_Port_Buffer[Offset]);
+    dma_channel_init.MemAddrIncMode    = DMA_AddrIncMode_IncAfterXfer;
+    dma_channel_init.PeriphAddr        = UART_GetTxDataRegAddr(BOARD_DEBUG_UART_PORT);
+    dma_channel_init.PeriphAddrIncMode = DMA_AddrIncMode_StayAfterXfer;
+    dma_channel_init.Priority          = DMA_Priority_Low;
+    dma_channel_init.XferCount         = Count;
+    dma_channel_init.XferMode          = DMA_XferMode_MemoryToPeriph;
+    dma_channel_init.ReloadMode        = DMA_ReloadMode_OneTime;
+    dma_channel_init.XferWidth         = DMA_XferWidth_8b;
+    DMA_InitChannel(LOG_PORT_DMA_PORT, LOG_PORT_DMA_CHN, &dma_channel_init);
+    DMA_EnableChannelInterrupts(LOG_PORT_DMA_PORT, LOG_PORT_DMA_CHN, DMA_CHN_INT_XFER_DONE, true);
+
+    LOG_Port.InFlight = Count;
+    DMA_EnableChannel(LOG_PORT_DMA_PORT, LOG_PORT_DMA_CHN, true);
+}
+
+/* The running transfer has finished: frees its bytes and starts the next run. Interrupts masked. */
+static void LOG_Port_Done(void)
+{
+    if(0u == (DMA_CHN_INT_XFER_DONE & DMA_GetChannelInterruptStatus(LOG_PORT_DMA_PORT, LOG_PORT_DMA_CHN)))
+    {
+        return;
+    }
+    DMA_ClearChannelInterruptStatus(LOG_PORT_DMA_PORT, LOG_PORT_DMA_CHN, DMA_CHN_INT_XFER_DONE);
+    DMA_EnableChannel(LOG_PORT_DMA_PORT, LOG_PORT_DMA_CHN, false);
+
+    LOG_Port.Tail    += LOG_Port.InFlight;
+    LOG_Port.InFlight = 0u;
+    LOG_Port_Start();
+}
+
+/* Called once the debug UART is enabled. */
+void LOG_Port_Init(void)
+{
+    memset(&LOG_Port, 0, sizeof(LOG_Port));
+
+    UART_EnableDMA(BOARD_DEBUG_UART_PORT, true);
+    NVIC_SetPriority(LOG_PORT_DMA_IRQn, LOG_PORT_DMA_IRQ_PRIO);
+    NVIC_EnableIRQ(LOG_PORT_DMA_IRQn);
+
+    LOG_Port.Ready = 1u;
+}
+
+/*
+ * Queues Len bytes and returns Len, or drops all of them and returns 0 when the
+ * ring has no room. Interrupts are masked only for the copy, so any task or
+ * interrupt may write and the Len bytes are never split by another writer.
+ * A line stays whole only when it comes in one call, see log_port.h; Keil's
+ * fputc() queues a character per call.
+ */
+uint32_t LOG_Port_Write(const uint8_t *Data, uint32_t Len)
+{
+    uint32_t Mask, Offset, Part;
+
+    if(LOG_Port.Ready == 0u)
+    {
+        for(Part = 0u; Part < Len; Part++)
+        {
+            while ( 0u == (UART_STATUS_TX_EMPTY & UART_GetStatus(BOARD_DEBUG_UART_PORT)) )
+            {}
+            UART_PutData(BOARD_DEBUG_UART_PORT, Data[Part]);
+        }
+        return Len;
+    }
+
+    Mask = __get_PRIMASK();
+    __disable_irq();
+
+    if((LOG_PORT_RING_SIZE - (LOG_Port.Head - LOG_Port.Tail)) < Len)
+    {
+        LOG_Port.Dropped += Len;
+        __set_PRIMASK(Mask);
+        return 0u;
+    }
+
+    Offset = LOG_Port.Head % LOG_PORT_RING_SIZE;
+    Part   = ((LOG_PORT_RING_SIZE - Offset) < Len) ? (LOG_PORT_RING_SIZE - Offset) : Len;
+    memcpy(&LOG_Port_Buffer[Offset], Data, Part);
+    memcpy(&LOG_Port_Buffer[0], &Data[Part], Len - Part);
+    LOG_Port.Head += Len;
+
+    LOG_Port_Start();
+    __set_PRIMASK(Mask);
+
+    return Len;
+}
+
+void LOG_Port_Putc(uint8_t Char)
+{
+    (void)LOG_Port_Write(&Char, 1u);
+}
+
+/*
+ * Waits until everything queued has left the UART. Polls the dma itself, so it
+ * also drains with the interrupts off, e.g. in a fault hook before halting.
+ */
+void LOG_Port_Flush(void)
+{
+    uint32_t Mask;
+
+    if(LOG_Port.Ready == 0u)
+    {
+        return;
+    }
+
+    while(LOG_Port.Head != LOG_Port.Tail)
+    {
+        Mask = __get_PRIMASK();
+        __disable_irq();
+        LOG_Port_Done();
+        __set_PRIMASK(Mask);
+    }
+
+    while ( 0u == (UART_STATUS_TX_DONE & UART_GetStatus(BOARD_DEBUG_UART_PORT)) )
+    {}
+}
+
+void LOG_Port_GetStats(LOG_Port_Stats_Type *Stats)
+{
+    Stats->Sent    = LOG_Port.Tail;
+    Stats->Dropped = LOG_Port.Dropped;
+}
+
+void DMA1_CH4_IRQHandler(void)
+{
+    /* a higher priority interrupt may be writing. */
+    uint32_t Mask = __get_PRIMASK();
+
+    __disable_irq();
+    LOG_Port_Done();
+    __set_PRIMASK(Mask);
+}
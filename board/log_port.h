@@ -0,0 +1,32 @@
+#ifndef __LOG_PORT_H_
+#define __LOG_PORT_H_
+
+#include "hal_common.h"
+
+/*
+ * Debug console output ring: printf (fputc / _write) copies into a
+ * LOG_PORT_RING_SIZE byte buffer and returns, the UART tx DMA sends it in the
+ * background, one contiguous run per transfer. A write that does not fit is
+ * dropped whole and counted, the caller never waits for the UART. Bytes
+ * written before LOG_Port_Init() go out polled.
+ *
+ * One write is never interleaved with another writer's. How much of a printf
+ * that covers depends on the C library: newlib passes _write() whole stdio
+ * buffers, Keil's fputc() a single character, so with Keil lines from
+ * different tasks or interrupts can mix.
+ */
+#define LOG_PORT_RING_SIZE      2048u               /* power of two, ~180 ms of 115200 baud. */
+#define LOG_PORT_DMA_IRQ_PRIO   4u                  /* below the audio and sd dma, makes no kernel calls. */
+
+typedef struct
+{
+    uint32_t Sent;          /* bytes handed to the UART. */
+    uint32_t Dropped;       /* bytes dropped with the ring full. */
+} LOG_Port_Stats_Type;
+
+extern void     LOG_Port_Init(void);
+extern uint32_t LOG_Port_Write(const uint8_t *Data, uint32_t Len);
+extern void     LOG_Port_Putc(uint8_t Char);
+extern void     LOG_Port_Flush(void);
+extern void     LOG_Port_GetStats(LOG_Port_Stats_Type *Stats);
+#endif
@@ -9,6 +9,11 @@
 #include "board_init.h"
 #include "sdspi.h"
 #include "hal_spi.h"
+#include "hal_dma.h"
+#ifdef APP_FREERTOS
+#include "FreeRTOS.h"
+#include "task.h"
+#endif
 
 /* pins:
  * tx : PC12/SPI_MOSI
@@ -29,6 +34,20 @@
 #define BOARD_SDSPI_CS_GPIO_PORT  GPIOA
 #define BOARD_SDSPI_CS_GPIO_PIN   GPIO_PIN_15
 
+/* transfers of at least this many bytes (data blocks) go through DMA2,
+ * the short command and response exchanges are polled byte by byte. */
+#define BOARD_SDSPI_DMA_MIN_LEN   64u
+
+#define BOARD_SDSPI_DMA_PORT      DMA2
+#define BOARD_SDSPI_DMA_RX_CHN    DMA_REQ_DMA2_SPI3_RX
+#define BOARD_SDSPI_DMA_TX_CHN    DMA_REQ_DMA2_SPI3_TX
+#define BOARD_SDSPI_DMA_RX_IRQn   DMA2_CH1_IRQn
+#define BOARD_SDSPI_DMA_IRQ_PRIO  2u        /* below configMAX_SYSCALL_INTERRUPT_PRIORITY, may notify a task. */
+
+#ifdef APP_FREERTOS
+#define BOARD_SDSPI_NOTIFY_INDEX  2u        /* task notification the rx done interrupt gives. */
+#endif
+
 SDSPI_ApiRetStatus_Type sdspi_spi_init(void);
 SDSPI_ApiRetStatus_Type sdspi_spi_freq(uint32_t hz);
 SDSPI_ApiRetStatus_Type sdspi_spi_xfer(uint8_t *in, uint8_t *out, uint32_t len);
@@ -43,6 +62,13 @@ const SDSPI_Interface_Type board_sdspi_if =
 
 uint32_t board_sdspi_delay_count;
 
+static const uint8_t board_sdspi_dma_dummy = SDSPI_DUMMY_DATA; /* tx source when there is no data to send. */
+static uint8_t board_sdspi_dma_sink;                           /* rx sink when the data is not wanted. */
+static volatile uint8_t board_sdspi_dma_done;
+#ifdef APP_FREERTOS
+static TaskHandle_t volatile board_sdspi_dma_waiter;          /* task blocked on the transfer, NULL while polling. */
+#endif
+
 static void board_sdspi_delay(uint32_t count)
 {
     for (uint32_t i = count; i > 0u; i--)
@@ -70,6 +96,10 @@ SDSPI_ApiRetStatus_Type sdspi_spi_init(void)
 	
     /* Enable SPI. */
     SPI_Enable(SPI3, true);
+
+    /* DMA2 rx done ends a bulk transfer. */
+    NVIC_SetPriority(BOARD_SDSPI_DMA_RX_IRQn, BOARD_SDSPI_DMA_IRQ_PRIO);
+    NVIC_EnableIRQ(BOARD_SDSPI_DMA_RX_IRQn);
 	
 
 //    board_sdspi_delay_count = 100u;
@@ -174,11 +204,104 @@ void spi_assert_cs(bool enable)
     GPIO_WriteBit(BOARD_SDSPI_CS_GPIO_PORT, BOARD_SDSPI_CS_GPIO_PIN, (enable ? 0u: 1u) );
 }
 
+static void board_sdspi_dma_init(uint32_t channel, DMA_XferMode_Type mode, uint32_t periph, uint8_t *mem, bool inc, uint32_t len)
+{
+    DMA_Channel_Init_Type dma_channel_init;
+
+    dma_channel_init.MemAddr           = (uint32_t)mem;
+    dma_channel_init.MemAddrIncMode    = inc ? DMA_AddrIncMode_IncAfterXfer : DMA_AddrIncMode_StayAfterXfer;
+    dma_channel_init.PeriphAddr        = periph;
+    dma_channel_init.PeriphAddrIncMode = DMA_AddrIncMode_StayAfterXfer;
+    dma_channel_init.Priority          = (mode == DMA_XferMode_PeriphToMemory) ? DMA_Priority_Highest : DMA_Priority_High; /* drain rx before feeding tx. */
+    dma_channel_init.XferCount         = len;
+    dma_channel_init.XferMode          = mode;
+    dma_channel_init.ReloadMode        = DMA_ReloadMode_OneTime;
+    dma_channel_init.XferWidth         = DMA_XferWidth_8b;
+    DMA_InitChannel(BOARD_SDSPI_DMA_PORT, channel, &dma_channel_init);
+}
+
+/* Full duplex block transfer, tx from in (or 0xFF) and rx into out (or discarded). */
+static void sdspi_spi_xfer_dma(uint8_t *in, uint8_t *out, uint32_t len)
+{
+    board_sdspi_dma_done = 0u;
+#ifdef APP_FREERTOS
+    /* set before the dma starts, the interrupt then cannot miss the waiter. */
+    if (xTaskGetSchedulerState() == taskSCHEDULER_RUNNING)
+    {
+        board_sdspi_dma_waiter = xTaskGetCurrentTaskHandle();
+    }
+#endif
+
+    board_sdspi_dma_init(BOARD_SDSPI_DMA_RX_CHN, DMA_XferMode_PeriphToMemory, SPI_GetRxDataRegAddr(SPI3),
+                         (out == NULL) ? &board_sdspi_dma_sink : out, (out != NULL), len);
+    board_sdspi_dma_init(BOARD_SDSPI_DMA_TX_CHN, DMA_XferMode_MemoryToPeriph, SPI_GetTxDataRegAddr(SPI3),
+                         (in == NULL) ? (uint8_t *)&board_sdspi_dma_dummy : in, (in != NULL), len);
+    DMA_EnableChannelInterrupts(BOARD_SDSPI_DMA_PORT, BOARD_SDSPI_DMA_RX_CHN, DMA_CHN_INT_XFER_DONE, true);
+
+    /* rx is armed before tx, so no received byte can be missed. */
+    DMA_EnableChannel(BOARD_SDSPI_DMA_PORT, BOARD_SDSPI_DMA_RX_CHN, true);
+    DMA_EnableChannel(BOARD_SDSPI_DMA_PORT, BOARD_SDSPI_DMA_TX_CHN, true);
+    SPI_EnableDMA(SPI3, true);
+
+#ifdef APP_FREERTOS
+    /* block the calling task, the other tasks decode in the meantime. */
+    if (xTaskGetSchedulerState() == taskSCHEDULER_RUNNING)
+    {
+        while (board_sdspi_dma_done == 0u)
+        {
+            ulTaskNotifyTakeIndexed(BOARD_SDSPI_NOTIFY_INDEX, pdTRUE, portMAX_DELAY);
+        }
+        board_sdspi_dma_waiter = NULL;
+    }
+#endif
+
+    /* sleep until the last byte is in. WFI also wakes for an interrupt that is
+     * pending while masked, so testing the flag with interrupts off cannot miss
+     * the rx done interrupt, and the i2s interrupts still run in between. */
+    __disable_irq();
+    while (board_sdspi_dma_done == 0u)
+    {
+        __WFI();
+        __enable_irq();
+        __disable_irq();
+    }
+    __enable_irq();
+
+    SPI_EnableDMA(SPI3, false);
+    DMA_EnableChannel(BOARD_SDSPI_DMA_PORT, BOARD_SDSPI_DMA_TX_CHN, false);
+    DMA_EnableChannel(BOARD_SDSPI_DMA_PORT, BOARD_SDSPI_DMA_RX_CHN, false);
+}
+
+void DMA2_CH1_IRQHandler(void)
+{
+    if (0u != (DMA_CHN_INT_XFER_DONE & DMA_GetChannelInterruptStatus(BOARD_SDSPI_DMA_PORT, BOARD_SDSPI_DMA_RX_CHN)) )
+    {
+        DMA_ClearChannelInterruptStatus(BOARD_SDSPI_DMA_PORT, BOARD_SDSPI_DMA_RX_CHN, DMA_CHN_INT_XFER_DONE);
+        board_sdspi_dma_done = 1u;
+
+#ifdef APP_FREERTOS
+        if (board_sdspi_dma_waiter != NULL)
+        {
+            BaseType_t woken = pdFALSE;
+
+            vTaskNotifyGiveIndexedFromISR(board_sdspi_dma_waiter, BOARD_SDSPI_NOTIFY_INDEX, &woken);
+            portYIELD_FROM_ISR(woken);
+        }
+#endif
+    }
+}
+
 SDSPI_ApiRetStatus_Type sdspi_spi_xfer(uint8_t *in, uint8_t *out, uint32_t len)
 {
     uint8_t inbuf, outbuf;
     //spi_assert_cs(true);
 
+    if (len >= BOARD_SDSPI_DMA_MIN_LEN)
+    {
+        sdspi_spi_xfer_dma(in, out, len);
+        return SDSPI_ApiRetStatus_Success;
+    }
+
     for (uint32_t i = 0u; i < len; i++)
     {
         inbuf = (in == NULL) ? SDSPI_DUMMY_DATA: *in++;
@@ -11,6 +11,15 @@
 #include "diskio.h"		/* Declarations of disk functions */
 #include "sdspi.h"
 
+/* Drive 0 is a RAM disk on the host build, see host/ram_disk.c. */
+#ifndef DISKIO_RAM_DISK_ENABLE
+#define DISKIO_RAM_DISK_ENABLE 0
+#endif
+
+#if DISKIO_RAM_DISK_ENABLE
+#include "ram_disk.h"
+#endif
+
 /* Definitions of physical drive number for each drive */
 #define DEV_RAM		0	/* Example: Map Ramdisk to physical drive 0 */
 #define DEV_MMC		1	/* Example: Map MMC/SD card to physical drive 1 */
@@ -33,10 +42,11 @@ DSTATUS disk_status (
 
 	switch (pdrv) {
 	case DEV_RAM :
-		//result = RAM_disk_status();
-
-		// translate the reslut code here
-
+#if DISKIO_RAM_DISK_ENABLE
+		stat = RAM_disk_status();
+#else
+		stat = STA_NOINIT;
+#endif
 		return stat;
 
 	case DEV_MMC :
@@ -72,10 +82,11 @@ DSTATUS disk_initialize (
 
 	switch (pdrv) {
 	case DEV_RAM :
-		//result = RAM_disk_initialize();
-
-		// translate the reslut code here
-
+#if DISKIO_RAM_DISK_ENABLE
+		stat = RAM_disk_initialize();
+#else
+		stat = STA_NOINIT;
+#endif
 		return stat;
 
 	case DEV_MMC :
@@ -119,17 +130,24 @@ DRESULT disk_read (
 
 	switch (pdrv) {
 	case DEV_RAM :
-		// translate the arguments here
-
-		//result = RAM_disk_read(buff, sector, count);
-
-		// translate the reslut code here
-
+#if DISKIO_RAM_DISK_ENABLE
+		res = RAM_disk_read(buff, sector, count);
+#else
+		res = RES_NOTRDY;
+#endif
 		return res;
 
 	case DEV_MMC :
 		// translate the arguments here
-			if(!SDSPI_ReadBlocks(&app_sdspi_card,buff, sector, count))
+			/* a read that continues the last one reuses the open CMD18, others restart it. */
+			if((!app_sdspi_card.streamOpen) || (app_sdspi_card.streamBlock != sector))
+			{
+				if(SDSPI_StreamOpen(&app_sdspi_card, sector))
+				{
+					return RES_ERROR;
+				}
+			}
+			if(!SDSPI_StreamRead(&app_sdspi_card, buff, count))
 			{
 				res = RES_OK;
 			}else{
@@ -175,12 +193,11 @@ DRESULT disk_write (
 
 	switch (pdrv) {
 	case DEV_RAM :
-		// translate the arguments here
-
-		//result = RAM_disk_write(buff, sector, count);
-
-		// translate the reslut code here
-
+#if DISKIO_RAM_DISK_ENABLE
+		res = RAM_disk_write(buff, sector, count);
+#else
+		res = RES_NOTRDY;
+#endif
 		return res;
 
 	case DEV_MMC :
@@ -229,9 +246,11 @@ DRESULT disk_ioctl (
 
 	switch (pdrv) {
 	case DEV_RAM :
-
-		// Process of the command for the RAM drive
-
+#if DISKIO_RAM_DISK_ENABLE
+		res = RAM_disk_ioctl(cmd, buff);
+#else
+		res = RES_NOTRDY;
+#endif
 		return res;
 
 	case DEV_MMC :
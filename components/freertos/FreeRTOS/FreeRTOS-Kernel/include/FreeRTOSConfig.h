@@ -110,10 +110,10 @@
  * See http://www.freertos.org/a00110.html.
  *----------------------------------------------------------*/
  
-/* Cortex M33 port configuration. */
-//#define configENABLE_FPU 1
-//#define configENABLE_MPU 0
-//#define configENABLE_TRUSTZONE 0
+/* Cortex M33 port configuration: GCC/ARM_CM33_NTZ, non-secure only, with the FPU. */
+#define configENABLE_FPU 1
+#define configENABLE_MPU 0
+#define configENABLE_TRUSTZONE 0
 //#define configRUN_FREERTOS_SECURE_ONLY    1
 
 /* Constants related to the behaviour or the scheduler. */
@@ -127,18 +127,20 @@
 
 /* Constants that describe the hardware and memory usage. */
 #define configCPU_CLOCK_HZ			( ( uint32_t ) systemcoreclock )
+/* SysTick stays on HCLK/8 as SysTick_Init() sets it, delay_us() counts in those ticks. */
+#define configSYSTICK_CLOCK_HZ		( configCPU_CLOCK_HZ / 8 )
 #define configMINIMAL_SECURE_STACK_SIZE  ( 512 )
 #define configMAXIMAL_SECURE_STACK_SIZE  ( 1024 )
 #define configMINIMAL_STACK_SIZE	( ( uint16_t ) 128 )
 #define configSUPPORT_DYNAMIC_ALLOCATION        1
-#define configTOTAL_HEAP_SIZE		( ( size_t ) ( 5 * 1024 ) )
+#define configTOTAL_HEAP_SIZE		( ( size_t ) ( 24 * 1024 ) )   /* task stacks and the read-ahead stream, see audio_rtos.h. */
 #define configMAX_TASK_NAME_LEN		( 16 )
 
 //#define secureportNON_SECURE_CALLABLE 1
 
 /* Constants that build features in or out. */
 #define configUSE_MUTEXES										1
-#define configUSE_TICKLESS_IDLE							1
+#define configUSE_TICKLESS_IDLE							0
 #define configUSE_APPLICATION_TASK_TAG			0
 #define configUSE_NEWLIB_REENTRANT					0
 #define configUSE_CO_ROUTINES								0
@@ -146,12 +148,13 @@
 #define configUSE_RECURSIVE_MUTEXES					1
 #define configUSE_QUEUE_SETS								0
 #define configUSE_TASK_NOTIFICATIONS				1
+#define configTASK_NOTIFICATION_ARRAY_ENTRIES	3   /* 0 stream buffers, 1 i2s ring and file reader, 2 sd dma. */
 #define configUSE_TRACE_FACILITY						1
 
 /* Constants that define which hook (callback) functions should be used. */
-#define configUSE_IDLE_HOOK								0
+#define configUSE_IDLE_HOOK								1   /* sleeps with WFI. */
 #define configUSE_TICK_HOOK								0
-#define configUSE_MALLOC_FAILED_HOOK			0
+#define configUSE_MALLOC_FAILED_HOOK			1
 
 /* Constants provided for debugging and optimisation assistance. */
 #define configCHECK_FOR_STACK_OVERFLOW		2
@@ -160,7 +163,7 @@
 
 
 /* Software timer definitions. */
-#define configUSE_TIMERS								1
+#define configUSE_TIMERS								0
 #define configTIMER_TASK_PRIORITY						( configMAX_PRIORITIES-3 )
 #define configTIMER_QUEUE_LENGTH						10
 #define configTIMER_TASK_STACK_DEPTH					( configMINIMAL_STACK_SIZE  )
@@ -176,14 +179,14 @@
 #define INCLUDE_vTaskSuspend									1
 #define INCLUDE_vTaskDelayUntil								1
 #define INCLUDE_vTaskDelay										1
-#define INCLUDE_uxTaskGetStackHighWaterMark		0
+#define INCLUDE_uxTaskGetStackHighWaterMark		1
 #define INCLUDE_xTaskGetIdleTaskHandle				0
 #define INCLUDE_eTaskGetState									1
 #define INCLUDE_xTaskResumeFromISR						0
 #define INCLUDE_xTaskGetCurrentTaskHandle			1
-#define INCLUDE_xTaskGetSchedulerState				0
+#define INCLUDE_xTaskGetSchedulerState				1
 #define INCLUDE_xSemaphoreGetMutexHolder			0
-#define INCLUDE_xTimerPendFunctionCall				1
+#define INCLUDE_xTimerPendFunctionCall				0
 
 /* This demo makes use of one or more example stats formatting functions.  These
  * format the raw data provided by the uxTaskGetSystemState() function in to
@@ -207,7 +210,7 @@
 
 /* The lowest interrupt priority that can be used in a call to a "set priority"
 function. */
-#define configLIBRARY_LOWEST_INTERRUPT_PRIORITY			0x0f
+#define configLIBRARY_LOWEST_INTERRUPT_PRIORITY			( ( 1 << configPRIO_BITS ) - 1 )
 
 /* The highest interrupt priority that can be used by any interrupt service
 routine that makes calls to interrupt safe FreeRTOS API functions.  DO NOT CALL
@@ -230,7 +233,8 @@ header file. */
 standard names. */
 #define vPortSVCHandler SVC_Handler
 #define xPortPendSVHandler PendSV_Handler
-#define xPortSysTickHandler SysTick_Handler
+/* xPortSysTickHandler() is called from board_it.c's SysTick_Handler(), which
+also keeps GetSysRunTimeMs() counting. */
 
 /* The #ifdef guards against the file being included from IAR assembly files. */
 #ifndef __IASMARM__
@@ -45,8 +45,14 @@
 #define _MP3DEC_H
 
 // Must be moved KJ
+#if defined(__arm__) || defined(__ARMCC_VERSION)
+#ifndef __GNUC__
 #define __GNUC__
+#endif
+#ifndef ARM
 #define ARM
+#endif
+#endif
 
 
 #if defined(_WIN32) && !defined(_WIN32_WCE)
@@ -65,6 +71,8 @@
 #
 #elif defined(_OPENWAVE_SIMULATOR) || defined(_OPENWAVE_ARMULATOR)
 #
+#elif defined(__GNUC__)
+#	/* generic C, used by the host build */
 #else
 #error No platform defined. See valid options in mp3dec.h
 #endif
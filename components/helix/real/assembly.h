@@ -267,32 +267,53 @@ static __inline int CLZ(int x)
 	return numZeros;
 }
 
-#elif defined(__GNUC__) && defined(ARM)
+#elif defined(__GNUC__)
 
+/*
+ * generic C versions, used by the host build and by GCC/armclang for Arm
+ * (mp3dec.h defines __GNUC__ and ARM there), which compile these to SMULL,
+ * SMLAL and CLZ. The xmp3_MULSHIFT32/xmp3_FASTABS externals in arm/asmmisc.S
+ * are armasm only and FASTABS there returns its argument unchanged.
+ */
 typedef long long Word64;
 
-#define MULSHIFT32	xmp3_MULSHIFT32
-extern int MULSHIFT32(int x, int y);
+static __inline int MULSHIFT32(int x, int y)
+{
+	return (int)(((Word64)x * y) >> 32);
+}
 
+static __inline int FASTABS(int x) 
+{
+	int sign;
 
-#define FASTABS	xmp3_FASTABS
-int FASTABS(int x);
+	sign = x >> (sizeof(int) * 8 - 1);
+	x ^= sign;
+	x -= sign;
 
+	return x;
+}
 
 static __inline int CLZ(int x)
 {
-	int numZeros;
-
 	if (!x)
 		return (sizeof(int) * 8);
 
-	numZeros = 0;
-	while (!(x & 0x80000000)) {
-		numZeros++;
-		x <<= 1;
-	} 
+	return __builtin_clz((unsigned int)x);
+}
 
-	return numZeros;
+static __inline Word64 MADD64(Word64 sum, int x, int y)
+{
+	return (sum + ((Word64)x * y));
+}
+
+static __inline Word64 SHL64(Word64 x, int n)
+{
+	return (n < 64) ? (Word64)((unsigned long long)x << n) : 0;
+}
+
+static __inline Word64 SAR64(Word64 x, int n)
+{
+	return (n < 64) ? (x >> n) : (x >> 63);
 }
 
 #else
@@ -33,6 +33,7 @@
 # include "timer.h"
 # include "layer12.h"
 # include "layer3.h"
+# include "prof.h"
 
 static
 unsigned long const bitrate_table[5][15] = {
@@ -437,13 +438,22 @@ int mad_header_decode(struct mad_header *header, struct mad_stream *stream)
  */
 int mad_frame_decode(struct mad_frame *frame, struct mad_stream *stream)
 {
+  MAD_PROF_VAR(t)
+  int result = 0;
+
   frame->options = stream->options;
 
   /* header() */
   /* error_check() */
 
-  if (!(frame->header.flags & MAD_FLAG_INCOMPLETE) &&
-      mad_header_decode(&frame->header, stream) == -1)
+  MAD_PROF_START(t);
+
+  if (!(frame->header.flags & MAD_FLAG_INCOMPLETE))
+    result = mad_header_decode(&frame->header, stream);
+
+  MAD_PROF_LAP(MAD_PROF_HEADER, t);
+
+  if (result == -1)
     goto fail;
 
   /* audio_data() */
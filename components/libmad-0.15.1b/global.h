@@ -55,4 +55,23 @@
 #  endif
 # endif
 
+/* placement of the hot paths: the board's scatter file puts these sections in
+   the tightly coupled memories (see DTCM_RAM in hal_common.h), const tables
+   and code are copied there from flash at startup. Code only moves to ITCM
+   with APP_ITCM, its address is still to be confirmed on the board */
+
+# if defined(__GNUC__)
+#  if defined(APP_ITCM)
+#   define MAD_ITCM_CODE	__attribute__((section(".RAM_I1")))
+#  else
+#   define MAD_ITCM_CODE	/* nothing, see APP_ITCM in the scatter file */
+#  endif
+#  define MAD_DTCM_RAM		__attribute__((section(".RAM_D1")))
+#  define MAD_DTCM_CONST	__attribute__((section(".RAM_D1_RO")))
+# else
+#  define MAD_ITCM_CODE		/* nothing */
+#  define MAD_DTCM_RAM		/* nothing */
+#  define MAD_DTCM_CONST	/* nothing */
+# endif
+
 # endif
@@ -34,6 +34,16 @@
  * These tables support decoding up to 4 Huffman code bits at a time.
  */
 
+/*
+ * With OPT_HUFFLUT the decoder uses the flattened tables of hufflut.dat and
+ * these stay in flash, for host/host_mkhuff.c to generate them from.
+ */
+# if defined(OPT_HUFFLUT)
+#  define HUFF_TREE_CONST	/* nothing */
+# else
+#  define HUFF_TREE_CONST	MAD_DTCM_CONST
+# endif
+
 # if defined(__GNUC__) ||  \
     (defined(__STDC_VERSION__) && __STDC_VERSION__ >= 199901)
 #  define PTR(offs, bits)	{ .ptr   = { 0, bits, offs       } }
@@ -49,7 +59,7 @@
 #  endif
 # endif
 
-static
+static HUFF_TREE_CONST
 union huffquad const hufftabA[] = {
   /* 0000 */ PTR(16, 2),
   /* 0001 */ PTR(20, 2),
@@ -89,7 +99,7 @@ union huffquad const hufftabA[] = {
   /* 1    */ V(1, 1, 0, 0, 1)
 };
 
-static
+static HUFF_TREE_CONST
 union huffquad const hufftabB[] = {
   /* 0000 */ V(1, 1, 1, 1, 4),
   /* 0001 */ V(1, 1, 1, 0, 4),
@@ -125,12 +135,12 @@ union huffquad const hufftabB[] = {
 #  endif
 # endif
 
-static
+static HUFF_TREE_CONST
 union huffpair const hufftab0[] = {
   /*      */ V(0, 0, 0)
 };
 
-static
+static HUFF_TREE_CONST
 union huffpair const hufftab1[] = {
   /* 000  */ V(1, 1, 3),
   /* 001  */ V(0, 1, 3),
@@ -142,7 +152,7 @@ union huffpair const hufftab1[] = {
   /* 111  */ V(0, 0, 1)
 };
 
-static
+static HUFF_TREE_CONST
 union huffpair const hufftab2[] = {
   /* 000  */ PTR(8, 3),
   /* 001  */ V(1, 1, 3),
@@ -164,7 +174,7 @@ union huffpair const hufftab2[] = {
   /* 111  */ V(2, 0, 2)
 };
 
-static
+static HUFF_TREE_CONST
 union huffpair const hufftab3[] = {
   /* 000  */ PTR(8, 3),
   /* 001  */ V(1, 0, 3),
@@ -186,7 +196,7 @@ union huffpair const hufftab3[] = {
   /* 111  */ V(2, 0, 2)
 };
 
-static
+static HUFF_TREE_CONST
 union huffpair const hufftab5[] = {
   /* 000  */ PTR(8, 4),
   /* 001  */ V(1, 1, 3),
@@ -220,7 +230,7 @@ union huffpair const hufftab5[] = {
   /* 1    */ V(2, 3, 1)
 };
 
-static
+static HUFF_TREE_CONST
 union huffpair const hufftab6[] = {
   /* 0000 */ PTR(16, 3),
   /* 0001 */ PTR(24, 1),
@@ -258,7 +268,7 @@ union huffpair const hufftab6[] = {
   /* 1    */ V(0, 2, 1)
 };
 
-static
+static HUFF_TREE_CONST
 union huffpair const hufftab7[] = {
   /* 0000 */ PTR(16, 4),
   /* 0001 */ PTR(32, 4),
@@ -345,7 +355,7 @@ union huffpair const hufftab7[] = {
 # if 0
 /* this version saves 8 entries (16 bytes) at the expense of
    an extra lookup in 4 out of 36 cases */
-static
+static HUFF_TREE_CONST
 union huffpair const hufftab8[] = {
   /* 0000 */ PTR(16, 4),
   /* 0001 */ PTR(32, 2),
@@ -423,7 +433,7 @@ union huffpair const hufftab8[] = {
   /* 11   */ V(3, 0, 2),
 };
 # else
-static
+static HUFF_TREE_CONST
 union huffpair const hufftab8[] = {
   /* 0000 */ PTR(16, 4),
   /* 0001 */ PTR(32, 4),
@@ -508,7 +518,7 @@ union huffpair const hufftab8[] = {
 };
 # endif
 
-static
+static HUFF_TREE_CONST
 union huffpair const hufftab9[] = {
   /* 0000 */ PTR(16, 4),
   /* 0001 */ PTR(32, 3),
@@ -580,7 +590,7 @@ union huffpair const hufftab9[] = {
   /* 1    */ V(0, 5, 1)
 };
 
-static
+static HUFF_TREE_CONST
 union huffpair const hufftab10[] = {
   /* 0000 */ PTR(16, 4),
   /* 0001 */ PTR(32, 4),
@@ -718,7 +728,7 @@ union huffpair const hufftab10[] = {
   /* 1    */ V(0, 4, 1)
 };
 
-static
+static HUFF_TREE_CONST
 union huffpair const hufftab11[] = {
   /* 0000 */ PTR(16, 4),
   /* 0001 */ PTR(32, 4),
@@ -854,7 +864,7 @@ union huffpair const hufftab11[] = {
   /* 1    */ V(3, 3, 1)
 };
 
-static
+static HUFF_TREE_CONST
 union huffpair const hufftab12[] = {
   /* 0000 */ PTR(16, 4),
   /* 0001 */ PTR(32, 4),
@@ -982,7 +992,7 @@ union huffpair const hufftab12[] = {
   /* 1    */ V(0, 5, 1)
 };
 
-static
+static HUFF_TREE_CONST
 union huffpair const hufftab13[] = {
   /* 0000 */ PTR(16, 4),
   /* 0001 */ PTR(32, 4),
@@ -1508,7 +1518,7 @@ union huffpair const hufftab13[] = {
   /* 1    */ V(14, 9, 1)
 };
 
-static
+static HUFF_TREE_CONST
 union huffpair const hufftab15[] = {
   /* 0000 */ PTR(16, 4),
   /* 0001 */ PTR(32, 4),
@@ -2016,7 +2026,7 @@ union huffpair const hufftab15[] = {
   /* 1    */ V(0, 15, 1)
 };
 
-static
+static HUFF_TREE_CONST
 union huffpair const hufftab16[] = {
   /* 0000 */ PTR(16, 4),
   /* 0001 */ PTR(32, 4),
@@ -2550,7 +2560,7 @@ union huffpair const hufftab16[] = {
   /* 1    */ V(13, 13, 1)
 };
 
-static
+static HUFF_TREE_CONST
 union huffpair const hufftab24[] = {
   /* 0000 */ PTR(16, 4),
   /* 0001 */ PTR(32, 4),
@@ -3107,3 +3117,7 @@ struct hufftable const mad_huff_pair_table[32] = {
   /* 30 */ { hufftab24, 11, 4 },
   /* 31 */ { hufftab24, 13, 4 }
 };
+
+# if defined(OPT_HUFFLUT)
+#  include "hufflut.dat"
+# endif
@@ -63,4 +63,37 @@ struct hufftable {
 extern union huffquad const *const mad_huff_quad_table[2];
 extern struct hufftable const mad_huff_pair_table[32];
 
+# if defined(OPT_HUFFLUT)
+/*
+ * Flattened tables for III_huffdecode(), generated into hufflut.dat by
+ * host/host_mkhuff.c. A pair table is looked up startbits (at most
+ * HUFFLUT_PAIR_BITS) at a time, then HUFFLUT_NEXT_BITS or fewer per level, so
+ * all but the longest codes take one lookup. Each entry is 16 bits:
+ *
+ *   final:    1 | hlen << 1 | x << 8 | y << 12   (hlen bits of this level used)
+ *   pointer:  0 | bits << 1 | offset << 5        (next level, bits wide)
+ *
+ * The count1 tables are a single HUFFLUT_QUAD_BITS level of hlen << 4 | vwxy.
+ */
+#  define HUFFLUT_PAIR_BITS	8
+#  define HUFFLUT_NEXT_BITS	6
+#  define HUFFLUT_QUAD_BITS	6
+
+#  define HUFFLUT_FINAL(e)	((e) & 0x0001)
+#  define HUFFLUT_HLEN(e)	(((e) >> 1) & 0x000f)
+#  define HUFFLUT_BITS(e)	(((e) >> 1) & 0x000f)
+#  define HUFFLUT_OFFSET(e)	((e) >> 5)
+#  define HUFFLUT_X(e)		(((e) >> 8) & 0x000f)
+#  define HUFFLUT_Y(e)		((e) >> 12)
+
+struct hufflut {
+  unsigned short const *table;
+  unsigned short linbits;
+  unsigned short startbits;
+};
+
+extern unsigned char const mad_huff_quad_lut[2][1 << HUFFLUT_QUAD_BITS];
+extern struct hufflut const mad_huff_pair_lut[32];
+# endif
+
 # endif
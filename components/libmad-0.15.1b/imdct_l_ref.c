@@ -0,0 +1,229 @@
+/*
+ * libmad - MPEG audio decoder library
+ * Copyright (C) 2000-2001 Andre McCurdy <armccurdy@yahoo.co.uk>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * C model of imdct_l_armv8m.S, for ASO_IMDCT builds that cannot run the
+ * assembler version (the host build). The output is bit-identical:
+ *
+ *  - every sum of products is accumulated exactly in 64 bits, so only the
+ *    operands matter, not the order the assembler version adds them in;
+ *  - operand sums such as ct14 = X0 - X11 - X12 wrap at 32 bits, as in
+ *    registers;
+ *  - results are rounded like the "lsrs lo, #28; adc lo, hi, lsl #4" pairs,
+ *    i.e. bits [59..28] plus bit 27.
+ *
+ * The assembler version only computes x[0..8] and x[18..26] of the IMDCT and
+ * windows x[9..17] and x[27..35] from their mirror images, so does this one.
+ */
+
+# ifdef HAVE_CONFIG_H
+#  include "libmad_config.h"
+# endif
+
+# include "global.h"
+
+# include "fixed.h"
+
+# if defined(ASO_IMDCT) && !(defined(__arm__) && defined(__thumb2__))
+
+typedef unsigned long long acc_t;	/* wraps like a register pair */
+
+# define K00  0x0ffc19fd
+# define K01  0x00b2aa3e
+# define K02  0x0fdcf549
+# define K03  0x0216a2a2
+# define K04  0x0f9ee890
+# define K05  0x03768962
+# define K06  0x0f426cb5
+# define K07  0x04cfb0e2
+# define K08  0x0ec835e8
+# define K09  0x061f78aa
+# define K10  0x0e313245
+# define K11  0x07635284
+# define K12  0x0d7e8807
+# define K13  0x0898c779
+# define K14  0x0cb19346
+# define K15  0x09bd7ca0
+# define K16  0x0bcbe352
+# define K17  0x0acf37ad
+
+static
+mad_fixed_t const window_l[18] = {
+  0x00b2aa3e, 0x0216a2a2, 0x03768962, 0x04cfb0e2, 0x061f78aa, 0x07635284,
+  0x0898c779, 0x09bd7ca0, 0x0acf37ad, 0x0bcbe352, 0x0cb19346, 0x0d7e8807,
+  0x0e313245, 0x0ec835e8, 0x0f426cb5, 0x0f9ee890, 0x0fdcf549, 0x0ffc19fd
+};
+
+/* the odd inputs X0 X2 X3 X5 X6 X8 X9 X11 X12 X14 X15 X17 of each remaining output */
+static
+unsigned char const karray_x[12] = {
+  0, 2, 3, 5, 6, 8, 9, 11, 12, 14, 15, 17
+};
+
+enum { CT02, CT07, CT07N, CT05N, CT03, CT05 };
+
+static
+struct {
+  mad_fixed_t k[12];
+  unsigned char ct;	/* partial sum the products are added to */
+  unsigned char x;	/* output index */
+} const karray[12] = {
+  { {  K17, -K13,  K10, -K06, -K05,  K01, -K00,  K04, -K07,  K11,  K12, -K16 }, CT02,   0 },
+  { {  K13,  K07,  K16,  K01,  K10, -K05,  K04, -K11,  K00, -K17,  K06, -K12 }, CT03,   2 },
+  { {  K11,  K17,  K05,  K12, -K01,  K06, -K07,  K00, -K13,  K04, -K16,  K10 }, CT03,   3 },
+  { {  K07,  K00, -K12,  K05, -K16, -K10,  K11, -K17,  K04,  K13,  K01,  K06 }, CT02,   5 },
+  { {  K05,  K10, -K00, -K17,  K07, -K13,  K12,  K06, -K16,  K01, -K11, -K04 }, CT05N,  6 },
+  { {  K01,  K05, -K07, -K11,  K13,  K17, -K16, -K12,  K10,  K06, -K04, -K00 }, CT07N,  8 },
+  { { -K16,  K12, -K11,  K07,  K04, -K00, -K01,  K05, -K06,  K10,  K13, -K17 }, CT05,  18 },
+  { { -K12,  K06,  K17, -K00, -K11,  K04,  K05, -K10,  K01,  K16, -K07, -K13 }, CT07,  20 },
+  { { -K10,  K16,  K04, -K13, -K00,  K07,  K06, -K01, -K12, -K05,  K17,  K11 }, CT07N, 21 },
+  { { -K06, -K01,  K13,  K04,  K17, -K11, -K10, -K16, -K05,  K12,  K00,  K07 }, CT05N, 23 },
+  { { -K04, -K11, -K01,  K16,  K06,  K12,  K13, -K07, -K17, -K00, -K10, -K05 }, CT02,  24 },
+  { { -K00, -K04, -K06, -K10, -K12, -K16, -K17, -K13, -K11, -K07, -K05, -K01 }, CT03,  26 }
+};
+
+# define MUL(x, y)	((acc_t) ((mad_fixed64_t) (mad_fixed_t) (x) *  \
+				  (mad_fixed64_t) (mad_fixed_t) (y)))
+# define NEG(x)		((mad_fixed_t) (0U - (unsigned int) (x)))
+
+/* bits [59..28] of a 64-bit sum, rounded with bit 27 */
+static
+mad_fixed_t round28(acc_t sum)
+{
+  return (mad_fixed_t) (unsigned int) ((sum >> 28) + ((sum >> 27) & 1));
+}
+
+/*
+ * NAME:	imdct36()
+ * DESCRIPTION:	x[0..8] and x[18..26] of the 36-point IMDCT
+ */
+static
+void imdct36(mad_fixed_t const X[18], mad_fixed_t x[36])
+{
+  acc_t ct00, ct01, ct02, ct03, ct04, ct05, ct06, ct07, ct[6];
+  mad_fixed_t s716, ct14, ct15, ct16, ct17, ct18, ct19;
+  unsigned int i, j;
+
+  ct01 = MUL(X[4],  K08) + MUL(X[13], K09);
+  ct00 = MUL(X[4],  K09) + MUL(X[13], -K08);
+
+  s716 = (mad_fixed_t) ((unsigned int) X[7] + (unsigned int) X[16]);
+
+  ct06 = ct01 + MUL(s716, -K08) + MUL(X[1], -K09) + MUL(X[10], K09);
+  ct04 = 0 - ct00 + MUL(X[1], -K08) + MUL(s716, K09) + MUL(X[10], K08);
+
+  ct14 = (mad_fixed_t) ((unsigned int) X[0] - X[11] - X[12]);
+  ct16 = (mad_fixed_t) ((unsigned int) X[8] - X[3]  + X[15]);
+  ct18 = (mad_fixed_t) ((unsigned int) ct14 + ct16);
+  ct15 = (mad_fixed_t) ((unsigned int) X[2] - X[9]  - X[14]);
+  ct17 = (mad_fixed_t) ((unsigned int) X[5] - X[6]  - X[17]);
+  ct19 = (mad_fixed_t) ((unsigned int) ct15 + ct17);
+
+  x[22] = round28(ct06 + MUL(ct18, -K08) + MUL(ct19, K09));
+  x[4]  = round28(ct04 + MUL(ct18,  K09) + MUL(ct19, K08));
+
+  x[7]  = round28(ct06 + MUL(ct14,  K03) + MUL(ct15,  K15) +
+		  MUL(ct16,  K14) + MUL(ct17, -K02));
+  x[1]  = round28(ct04 + MUL(ct14,  K15) + MUL(ct15, -K03) +
+		  MUL(ct17, -K14) + MUL(ct16, -K02));
+
+  x[25] = round28(ct04 + MUL(ct15, -K14) + MUL(ct17, -K03) +
+		  MUL(ct16,  K15) + MUL(ct14, -K02));
+  x[19] = round28(0 - ct06 + MUL(ct14, -K14) + MUL(ct16, -K03) +
+		  MUL(ct17, -K15) + MUL(ct15,  K02));
+
+  ct05 = 0 - ct01 + MUL(X[16], -K14) + MUL(X[7], -K03) +
+	 MUL(X[10],  K02) + MUL(X[1],  K15);
+  ct03 = 0 - ct01 + MUL(X[10], -K15) + MUL(X[16], -K03) +
+	 MUL(X[7],  -K14) + MUL(X[1], -K02);
+  ct07 = 0 - ct00 + MUL(X[1],   K03) + MUL(X[10], -K14) +
+	 MUL(X[16], -K02) + MUL(X[7],  K15);
+  ct02 = ct00 + MUL(X[10], K03) + MUL(X[1], -K14) +
+	 MUL(X[7],  K02) + MUL(X[16], -K15);
+
+  ct[CT02]  = ct02;
+  ct[CT07]  = ct07;
+  ct[CT07N] = 0 - ct07;
+  ct[CT05N] = 0 - ct05;
+  ct[CT03]  = ct03;
+  ct[CT05]  = ct05;
+
+  for (i = 0; i < 12; ++i) {
+    acc_t sum = ct[karray[i].ct];
+
+    for (j = 0; j < 12; ++j)
+      sum += MUL(karray[i].k[j], X[karray_x[j]]);
+
+    x[karray[i].x] = round28(sum);
+  }
+}
+
+/*
+ * NAME:	III_imdct_l()
+ * DESCRIPTION:	perform IMDCT and windowing for long blocks
+ */
+MAD_ITCM_CODE
+void III_imdct_l(mad_fixed_t const X[18], mad_fixed_t z[36],
+		 unsigned int block_type)
+{
+  mad_fixed_t x[36];
+  unsigned int i;
+
+  imdct36(X, x);
+
+  /* x[0..17] */
+
+  if (block_type == 3) {		/* stop block */
+    for (i = 0; i < 6; ++i)
+      z[i] = 0;
+    for (i = 6; i < 9; ++i)
+      z[i] = round28(MUL(window_l[3 * i - 17], x[i]));
+    for (i = 9; i < 12; ++i)
+      z[i] = round28(MUL(window_l[3 * i - 17], NEG(x[17 - i])));
+    for (i = 12; i < 18; ++i)
+      z[i] = NEG(x[17 - i]);
+  }
+  else {
+    for (i = 0; i < 9; ++i)
+      z[i] = round28(MUL(window_l[i], x[i]));
+    for (i = 9; i < 18; ++i)
+      z[i] = round28(MUL(window_l[i], NEG(x[17 - i])));
+  }
+
+  /* x[18..35] */
+
+  if (block_type == 1) {		/* start block */
+    for (i = 18; i < 24; ++i)
+      z[i] = x[i];
+    for (i = 24; i < 27; ++i)
+      z[i] = round28(MUL(window_l[88 - 3 * i], x[i]));
+    for (i = 27; i < 30; ++i)
+      z[i] = round28(MUL(window_l[88 - 3 * i], x[53 - i]));
+    for (i = 30; i < 36; ++i)
+      z[i] = 0;
+  }
+  else {
+    for (i = 18; i < 27; ++i)
+      z[i] = round28(MUL(window_l[35 - i], x[i]));
+    for (i = 27; i < 36; ++i)
+      z[i] = round28(MUL(window_l[35 - i], x[53 - i]));
+  }
+}
+
+# endif
@@ -44,7 +44,13 @@
 # include "frame.h"
 # include "huffman.h"
 # include "layer3.h"
+# include "prof.h"
 
+/* with OPT_HUFFLUT the DTCM holds the larger Huffman tables in its place. */
+# if !defined(OPT_HUFFLUT)
+MAD_DTCM_RAM
+# endif
+__attribute__((aligned(4)))
 unsigned char frame_overlap_buff[2 * 32 * 18 * sizeof(mad_fixed_t)];
 
 /* --- Layer III ----------------------------------------------------------- */
@@ -345,7 +351,7 @@ struct fixedfloat {
  *
  * root_table[3 + x] = 2^(x/4)
  */
-static
+static MAD_DTCM_CONST
 mad_fixed_t const root_table[7] = {
   MAD_F(0x09837f05) /* 2^(-3/4) == 0.59460355750136 */,
   MAD_F(0x0b504f33) /* 2^(-2/4) == 0.70710678118655 */,
@@ -364,7 +370,7 @@ mad_fixed_t const root_table[7] = {
  * cs[i] =    1 / sqrt(1 + c[i]^2)
  * ca[i] = c[i] / sqrt(1 + c[i]^2)
  */
-static
+static MAD_DTCM_CONST
 mad_fixed_t const cs[8] = {
   +MAD_F(0x0db84a81) /* +0.857492926 */, +MAD_F(0x0e1b9d7f) /* +0.881741997 */,
   +MAD_F(0x0f31adcf) /* +0.949628649 */, +MAD_F(0x0fbba815) /* +0.983314592 */,
@@ -372,7 +378,7 @@ mad_fixed_t const cs[8] = {
   +MAD_F(0x0fff964c) /* +0.999899195 */, +MAD_F(0x0ffff8d3) /* +0.999993155 */
 };
 
-static
+static MAD_DTCM_CONST
 mad_fixed_t const ca[8] = {
   -MAD_F(0x083b5fe7) /* -0.514495755 */, -MAD_F(0x078c36d2) /* -0.471731969 */,
   -MAD_F(0x05039814) /* -0.313377454 */, -MAD_F(0x02e91dd1) /* -0.181913200 */,
@@ -387,7 +393,7 @@ mad_fixed_t const ca[8] = {
  * imdct_s[i/even][k] = cos((PI / 24) * (2 *       (i / 2) + 7) * (2 * k + 1))
  * imdct_s[i /odd][k] = cos((PI / 24) * (2 * (6 + (i-1)/2) + 7) * (2 * k + 1))
  */
-static
+static MAD_DTCM_CONST
 mad_fixed_t const imdct_s[6][6] = {
 # include "imdct_s.dat"
 };
@@ -399,7 +405,7 @@ mad_fixed_t const imdct_s[6][6] = {
  *
  * window_l[i] = sin((PI / 36) * (i + 1/2))
  */
-static
+static MAD_DTCM_CONST
 mad_fixed_t const window_l[36] = {
   MAD_F(0x00b2aa3e) /* 0.043619387 */, MAD_F(0x0216a2a2) /* 0.130526192 */,
   MAD_F(0x03768962) /* 0.216439614 */, MAD_F(0x04cfb0e2) /* 0.300705800 */,
@@ -430,7 +436,7 @@ mad_fixed_t const window_l[36] = {
  *
  * window_s[i] = sin((PI / 12) * (i + 1/2))
  */
-static
+static MAD_DTCM_CONST
 mad_fixed_t const window_s[12] = {
   MAD_F(0x0216a2a2) /* 0.130526192 */, MAD_F(0x061f78aa) /* 0.382683432 */,
   MAD_F(0x09bd7ca0) /* 0.608761429 */, MAD_F(0x0cb19346) /* 0.793353340 */,
@@ -447,7 +453,7 @@ mad_fixed_t const window_s[12] = {
  * is_ratio[i] = tan(i * (PI / 12))
  * is_table[i] = is_ratio[i] / (1 + is_ratio[i])
  */
-static
+static MAD_DTCM_CONST
 mad_fixed_t const is_table[7] = {
   MAD_F(0x00000000) /* 0.000000000 */,
   MAD_F(0x0361962f) /* 0.211324865 */,
@@ -465,7 +471,7 @@ mad_fixed_t const is_table[7] = {
  * is_lsf_table[0][i] = (1 / sqrt(sqrt(2)))^(i + 1)
  * is_lsf_table[1][i] = (1 /      sqrt(2)) ^(i + 1)
  */
-static
+static MAD_DTCM_CONST
 mad_fixed_t const is_lsf_table[2][15] = {
   {
     MAD_F(0x0d744fcd) /* 0.840896415 */,
@@ -927,6 +933,34 @@ mad_fixed_t III_requantize(unsigned int value, signed int exp)
 # define MASK1BIT(cache, sz)  \
     ((cache) & (1 << ((sz) - 1)))
 
+/*
+ * OPT_HUFFLUT: codes are looked up in the flattened tables of hufflut.dat, a
+ * whole code in one step for all but the longest, and the cache is topped up
+ * a byte at a time straight from the main data, which the first read leaves
+ * byte aligned. The cache holds at most 31 bits, so it suits a 32-bit long.
+ */
+# if defined(OPT_HUFFLUT)
+#  define REFILL(need)  \
+    while (cachesz < (need)) {  \
+      bitcache   = (bitcache << 8) | *peek.byte++;  \
+      cachesz   += 8;  \
+      bits_left -= 8;  \
+    }
+#  define PAIR_X(pair)	HUFFLUT_X(pair)
+#  define PAIR_Y(pair)	HUFFLUT_Y(pair)
+#  define QUAD_V(quad)	((quad) & 0x08)
+#  define QUAD_W(quad)	((quad) & 0x04)
+#  define QUAD_X(quad)	((quad) & 0x02)
+#  define QUAD_Y(quad)	((quad) & 0x01)
+# else
+#  define PAIR_X(pair)	((pair)->value.x)
+#  define PAIR_Y(pair)	((pair)->value.y)
+#  define QUAD_V(quad)	((quad)->value.v)
+#  define QUAD_W(quad)	((quad)->value.w)
+#  define QUAD_X(quad)	((quad)->value.x)
+#  define QUAD_Y(quad)	((quad)->value.y)
+# endif
+
 /*
  * NAME:	III_huffdecode()
  * DESCRIPTION:	decode Huffman code words of one channel of one granule
@@ -966,15 +1000,24 @@ enum mad_error III_huffdecode(struct mad_bitptr *ptr, mad_fixed_t xr[576],
   /* big_values */
   {
     unsigned int region, rcount;
+# if defined(OPT_HUFFLUT)
+    struct hufflut const *entry;
+    unsigned short const *table;
+# else
     struct hufftable const *entry;
     union huffpair const *table;
+# endif
     unsigned int linbits, startbits, big_values, reqhits;
     mad_fixed_t reqcache[16];
 
     sfbound = xrptr + *sfbwidth++;
     rcount  = channel->region0_count + 1;
 
+# if defined(OPT_HUFFLUT)
+    entry     = &mad_huff_pair_lut[channel->table_select[region = 0]];
+# else
     entry     = &mad_huff_pair_table[channel->table_select[region = 0]];
+# endif
     table     = entry->table;
     linbits   = entry->linbits;
     startbits = entry->startbits;
@@ -989,7 +1032,11 @@ enum mad_error III_huffdecode(struct mad_bitptr *ptr, mad_fixed_t xr[576],
     big_values = channel->big_values;
 
     while (big_values-- && cachesz + bits_left > 0) {
+# if defined(OPT_HUFFLUT)
+      unsigned int pair;
+# else
       union huffpair const *pair;
+# endif
       unsigned int clumpsz, value;
       register mad_fixed_t requantized;
 
@@ -1004,7 +1051,11 @@ enum mad_error III_huffdecode(struct mad_bitptr *ptr, mad_fixed_t xr[576],
 	  else
 	    rcount = 0;  /* all remaining */
 
+# if defined(OPT_HUFFLUT)
+	  entry     = &mad_huff_pair_lut[channel->table_select[++region]];
+# else
 	  entry     = &mad_huff_pair_table[channel->table_select[++region]];
+# endif
 	  table     = entry->table;
 	  linbits   = entry->linbits;
 	  startbits = entry->startbits;
@@ -1021,6 +1072,23 @@ enum mad_error III_huffdecode(struct mad_bitptr *ptr, mad_fixed_t xr[576],
 	++expptr;
       }
 
+# if defined(OPT_HUFFLUT)
+      REFILL(24);
+
+      /* hcod (0..19) */
+
+      clumpsz = startbits;
+      pair    = table[MASK(bitcache, cachesz, clumpsz)];
+
+      while (!HUFFLUT_FINAL(pair)) {
+	cachesz -= clumpsz;
+
+	clumpsz = HUFFLUT_BITS(pair);
+	pair    = table[HUFFLUT_OFFSET(pair) + MASK(bitcache, cachesz, clumpsz)];
+      }
+
+      cachesz -= HUFFLUT_HLEN(pair);
+# else
       if (cachesz < 21) {
 	unsigned int bits;
 
@@ -1043,11 +1111,12 @@ enum mad_error III_huffdecode(struct mad_bitptr *ptr, mad_fixed_t xr[576],
       }
 
       cachesz -= pair->value.hlen;
+# endif
 
       if (linbits) {
 	/* x (0..14) */
 
-	value = pair->value.x;
+	value = PAIR_X(pair);
 
 	switch (value) {
 	case 0:
@@ -1055,11 +1124,15 @@ enum mad_error III_huffdecode(struct mad_bitptr *ptr, mad_fixed_t xr[576],
 	  break;
 
 	case 15:
+# if defined(OPT_HUFFLUT)
+	  REFILL(linbits + 2);
+# else
 	  if (cachesz < linbits + 2) {
 	    bitcache   = (bitcache << 16) | mad_bit_read(&peek, 16);
 	    cachesz   += 16;
 	    bits_left -= 16;
 	  }
+# endif
 
 	  value += MASK(bitcache, cachesz, linbits);
 	  cachesz -= linbits;
@@ -1082,7 +1155,7 @@ enum mad_error III_huffdecode(struct mad_bitptr *ptr, mad_fixed_t xr[576],
 
 	/* y (0..14) */
 
-	value = pair->value.y;
+	value = PAIR_Y(pair);
 
 	switch (value) {
 	case 0:
@@ -1090,11 +1163,15 @@ enum mad_error III_huffdecode(struct mad_bitptr *ptr, mad_fixed_t xr[576],
 	  break;
 
 	case 15:
+# if defined(OPT_HUFFLUT)
+	  REFILL(linbits + 1);
+# else
 	  if (cachesz < linbits + 1) {
 	    bitcache   = (bitcache << 16) | mad_bit_read(&peek, 16);
 	    cachesz   += 16;
 	    bits_left -= 16;
 	  }
+# endif
 
 	  value += MASK(bitcache, cachesz, linbits);
 	  cachesz -= linbits;
@@ -1118,7 +1195,7 @@ enum mad_error III_huffdecode(struct mad_bitptr *ptr, mad_fixed_t xr[576],
       else {
 	/* x (0..1) */
 
-	value = pair->value.x;
+	value = PAIR_X(pair);
 
 	if (value == 0)
 	  xrptr[0] = 0;
@@ -1136,7 +1213,7 @@ enum mad_error III_huffdecode(struct mad_bitptr *ptr, mad_fixed_t xr[576],
 
 	/* y (0..1) */
 
-	value = pair->value.y;
+	value = PAIR_Y(pair);
 
 	if (value == 0)
 	  xrptr[1] = 0;
@@ -1162,14 +1239,32 @@ enum mad_error III_huffdecode(struct mad_bitptr *ptr, mad_fixed_t xr[576],
 
   /* count1 */
   {
+# if defined(OPT_HUFFLUT)
+    unsigned char const *table;
+# else
     union huffquad const *table;
+# endif
     register mad_fixed_t requantized;
 
+# if defined(OPT_HUFFLUT)
+    table = mad_huff_quad_lut[channel->flags & count1table_select];
+# else
     table = mad_huff_quad_table[channel->flags & count1table_select];
+# endif
 
     requantized = III_requantize(1, exp);
 
     while (cachesz + bits_left > 0 && xrptr <= &xr[572]) {
+# if defined(OPT_HUFFLUT)
+      unsigned int quad;
+
+      /* hcod (1..6) */
+
+      REFILL(HUFFLUT_QUAD_BITS + 4);
+
+      quad     = table[MASK(bitcache, cachesz, HUFFLUT_QUAD_BITS)];
+      cachesz -= quad >> 4;
+# else
       union huffquad const *quad;
 
       /* hcod (1..6) */
@@ -1191,6 +1286,7 @@ enum mad_error III_huffdecode(struct mad_bitptr *ptr, mad_fixed_t xr[576],
       }
 
       cachesz -= quad->value.hlen;
+# endif
 
       if (xrptr == sfbound) {
 	sfbound += *sfbwidth++;
@@ -1205,12 +1301,12 @@ enum mad_error III_huffdecode(struct mad_bitptr *ptr, mad_fixed_t xr[576],
 
       /* v (0..1) */
 
-      xrptr[0] = quad->value.v ?
+      xrptr[0] = QUAD_V(quad) ?
 	(MASK1BIT(bitcache, cachesz--) ? -requantized : requantized) : 0;
 
       /* w (0..1) */
 
-      xrptr[1] = quad->value.w ?
+      xrptr[1] = QUAD_W(quad) ?
 	(MASK1BIT(bitcache, cachesz--) ? -requantized : requantized) : 0;
 
       xrptr += 2;
@@ -1228,12 +1324,12 @@ enum mad_error III_huffdecode(struct mad_bitptr *ptr, mad_fixed_t xr[576],
 
       /* x (0..1) */
 
-      xrptr[0] = quad->value.x ?
+      xrptr[0] = QUAD_X(quad) ?
 	(MASK1BIT(bitcache, cachesz--) ? -requantized : requantized) : 0;
 
       /* y (0..1) */
 
-      xrptr[1] = quad->value.y ?
+      xrptr[1] = QUAD_Y(quad) ?
 	(MASK1BIT(bitcache, cachesz--) ? -requantized : requantized) : 0;
 
       xrptr += 2;
@@ -1274,6 +1370,13 @@ enum mad_error III_huffdecode(struct mad_bitptr *ptr, mad_fixed_t xr[576],
 
 # undef MASK
 # undef MASK1BIT
+# undef REFILL
+# undef PAIR_X
+# undef PAIR_Y
+# undef QUAD_V
+# undef QUAD_W
+# undef QUAD_X
+# undef QUAD_Y
 
 /*
  * NAME:	III_reorder()
@@ -2060,7 +2163,7 @@ void imdct36(mad_fixed_t const X[18], mad_fixed_t x[36])
  * NAME:	III_imdct_l()
  * DESCRIPTION:	perform IMDCT and windowing for long blocks
  */
-static
+static MAD_ITCM_CODE
 void III_imdct_l(mad_fixed_t const X[18], mad_fixed_t z[36],
 		 unsigned int block_type)
 {
@@ -2354,6 +2457,9 @@ enum mad_error III_decode(struct mad_bitptr *ptr, struct mad_frame *frame,
 {
   struct mad_header *header = &frame->header;
   unsigned int sfreqi, ngr, gr;
+  MAD_PROF_VAR(t)
+
+  MAD_PROF_START(t);
 
   {
     unsigned int sfreq;
@@ -2407,6 +2513,8 @@ enum mad_error III_decode(struct mad_bitptr *ptr, struct mad_frame *frame,
 	return error;
     }
 
+    MAD_PROF_LAP(MAD_PROF_HUFFMAN, t);
+
     /* joint stereo processing */
 
     if (header->mode == MAD_MODE_JOINT_STEREO && header->mode_extension) {
@@ -2415,6 +2523,8 @@ enum mad_error III_decode(struct mad_bitptr *ptr, struct mad_frame *frame,
 	return error;
     }
 
+    MAD_PROF_LAP(MAD_PROF_STEREO, t);
+
     /* reordering, alias reduction, IMDCT, overlap-add, frequency inversion */
 
     for (ch = 0; ch < nch; ++ch) {
@@ -2426,6 +2536,8 @@ enum mad_error III_decode(struct mad_bitptr *ptr, struct mad_frame *frame,
       if (channel->block_type == 2) {
 	III_reorder(xr[ch], channel, sfbwidth[ch]);
 
+	MAD_PROF_LAP(MAD_PROF_STEREO, t);
+
 # if !defined(OPT_STRICT)
 	/*
 	 * According to ISO/IEC 11172-3, "Alias reduction is not applied for
@@ -2505,6 +2617,8 @@ enum mad_error III_decode(struct mad_bitptr *ptr, struct mad_frame *frame,
 	if (sb & 1)
 	  III_freqinver(sample, sb);
       }
+
+      MAD_PROF_LAP(MAD_PROF_IMDCT, t);
     }
   }
 
@@ -2525,6 +2639,9 @@ int mad_layer_III(struct mad_stream *stream, struct mad_frame *frame)
   struct sideinfo si;
   enum mad_error error;
   int result = 0;
+  MAD_PROF_VAR(t)
+
+  MAD_PROF_START(t);
 
   /* allocate Layer III dynamic structures */
 
@@ -2542,6 +2659,9 @@ int mad_layer_III(struct mad_stream *stream, struct mad_frame *frame)
       stream->error = MAD_ERROR_NOMEM;
       return -1;
     }
+
+    /* as calloc() would; the buffer still holds the previous stream's tail */
+    memset(frame_overlap_buff, 0, sizeof(frame_overlap_buff));
   }
 
   nch = MAD_NCHANNELS(header);
@@ -2646,6 +2766,8 @@ int mad_layer_III(struct mad_stream *stream, struct mad_frame *frame)
 
   /* decode main_data */
 
+  MAD_PROF_LAP(MAD_PROF_SIDEINFO, t);
+
   if (result == 0) {
     error = III_decode(&ptr, frame, &si, nch);
     if (error) {
@@ -2659,6 +2781,8 @@ int mad_layer_III(struct mad_stream *stream, struct mad_frame *frame)
     stream->anc_bitlen = md_len * CHAR_BIT - data_bitlen;
   }
 
+  MAD_PROF_START(t);
+
 # if 0 && defined(DEBUG)
   fprintf(stderr,
 	  "main_data_begin:%u, md_len:%u, frame_free:%u, "
@@ -2696,5 +2820,7 @@ int mad_layer_III(struct mad_stream *stream, struct mad_frame *frame)
     stream->md_len += frame_free;
   }
 
+  MAD_PROF_LAP(MAD_PROF_SIDEINFO, t);
+
   return result;
 }
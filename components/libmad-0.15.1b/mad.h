@@ -340,6 +340,86 @@ mad_fixed_t mad_f_mul_inline(mad_fixed_t x, mad_fixed_t y)
 
 #  define MAD_F_SCALEBITS  MAD_F_FRACBITS
 
+/* --- Armv8-M mainline --------------------------------------------------- */
+
+# elif defined(FPM_ARMV8M)
+
+/*
+ * FPM_ARM for Armv8-M mainline cores (Cortex-M33 class, e.g. STAR-MC1), which
+ * only run Thumb-2: 64-bit SMULL/SMLAL accumulation, the least significant bit
+ * rounded from the bit below it. Same accuracy as FPM_64BIT with OPT_ACCURACY.
+ *
+ * Without an Arm compiler (the host build) the same operations are done in C
+ * with bit-identical results, so host output can be checked against a board.
+ * __asm__ rather than asm, the Keil project builds with -std=c99.
+ */
+#  if defined(__GNUC__) && defined(__arm__) && defined(__thumb2__)
+#   define mad_f_mul(x, y)  \
+    ({ mad_fixed64hi_t __hi;  \
+       mad_fixed64lo_t __lo;  \
+       mad_fixed_t __result;  \
+       __asm__ ("smull	%0, %1, %3, %4\n\t"  \
+		"lsrs	%0, %0, %5\n\t"  \
+		"adc	%2, %0, %1, lsl %6"  \
+		: "=&r" (__lo), "=&r" (__hi), "=r" (__result)  \
+		: "%r" (x), "r" (y),  \
+		  "M" (MAD_F_SCALEBITS), "M" (32 - MAD_F_SCALEBITS)  \
+		: "cc");  \
+       __result;  \
+    })
+
+#   define MAD_F_MLX(hi, lo, x, y)  \
+    __asm__ ("smull	%0, %1, %2, %3"  \
+	     : "=&r" (lo), "=&r" (hi)  \
+	     : "%r" (x), "r" (y))
+
+#   define MAD_F_MLA(hi, lo, x, y)  \
+    __asm__ ("smlal	%0, %1, %2, %3"  \
+	     : "+r" (lo), "+r" (hi)  \
+	     : "%r" (x), "r" (y))
+
+/* no RSC in Thumb-2: hi - 2 * hi - borrow */
+#   define MAD_F_MLN(hi, lo)  \
+    __asm__ ("rsbs	%0, %2, #0\n\t"  \
+	     "sbc	%1, %3, %3, lsl #1"  \
+	     : "=r" (lo), "=r" (hi)  \
+	     : "0" (lo), "1" (hi)  \
+	     : "cc")
+
+#   define mad_f_scale64(hi, lo)  \
+    ({ mad_fixed_t __result;  \
+       __asm__ ("lsrs	%0, %1, %3\n\t"  \
+		"adc	%0, %0, %2, lsl %4"  \
+		: "=&r" (__result)  \
+		: "r" (lo), "r" (hi),  \
+		  "M" (MAD_F_SCALEBITS), "M" (32 - MAD_F_SCALEBITS)  \
+		: "cc");  \
+       __result;  \
+    })
+#  else
+#   define MAD_F_PRODUCT(x, y)  \
+    ((unsigned long long) ((mad_fixed64_t) (x) * (y)))
+
+#   define MAD_F_MLX(hi, lo, x, y)  \
+    ((lo) = (mad_fixed64lo_t) MAD_F_PRODUCT((x), (y)),  \
+     (hi) = (mad_fixed64hi_t) (MAD_F_PRODUCT((x), (y)) >> 32))
+
+/* add the low words, then the high words with the carry out of them */
+#   define MAD_F_MLA(hi, lo, x, y)  \
+    ((hi) = (mad_fixed64hi_t)  \
+     ((mad_fixed64lo_t) (hi) + (mad_fixed64lo_t) (MAD_F_PRODUCT((x), (y)) >> 32) +  \
+      (((lo) += (mad_fixed64lo_t) MAD_F_PRODUCT((x), (y))) <  \
+       (mad_fixed64lo_t) MAD_F_PRODUCT((x), (y)))))
+
+#   define mad_f_scale64(hi, lo)  \
+    ((mad_fixed_t)  \
+     (((lo) >> MAD_F_SCALEBITS) +  \
+      ((mad_fixed64lo_t) (hi) << (32 - MAD_F_SCALEBITS)) +  \
+      (((lo) >> (MAD_F_SCALEBITS - 1)) & 1)))
+#  endif
+
+#  define MAD_F_SCALEBITS  MAD_F_FRACBITS
+
 /* --- MIPS ---------------------------------------------------------------- */
 
 # elif defined(FPM_MIPS)
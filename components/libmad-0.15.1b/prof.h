@@ -0,0 +1,64 @@
+/*
+ * libmad - MPEG audio decoder library
+ * Copyright (C) 2000-2004 Underbit Technologies, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+# ifndef LIBMAD_PROF_H
+# define LIBMAD_PROF_H
+
+/*
+ * Per-stage decode cost accounting.
+ *
+ * With MAD_PROFILE defined the decoder adds the clock ticks spent in each
+ * stage to mad_prof_ticks[]. The application supplies both the counter
+ * array and mad_prof_clock(), a free-running 32-bit counter (DWT CYCCNT on
+ * the target). Without MAD_PROFILE the hooks compile to nothing.
+ */
+
+enum mad_prof_stage {
+  MAD_PROF_HEADER,	/* sync search, header decode */
+  MAD_PROF_SIDEINFO,	/* side info, bit reservoir */
+  MAD_PROF_HUFFMAN,	/* scalefactors, Huffman decode and requantize */
+  MAD_PROF_STEREO,	/* MS/intensity stereo, short block reorder */
+  MAD_PROF_IMDCT,	/* alias reduction, IMDCT, overlap, freq inversion */
+  MAD_PROF_SYNTH,	/* polyphase synthesis */
+
+  MAD_PROF_NSTAGES
+};
+
+typedef unsigned int mad_prof_clock_t;
+
+extern unsigned long long mad_prof_ticks[MAD_PROF_NSTAGES];
+
+mad_prof_clock_t mad_prof_clock(void);
+
+# if defined(MAD_PROFILE)
+#  define MAD_PROF_VAR(t)		mad_prof_clock_t t;
+#  define MAD_PROF_START(t)		((t) = mad_prof_clock())
+#  define MAD_PROF_LAP(stage, t)  \
+    do {  \
+      mad_prof_clock_t now_ = mad_prof_clock();  \
+      mad_prof_ticks[stage] += (mad_prof_clock_t) (now_ - (t));  \
+      (t) = now_;  \
+    } while (0)
+# else
+#  define MAD_PROF_VAR(t)
+#  define MAD_PROF_START(t)		((void) 0)
+#  define MAD_PROF_LAP(stage, t)	((void) 0)
+# endif
+
+# endif
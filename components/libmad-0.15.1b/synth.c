@@ -28,6 +28,7 @@
 # include "fixed.h"
 # include "frame.h"
 # include "synth.h"
+# include "prof.h"
 
 /*
  * NAME:	synth->init()
@@ -102,7 +103,49 @@ void mad_synth_mute(struct mad_synth *synth)
 
 /* possible DCT speed optimization */
 
-# if defined(OPT_SPEED) && defined(MAD_F_MLX)
+# if defined(ASO_DCT32)
+/*
+ * Every DCT multiply is by a constant, so FPM_ARMV8M's SMULL, LSRS, ADC can be
+ * one DSP instruction: for c < 0.5 SMMULR by c << 4 returns bits [59..28] of
+ * x * c rounded with bit 27, as mad_f_mul() does; for c >= 0.5, c << 4 does
+ * not fit, and SMMLAR by (c - 1) << 4 adds the product to x << 32 instead.
+ * Same result bit for bit, and no register pair per product. Other builds
+ * run the C model, for the host to check the output against the board's.
+ */
+#  if !defined(FPM_ARMV8M) || defined(OPT_SSO)
+#   error "ASO_DCT32 needs FPM_ARMV8M without OPT_SSO"
+#  endif
+#  undef OPT_DCTO
+#  if defined(__GNUC__) && defined(__arm__) && defined(__thumb2__) &&  \
+      defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+#   define DCT_MULR(x, k)  \
+    ({ mad_fixed_t __result;  \
+       __asm__ ("smmulr	%0, %1, %2"  \
+		: "=r" (__result)  \
+		: "r" (x), "r" (k));  \
+       __result;  \
+    })
+#   define DCT_MLAR(x, k)  \
+    ({ mad_fixed_t __x = (x), __result;  \
+       __asm__ ("smmlar	%0, %1, %2, %1"  \
+		: "=r" (__result)  \
+		: "r" (__x), "r" (k));  \
+       __result;  \
+    })
+#  else
+#   define DCT_MULR(x, k)  \
+    ((mad_fixed_t) (((unsigned long long) ((mad_fixed64_t) (x) * (k)) +  \
+		     0x80000000ULL) >> 32))
+#   define DCT_MLAR(x, k)  \
+    ((mad_fixed_t) ((((unsigned long long) (x) << 32) +  \
+		     (unsigned long long) ((mad_fixed64_t) (x) * (k)) +  \
+		     0x80000000ULL) >> 32))
+#  endif
+#  define MUL(x, y)  \
+    ((y) >= MAD_F(0x08000000) ?  \
+     DCT_MLAR((x), (mad_fixed_t) ((unsigned int) ((y) - MAD_F(0x10000000)) << 4)) :  \
+     DCT_MULR((x), (mad_fixed_t) ((unsigned int) (y) << 4)))
+# elif defined(OPT_SPEED) && defined(MAD_F_MLX)
 #  define OPT_DCTO
 #  define MUL(x, y)  \
     ({ mad_fixed64hi_t hi;  \
@@ -119,7 +162,7 @@ void mad_synth_mute(struct mad_synth *synth)
  * NAME:	dct32()
  * DESCRIPTION:	perform fast in[32]->out[32] DCT
  */
-static
+static MAD_ITCM_CODE
 void dct32(mad_fixed_t const in[32], unsigned int slot,
 	   mad_fixed_t lo[16][8], mad_fixed_t hi[16][8])
 {
@@ -513,6 +556,20 @@ void dct32(mad_fixed_t const in[32], unsigned int slot,
 
 # undef MUL
 # undef SHIFT
+# undef DCT_MULR
+# undef DCT_MLAR
+
+# if defined(MAD_PROFILE)
+/*
+ * NAME:	synth->dct32()
+ * DESCRIPTION:	dct32() for kernel benchmarks
+ */
+void mad_synth_dct32(mad_fixed_t const in[32], unsigned int slot,
+		     mad_fixed_t lo[16][8], mad_fixed_t hi[16][8])
+{
+  dct32(in, slot, lo, hi);
+}
+# endif
 
 /* third SSO shift and/or D[] optimization preshift */
 
@@ -541,7 +598,7 @@ void dct32(mad_fixed_t const in[32], unsigned int slot,
 #  endif
 # endif
 
-static
+static MAD_DTCM_CONST
 mad_fixed_t const D[17][32] = {
 # include "D.dat"
 };
@@ -554,7 +611,7 @@ void synth_full(struct mad_synth *, struct mad_frame const *,
  * NAME:	synth->full()
  * DESCRIPTION:	perform full frequency PCM synthesis
  */
-static
+static MAD_ITCM_CODE
 void synth_full(struct mad_synth *synth, struct mad_frame const *frame,
 		unsigned int nch, unsigned int ns)
 {
@@ -691,7 +748,7 @@ void synth_full(struct mad_synth *synth, struct mad_frame const *frame,
  * NAME:	synth->half()
  * DESCRIPTION:	perform half frequency PCM synthesis
  */
-static
+static MAD_ITCM_CODE
 void synth_half(struct mad_synth *synth, struct mad_frame const *frame,
 		unsigned int nch, unsigned int ns)
 {
@@ -834,6 +891,7 @@ void mad_synth_frame(struct mad_synth *synth, struct mad_frame const *frame)
   unsigned int nch, ns;
   void (*synth_frame)(struct mad_synth *, struct mad_frame const *,
 		      unsigned int, unsigned int);
+  MAD_PROF_VAR(t)
 
   nch = MAD_NCHANNELS(&frame->header);
   ns  = MAD_NSBSAMPLES(&frame->header);
@@ -851,7 +909,11 @@ void mad_synth_frame(struct mad_synth *synth, struct mad_frame const *frame)
     synth_frame = synth_half;
   }
 
+  MAD_PROF_START(t);
+
   synth_frame(synth, frame, nch, ns);
 
+  MAD_PROF_LAP(MAD_PROF_SYNTH, t);
+
   synth->phase = (synth->phase + ns) % 16;
 }
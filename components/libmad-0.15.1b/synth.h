@@ -66,4 +66,9 @@ void mad_synth_mute(struct mad_synth *);
 
 void mad_synth_frame(struct mad_synth *, struct mad_frame const *);
 
+# if defined(MAD_PROFILE)
+void mad_synth_dct32(mad_fixed_t const [32], unsigned int,
+		     mad_fixed_t [16][8], mad_fixed_t [16][8]);
+# endif
+
 # endif
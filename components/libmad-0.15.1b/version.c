@@ -48,6 +48,8 @@ char const mad_build[] = ""
   "FPM_INTEL "
 # elif defined(FPM_ARM)
   "FPM_ARM "
+# elif defined(FPM_ARMV8M)
+  "FPM_ARMV8M "
 # elif defined(FPM_MIPS)
   "FPM_MIPS "
 # elif defined(FPM_SPARC)
@@ -61,6 +63,9 @@ char const mad_build[] = ""
 # if defined(ASO_IMDCT)
   "ASO_IMDCT "
 # endif
+# if defined(ASO_DCT32)
+  "ASO_DCT32 "
+# endif
 # if defined(ASO_INTERLEAVE1)
   "ASO_INTERLEAVE1 "
 # endif
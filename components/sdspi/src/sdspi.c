@@ -869,8 +869,6 @@ static SDSPI_ApiRetStatus_Type SDSPI_Read(SDSPI_Interface_Type *interface, uint8
     uint16_t timingByte = 0xFFFFU; /* The byte need to be sent as read/write data block timing requirement */
     uint16_t crc = 0U;
 
-    memset(buffer, 0xFFU, size);
-
     /* Wait data token comming */
     do
     {
@@ -886,7 +884,8 @@ static SDSPI_ApiRetStatus_Type SDSPI_Read(SDSPI_Interface_Type *interface, uint8
     {
         return SDSPI_ApiRetStatus_SDSPI_ResponseError;
     }
-    if (interface->spi_xfer(buffer, buffer, size))
+    /* NULL tx clocks out dummy bytes, no need to fill the buffer with them first. */
+    if (interface->spi_xfer(NULL, buffer, size))
     {
         return SDSPI_ApiRetStatus_SDSPI_XferFail;
     }
@@ -1048,6 +1047,7 @@ SDSPI_ApiRetStatus_Type SDSPI_Init(SDSPI_CardHandler_Type *card, const SDSPI_Int
     assert(interface->spi_xfer);
 
     card->interface = (SDSPI_Interface_Type *)interface;
+    card->streamOpen = false;
 
     if (interface->spi_init())
     {
@@ -1157,6 +1157,11 @@ SDSPI_ApiRetStatus_Type SDSPI_ReadBlocks(SDSPI_CardHandler_Type *card, uint8_t *
     uint32_t i;
     uint8_t resp = 0U;
 
+    if (SDSPI_ApiRetStatus_Success != SDSPI_StreamClose(card))
+    {
+        return SDSPI_ApiRetStatus_SDSPI_StopTransFail;
+    }
+
     /* send cmd */
     if (SDSPI_ApiRetStatus_Success !=
         SDSPI_SendCmd(
@@ -1188,6 +1193,80 @@ SDSPI_ApiRetStatus_Type SDSPI_ReadBlocks(SDSPI_CardHandler_Type *card, uint8_t *
     return SDSPI_ApiRetStatus_Success;
 }
 
+/*
+ * The stream keeps one multiple block read (CMD18) open across calls, so reading
+ * a file sequentially costs one command for the whole run instead of a CMD18 and
+ * a CMD12 per call. Any other card access closes it first.
+ */
+SDSPI_ApiRetStatus_Type SDSPI_StreamOpen(SDSPI_CardHandler_Type *card, uint32_t startBlock)
+{
+    assert(card);
+    assert(card->interface);
+
+    uint8_t resp = 0U;
+
+    if (SDSPI_ApiRetStatus_Success != SDSPI_StreamClose(card))
+    {
+        return SDSPI_ApiRetStatus_SDSPI_StopTransFail;
+    }
+
+    if (SDSPI_ApiRetStatus_Success !=
+        SDSPI_SendCmd(
+            card->interface, SDSPI_Cmd_ReadMultiBlock,
+            ((card->cardType & SDSPI_CardType_HighCapacity) == 0U ? (startBlock * card->blockSize) : startBlock),
+            &resp))
+    {
+        return SDSPI_ApiRetStatus_SDSPI_SendCmdFail;
+    }
+
+    card->streamOpen = true;
+    card->streamBlock = startBlock;
+
+    return SDSPI_ApiRetStatus_Success;
+}
+
+SDSPI_ApiRetStatus_Type SDSPI_StreamRead(SDSPI_CardHandler_Type *card, uint8_t *buffer, uint32_t blockCount)
+{
+    assert(card);
+    assert(card->interface);
+    assert(buffer);
+
+    uint32_t i;
+
+    if (!card->streamOpen)
+    {
+        return SDSPI_ApiRetStatus_InvalidArgument;
+    }
+
+    for (i = 0U; i < blockCount; i++)
+    {
+        if (SDSPI_ApiRetStatus_Success != SDSPI_Read(card->interface, buffer, card->blockSize))
+        {
+            /* the position in the stream is lost, the next read has to start over. */
+            SDSPI_StreamClose(card);
+            return SDSPI_ApiRetStatus_SDSPI_ReadFail;
+        }
+        buffer += card->blockSize;
+        card->streamBlock++;
+    }
+
+    return SDSPI_ApiRetStatus_Success;
+}
+
+SDSPI_ApiRetStatus_Type SDSPI_StreamClose(SDSPI_CardHandler_Type *card)
+{
+    assert(card);
+
+    if (!card->streamOpen)
+    {
+        return SDSPI_ApiRetStatus_Success;
+    }
+
+    card->streamOpen = false;
+
+    return SDSPI_StopTrans(card);
+}
+
 SDSPI_ApiRetStatus_Type SDSPI_WriteBlocks(SDSPI_CardHandler_Type *card, uint8_t *buffer, uint32_t startBlock, uint32_t blockCount)
 {
     assert(card);
@@ -1203,6 +1282,11 @@ SDSPI_ApiRetStatus_Type SDSPI_WriteBlocks(SDSPI_CardHandler_Type *card, uint8_t
         return SDSPI_ApiRetStatus_SDSPI_WriteProtected;
     }
 
+    if (SDSPI_ApiRetStatus_Success != SDSPI_StreamClose(card))
+    {
+        return SDSPI_ApiRetStatus_SDSPI_StopTransFail;
+    }
+
     /* send cmd */
     if (SDSPI_ApiRetStatus_Success !=
         SDSPI_SendCmd(
@@ -1252,6 +1336,11 @@ SDSPI_ApiRetStatus_Type SDSPI_EraseBlocksPre(SDSPI_CardHandler_Type *card, uint3
 
     uint8_t resp = 0U;
 
+    if (SDSPI_ApiRetStatus_Success != SDSPI_StreamClose(card))
+    {
+        return SDSPI_ApiRetStatus_SDSPI_StopTransFail;
+    }
+
     /* Pre-erase before writing data */
     if (SDSPI_ApiRetStatus_Success != SDSPI_SendAppCmd(card))
     {
@@ -1280,6 +1369,11 @@ SDSPI_ApiRetStatus_Type SDSPI_EraseBlocks(SDSPI_CardHandler_Type *card, uint32_t
     uint32_t blockDone = 0U;    /* The block count has been erased. */
     uint32_t blockLeft;         /* Left block count to be erase. */
 
+    if (SDSPI_ApiRetStatus_Success != SDSPI_StreamClose(card))
+    {
+        return SDSPI_ApiRetStatus_SDSPI_StopTransFail;
+    }
+
     blockLeft = blockCount;
     while (blockLeft)
     {
@@ -1309,6 +1403,11 @@ SDSPI_ApiRetStatus_Type SDSPI_SwitchToHighSpeed(SDSPI_CardHandler_Type *card)
 {
     assert(card);
 
+    if (SDSPI_ApiRetStatus_Success != SDSPI_StreamClose(card))
+    {
+        return SDSPI_ApiRetStatus_SDSPI_StopTransFail;
+    }
+
     if (SDSPI_SelectFunction(card, SD_GroupTimingMode, SD_FunctionSDR25HighSpeed) == SDSPI_ApiRetStatus_Success)
     {
         card->interface->spi_freq(SD_CLOCK_50MHZ > card->interface->baudrate ? card->interface->baudrate : SD_CLOCK_50MHZ);
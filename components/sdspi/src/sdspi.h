@@ -117,6 +117,8 @@ typedef struct _sdspi_card
     sd_scr_t scr;             /*!< SCR */
     uint32_t blockCount;      /*!< Card total block number */
     uint32_t blockSize;       /*!< Card block size */
+    bool streamOpen;          /*!< A multiple block read (CMD18) is in progress */
+    uint32_t streamBlock;     /*!< Next block the open read delivers */
 } SDSPI_CardHandler_Type;
 
 /*************************************************************************************************
@@ -128,6 +130,9 @@ extern "C" {
 
 SDSPI_ApiRetStatus_Type SDSPI_Init(SDSPI_CardHandler_Type *card, const SDSPI_Interface_Type *interface);
 SDSPI_ApiRetStatus_Type SDSPI_ReadBlocks(SDSPI_CardHandler_Type *card, uint8_t *buffer, uint32_t startBlock, uint32_t blockCount);
+SDSPI_ApiRetStatus_Type SDSPI_StreamOpen(SDSPI_CardHandler_Type *card, uint32_t startBlock);
+SDSPI_ApiRetStatus_Type SDSPI_StreamRead(SDSPI_CardHandler_Type *card, uint8_t *buffer, uint32_t blockCount);
+SDSPI_ApiRetStatus_Type SDSPI_StreamClose(SDSPI_CardHandler_Type *card);
 SDSPI_ApiRetStatus_Type SDSPI_WriteBlocks(SDSPI_CardHandler_Type *card, uint8_t *buffer, uint32_t startBlock, uint32_t blockCount);
 SDSPI_ApiRetStatus_Type SDSPI_SendCid(SDSPI_CardHandler_Type *card);
 SDSPI_ApiRetStatus_Type SDSPI_EraseBlocksPre(SDSPI_CardHandler_Type *card, uint32_t blockCount);
@@ -28,6 +28,11 @@
 #include "audio.h"
 
 #define DTCM_RAM __attribute__((section(".RAM_D1")))
+#if defined(APP_ITCM)
+#define ITCM_CODE __attribute__((section(".RAM_I1")))   /* copied from flash at startup. */
+#else
+#define ITCM_CODE                                       /* stays in flash, see the scatter file. */
+#endif
 
 
 #endif /* __HAL_COMMON_H__ */
@@ -15,6 +15,12 @@
 void SystemInit(void)
 {
 
+#if defined(APP_ITCM)
+  /* clock the ITCM before __main copies ER_ITCM into it. */
+  RCC->AHB1ENR |= RCC_AHB1ENR_ITCM_MASK | RCC_AHB1ENR_DTCM_MASK;
+  __DSB();
+#endif
+
 #if defined (__FPU_PRESENT ) && (__FPU_PRESENT == 1U)
   #if defined(__FPU_USED) && (__FPU_USED == 1u)
     SCB->CPACR |= (SCB_CPACR_CP10_MASK | SCB_CPACR_CP11_MASK); /* set CP10, CP11 Full Access */
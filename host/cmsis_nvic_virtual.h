@@ -0,0 +1,37 @@
+#ifndef __CMSIS_NVIC_VIRTUAL_H_
+#define __CMSIS_NVIC_VIRTUAL_H_
+
+/*
+ * Host build only: core_star.h includes this file when CMSIS_NVIC_VIRTUAL is
+ * defined, so NVIC accesses from board/ and application/ land in host_hal.c
+ * instead of the (unmapped) System Control Space.
+ */
+
+void     HOST_NVIC_SetPriorityGrouping(uint32_t PriorityGroup);
+uint32_t HOST_NVIC_GetPriorityGrouping(void);
+void     HOST_NVIC_EnableIRQ(IRQn_Type IRQn);
+uint32_t HOST_NVIC_GetEnableIRQ(IRQn_Type IRQn);
+void     HOST_NVIC_DisableIRQ(IRQn_Type IRQn);
+uint32_t HOST_NVIC_GetPendingIRQ(IRQn_Type IRQn);
+void     HOST_NVIC_SetPendingIRQ(IRQn_Type IRQn);
+void     HOST_NVIC_ClearPendingIRQ(IRQn_Type IRQn);
+uint32_t HOST_NVIC_GetActive(IRQn_Type IRQn);
+void     HOST_NVIC_SetPriority(IRQn_Type IRQn, uint32_t priority);
+uint32_t HOST_NVIC_GetPriority(IRQn_Type IRQn);
+void     HOST_NVIC_SystemReset(void);
+
+#define NVIC_SetPriorityGrouping    HOST_NVIC_SetPriorityGrouping
+#define NVIC_GetPriorityGrouping    HOST_NVIC_GetPriorityGrouping
+#define NVIC_EnableIRQ              HOST_NVIC_EnableIRQ
+#define NVIC_GetEnableIRQ           HOST_NVIC_GetEnableIRQ
+#define NVIC_DisableIRQ             HOST_NVIC_DisableIRQ
+#define NVIC_GetPendingIRQ          HOST_NVIC_GetPendingIRQ
+#define NVIC_SetPendingIRQ          HOST_NVIC_SetPendingIRQ
+#define NVIC_ClearPendingIRQ        HOST_NVIC_ClearPendingIRQ
+#define NVIC_GetActive              HOST_NVIC_GetActive
+#define NVIC_SetPriority            HOST_NVIC_SetPriority
+#define NVIC_GetPriority            HOST_NVIC_GetPriority
+#define NVIC_SystemReset            HOST_NVIC_SystemReset
+#define SW_SystemReset              HOST_NVIC_SystemReset
+
+#endif
@@ -0,0 +1,72 @@
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "hal_common.h"
+#include "board_it.h"
+#include "mp3_bench.h"
+#include "ram_disk.h"
+
+/*
+ * Host MP3 decoder benchmark: mounts a FAT image as drive 0 and runs
+ * MP3_Bench_Run() over AUDIO_MUSIC_PATH, the same code the board runs
+ * with APP_MP3_BENCH. The table goes to stdout; every file is decoded
+ * <passes> times (default 5) and the fastest pass is reported.
+ *
+ *   mm32_bench [-p passes] <disk.img>
+ */
+
+/*
+ * Variables.
+ */
+FATFS fs;
+
+/*
+ * Functions.
+ */
+int main(int argc, char *argv[])
+{
+    const char *image  = NULL;
+    uint32_t    passes = 5u;
+    uint32_t    n;
+    FRESULT     res;
+
+    for (int arg = 1; arg < argc; arg++)
+    {
+        if ( (0 == strcmp(argv[arg], "-p")) && (arg + 1 < argc) )
+        {
+            passes = (uint32_t)strtoul(argv[++arg], NULL, 0);
+        }
+        else
+        {
+            image = argv[arg];
+        }
+    }
+    if ( (image == NULL) || (passes == 0u) )
+    {
+        fprintf(stderr, "usage: mm32_bench [-p passes] <disk.img>\n");
+        return 2;
+    }
+
+    if (RAM_disk_attach(image) != 0)
+    {
+        fprintf(stderr, "cannot map %s\n", image);
+        return 1;
+    }
+
+    res = f_mount(&fs, "0:/", 1);
+    if (res != FR_OK)
+    {
+        fprintf(stderr, "f_mount() Fail!,res=%d\n", res);
+        return 1;
+    }
+
+    CycleCounter_Init();
+    n = MP3_Bench_Run(AUDIO_MUSIC_PATH, passes);
+
+    f_unmount("0:/");
+    RAM_disk_detach();
+    return (n != 0u) ? 0 : 1;
+}
+
+/* EOF. */
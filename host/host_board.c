@@ -0,0 +1,124 @@
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <time.h>
+
+#include "board_it.h"
+#include "host_hal.h"
+#include "log_port.h"
+#include "sdspi.h"
+
+/*
+ * Host replacements for board/board_it.c, board/sdspi_port.c and the
+ * LOG_Port_Flush() of board/log_port.c.
+ */
+
+/*
+ * Variables.
+ */
+static struct timespec host_boot_time;
+
+/*
+ * Declerations.
+ */
+static SDSPI_ApiRetStatus_Type host_sdspi_spi_init(void);
+static SDSPI_ApiRetStatus_Type host_sdspi_spi_freq(uint32_t hz);
+static SDSPI_ApiRetStatus_Type host_sdspi_spi_xfer(uint8_t *in, uint8_t *out, uint32_t len);
+
+/* there is no card on the host, drive 1 stays STA_NOINIT and the ram disk (drive 0) is used instead. */
+const SDSPI_Interface_Type board_sdspi_if =
+{
+    .baudrate = 1000000u,
+    .spi_init = host_sdspi_spi_init,
+    .spi_freq = host_sdspi_spi_freq,
+    .spi_xfer = host_sdspi_spi_xfer
+};
+
+/*
+ * Functions.
+ */
+void SysTick_Init(void)
+{
+    clock_gettime(CLOCK_MONOTONIC, &host_boot_time);
+}
+
+void SysTick_Handler(void)
+{
+}
+
+uint32_t GetSysRunTimeMs(void)
+{
+    struct timespec now;
+
+    if (host_boot_time.tv_sec == 0)
+    {
+        SysTick_Init();
+    }
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)((now.tv_sec - host_boot_time.tv_sec) * 1000
+                    + (now.tv_nsec - host_boot_time.tv_nsec) / 1000000);
+}
+
+void delay_us(uint16_t nus)
+{
+    struct timespec t = { 0, (long)nus * 1000L };
+    nanosleep(&t, NULL);
+}
+
+void delay_ms(uint16_t nms)
+{
+    struct timespec t = { nms / 1000u, (long)(nms % 1000u) * 1000000L };
+    nanosleep(&t, NULL);
+}
+
+/* the host has no cycle counter worth trusting, count nanoseconds instead. */
+void CycleCounter_Init(void)
+{
+}
+
+uint32_t GetCycleCount(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)((uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec);
+}
+
+uint32_t GetCycleCountFreq(void)
+{
+    return 1000000000u;
+}
+
+/* the "interrupt" the board would sleep for is the next dma block, play it now. */
+void WaitForInterrupt(void)
+{
+    HOST_DMA_Run();
+}
+
+/* printf() goes straight to stdout, there is no uart ring to drain. */
+void LOG_Port_Flush(void)
+{
+    fflush(stdout);
+}
+
+static SDSPI_ApiRetStatus_Type host_sdspi_spi_init(void)
+{
+    return SDSPI_ApiRetStatus_SDSPI_SpiInitFail;
+}
+
+static SDSPI_ApiRetStatus_Type host_sdspi_spi_freq(uint32_t hz)
+{
+    (void)hz;
+    return SDSPI_ApiRetStatus_Success;
+}
+
+static SDSPI_ApiRetStatus_Type host_sdspi_spi_xfer(uint8_t *in, uint8_t *out, uint32_t len)
+{
+    (void)in;
+    if (out != NULL)
+    {
+        memset(out, SDSPI_DUMMY_DATA, len);
+    }
+    return SDSPI_ApiRetStatus_SDSPI_XferFail;
+}
+
+/* EOF. */
@@ -0,0 +1,400 @@
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "hal_common.h"
+#include "host_hal.h"
+
+/*
+ * Definitions.
+ */
+#define HOST_DMA_INSTANCE_NUM   2u
+#define HOST_DMA_CHANNEL_NUM    8u
+
+typedef struct
+{
+    DMA_Channel_Init_Type Init;
+    uint32_t IntEnable;     /* DMA_CHN_INT_xxx enabled by DMA_EnableChannelInterrupts(). */
+    uint32_t Status;        /* DMA_CHN_INT_xxx pending, cleared by DMA_ClearChannelInterruptStatus(). */
+    bool     Enabled;
+    bool     InService;     /* set while the model is delivering this channel's interrupts. */
+    bool     Reprogrammed;  /* DMA_InitChannel() was called since the block in service started. */
+    bool     SecondHalf;    /* circular channels: the next call plays the second half. */
+} HOST_DMA_Channel_Type;
+
+/*
+ * Variables.
+ */
+static HOST_DMA_Channel_Type host_dma[HOST_DMA_INSTANCE_NUM][HOST_DMA_CHANNEL_NUM];
+static bool                  host_nvic_enabled[128];
+
+static FILE                 *host_audio_sink = NULL;
+static HOST_Audio_Stats_Type host_audio_stats;
+static uint32_t              host_crc_table[256];
+
+/*
+ * Declerations.
+ */
+void DMA1_CH1_IRQHandler(void) __attribute__((weak));
+void DMA1_CH2_IRQHandler(void) __attribute__((weak));
+void DMA1_CH3_IRQHandler(void) __attribute__((weak));
+void DMA1_CH4_IRQHandler(void) __attribute__((weak));
+void DMA1_CH5_IRQHandler(void) __attribute__((weak));
+void DMA1_CH6_IRQHandler(void) __attribute__((weak));
+void DMA1_CH7_IRQHandler(void) __attribute__((weak));
+void DMA1_CH8_IRQHandler(void) __attribute__((weak));
+void DMA2_CH1_IRQHandler(void) __attribute__((weak));
+void DMA2_CH2_IRQHandler(void) __attribute__((weak));
+void DMA2_CH3_IRQHandler(void) __attribute__((weak));
+void DMA2_CH4_IRQHandler(void) __attribute__((weak));
+void DMA2_CH5_IRQHandler(void) __attribute__((weak));
+void DMA2_CH6_IRQHandler(void) __attribute__((weak));
+void DMA2_CH7_IRQHandler(void) __attribute__((weak));
+void DMA2_CH8_IRQHandler(void) __attribute__((weak));
+
+static void (* const host_dma_irq_handler[HOST_DMA_INSTANCE_NUM][HOST_DMA_CHANNEL_NUM])(void) =
+{
+    { DMA1_CH1_IRQHandler, DMA1_CH2_IRQHandler, DMA1_CH3_IRQHandler, DMA1_CH4_IRQHandler,
+      DMA1_CH5_IRQHandler, DMA1_CH6_IRQHandler, DMA1_CH7_IRQHandler, DMA1_CH8_IRQHandler },
+    { DMA2_CH1_IRQHandler, DMA2_CH2_IRQHandler, DMA2_CH3_IRQHandler, DMA2_CH4_IRQHandler,
+      DMA2_CH5_IRQHandler, DMA2_CH6_IRQHandler, DMA2_CH7_IRQHandler, DMA2_CH8_IRQHandler },
+};
+
+static const IRQn_Type host_dma_irqn[HOST_DMA_INSTANCE_NUM][HOST_DMA_CHANNEL_NUM] =
+{
+    { DMA1_CH1_IRQn, DMA1_CH2_IRQn, DMA1_CH3_IRQn, DMA1_CH4_IRQn,
+      DMA1_CH5_IRQn, DMA1_CH6_IRQn, DMA1_CH7_IRQn, DMA1_CH8_IRQn },
+    { DMA2_CH1_IRQn, DMA2_CH2_IRQn, DMA2_CH3_IRQn, DMA2_CH4_IRQn,
+      DMA2_CH5_IRQn, DMA2_CH6_IRQn, DMA2_CH7_IRQn, DMA2_CH8_IRQn },
+};
+
+static void host_dma_service(uint32_t instance, uint32_t channel);
+
+/*
+ * Functions.
+ */
+static uint32_t host_crc32(uint32_t crc, const uint8_t *buf, uint32_t len)
+{
+    if (host_crc_table[1] == 0u)
+    {
+        for (uint32_t i = 0u; i < 256u; i++)
+        {
+            uint32_t c = i;
+            for (uint32_t k = 0u; k < 8u; k++)
+            {
+                c = (c & 1u) ? (0xEDB88320u ^ (c >> 1u)) : (c >> 1u);
+            }
+            host_crc_table[i] = c;
+        }
+    }
+
+    crc = ~crc;
+    while (len--)
+    {
+        crc = host_crc_table[(crc ^ *buf++) & 0xFFu] ^ (crc >> 8u);
+    }
+    return ~crc;
+}
+
+static uint32_t host_dma_instance(DMA_Type * DMAx)
+{
+    return (DMAx == DMA1) ? 0u : 1u;
+}
+
+static uint32_t host_dma_width_bytes(DMA_XferWidth_Type width)
+{
+    switch (width)
+    {
+    case DMA_XferWidth_8b:
+        return 1u;
+    case DMA_XferWidth_16b:
+        return 2u;
+    default:
+        return 4u;
+    }
+}
+
+/* Memory-to-peripheral payload that reached a peripheral data register. */
+static void host_dma_periph_write(uint32_t periph_addr, const uint8_t *buf, uint32_t len, uint32_t width)
+{
+    if (periph_addr == I2S_GetTxDataRegAddr(SPI2))
+    {
+        host_audio_stats.Samples += len / width;
+        host_audio_stats.Crc32 = host_crc32(host_audio_stats.Crc32, buf, len);
+        if (host_audio_sink != NULL)
+        {
+            fwrite(buf, 1u, len, host_audio_sink);
+        }
+    }
+}
+
+static void host_dma_raise(uint32_t instance, uint32_t channel, uint32_t flags)
+{
+    HOST_DMA_Channel_Type *chn = &host_dma[instance][channel];
+
+    chn->Status |= flags | DMA_CHN_INT_XFER_GLOBAL;
+    if (   (0u != (chn->IntEnable & flags))
+        && host_nvic_enabled[host_dma_irqn[instance][channel]]
+        && (host_dma_irq_handler[instance][channel] != NULL) )
+    {
+        host_dma_irq_handler[instance][channel]();
+    }
+}
+
+/*
+ * Consume one armed transfer: half of the data, HALF_DONE, the rest, XFER_DONE.
+ * Circular channels never finish, so they advance by one half per call instead.
+ */
+static void host_dma_service(uint32_t instance, uint32_t channel)
+{
+    HOST_DMA_Channel_Type *chn = &host_dma[instance][channel];
+    DMA_Channel_Init_Type  init = chn->Init;
+    uint32_t width = host_dma_width_bytes(init.XferWidth);
+    uint32_t half  = (init.XferCount / 2u) * width;
+    uint32_t total = init.XferCount * width;
+    const uint8_t *mem = (const uint8_t *)(uintptr_t)init.MemAddr;
+
+    chn->InService    = true;
+    chn->Reprogrammed = false;
+
+    if (init.ReloadMode == DMA_ReloadMode_AutoReloadContinuous)
+    {
+        if (!chn->SecondHalf)
+        {
+            host_dma_periph_write(init.PeriphAddr, mem, half, width);
+            chn->SecondHalf = true;
+            host_dma_raise(instance, channel, DMA_CHN_INT_XFER_HALF_DONE);
+        }
+        else
+        {
+            host_dma_periph_write(init.PeriphAddr, mem + half, total - half, width);
+            host_audio_stats.Transfers++;
+            chn->SecondHalf = false;
+            host_dma_raise(instance, channel, DMA_CHN_INT_XFER_DONE);
+        }
+        chn->InService = false;
+        return;
+    }
+
+    if (init.XferMode == DMA_XferMode_MemoryToPeriph)
+    {
+        host_dma_periph_write(init.PeriphAddr, mem, half, width);
+    }
+    host_dma_raise(instance, channel, DMA_CHN_INT_XFER_HALF_DONE);
+
+    /* the half transfer handler may have stopped or re-programmed the channel. */
+    if (chn->Enabled && !chn->Reprogrammed)
+    {
+        if (init.XferMode == DMA_XferMode_MemoryToPeriph)
+        {
+            host_dma_periph_write(init.PeriphAddr, mem + half, total - half, width);
+        }
+        host_audio_stats.Transfers++;
+
+        /* one-time and auto-reload channels stop at the end of the block. */
+        chn->Enabled = false;
+        host_dma_raise(instance, channel, DMA_CHN_INT_XFER_DONE);
+    }
+
+    chn->InService = false;
+}
+
+bool HOST_DMA_Run(void)
+{
+    bool busy = false;
+
+    for (uint32_t i = 0u; i < HOST_DMA_INSTANCE_NUM; i++)
+    {
+        for (uint32_t c = 0u; c < HOST_DMA_CHANNEL_NUM; c++)
+        {
+            if (host_dma[i][c].Enabled && !host_dma[i][c].InService)
+            {
+                host_dma_service(i, c);
+                busy = true;
+            }
+        }
+    }
+
+    return busy;
+}
+
+int HOST_Audio_OpenSink(const char *path)
+{
+    host_audio_sink = fopen(path, "wb");
+    return (host_audio_sink != NULL) ? 0 : -1;
+}
+
+void HOST_Audio_CloseSink(void)
+{
+    if (host_audio_sink != NULL)
+    {
+        fclose(host_audio_sink);
+        host_audio_sink = NULL;
+    }
+}
+
+void HOST_Audio_GetStats(HOST_Audio_Stats_Type *stats)
+{
+    *stats = host_audio_stats;
+}
+
+/* hal_dma. */
+uint32_t DMA_InitChannel(DMA_Type * DMAx, uint32_t channel, DMA_Channel_Init_Type * init)
+{
+    uint32_t instance = host_dma_instance(DMAx);
+    HOST_DMA_Channel_Type *chn = &host_dma[instance][channel];
+
+    /* the previous block is still playing out, let it finish before re-programming. */
+    if (   chn->Enabled && !chn->InService
+        && (chn->Init.ReloadMode != DMA_ReloadMode_AutoReloadContinuous) )
+    {
+        host_dma_service(instance, channel);
+    }
+
+    chn->Init         = *init;
+    chn->Enabled      = false;
+    chn->Reprogrammed = true;
+    chn->SecondHalf   = false;
+    return 0u;
+}
+
+void DMA_EnableChannelInterrupts(DMA_Type * DMAx, uint32_t channel, uint32_t interrupts, bool enable)
+{
+    HOST_DMA_Channel_Type *chn = &host_dma[host_dma_instance(DMAx)][channel];
+
+    if (enable)
+    {
+        chn->IntEnable |= (interrupts & 0xEu);
+    }
+    else
+    {
+        chn->IntEnable &= ~(interrupts & 0xEu);
+    }
+}
+
+uint32_t DMA_GetChannelInterruptStatus(DMA_Type * DMAx, uint32_t channel)
+{
+    return host_dma[host_dma_instance(DMAx)][channel].Status;
+}
+
+void DMA_ClearChannelInterruptStatus(DMA_Type * DMAx, uint32_t channel, uint32_t interrupts)
+{
+    host_dma[host_dma_instance(DMAx)][channel].Status &= ~(interrupts & 0xFu);
+}
+
+void DMA_EnableChannel(DMA_Type * DMAx, uint32_t channel, bool enable)
+{
+    HOST_DMA_Channel_Type *chn = &host_dma[host_dma_instance(DMAx)][channel];
+
+    /* re-enabling from inside the channel's own XFER_DONE handler does not replay the block. */
+    if (enable && chn->InService && !chn->Reprogrammed)
+    {
+        return;
+    }
+    chn->Enabled = enable;
+}
+
+void DMA_EnableBurstMode(DMA_Type * DMAx, uint32_t channel, bool enable)
+{
+    (void)DMAx;
+    (void)channel;
+    (void)enable;
+}
+
+/* hal_i2s. */
+void I2S_InitMaster(I2S_Type * I2Sx, I2S_Master_Init_Type * init)
+{
+    (void)I2Sx;
+    host_audio_stats.SampleRate = init->SampleRate;
+}
+
+void I2S_Enable(I2S_Type * I2Sx, bool enable)
+{
+    (void)I2Sx;
+    (void)enable;
+}
+
+void I2S_EnableDMA(I2S_Type * I2Sx, bool enable)
+{
+    (void)I2Sx;
+    (void)enable;
+}
+
+uint32_t I2S_GetTxDataRegAddr(I2S_Type * I2Sx)
+{
+    return (uint32_t)(uintptr_t)(&(I2Sx->TXREG));
+}
+
+/* NVIC, see cmsis_nvic_virtual.h. */
+void HOST_NVIC_SetPriorityGrouping(uint32_t PriorityGroup)
+{
+    (void)PriorityGroup;
+}
+
+uint32_t HOST_NVIC_GetPriorityGrouping(void)
+{
+    return 0u;
+}
+
+void HOST_NVIC_EnableIRQ(IRQn_Type IRQn)
+{
+    if (IRQn >= 0)
+    {
+        host_nvic_enabled[IRQn] = true;
+    }
+}
+
+uint32_t HOST_NVIC_GetEnableIRQ(IRQn_Type IRQn)
+{
+    return (IRQn >= 0) ? host_nvic_enabled[IRQn] : 0u;
+}
+
+void HOST_NVIC_DisableIRQ(IRQn_Type IRQn)
+{
+    if (IRQn >= 0)
+    {
+        host_nvic_enabled[IRQn] = false;
+    }
+}
+
+uint32_t HOST_NVIC_GetPendingIRQ(IRQn_Type IRQn)
+{
+    (void)IRQn;
+    return 0u;
+}
+
+void HOST_NVIC_SetPendingIRQ(IRQn_Type IRQn)
+{
+    (void)IRQn;
+}
+
+void HOST_NVIC_ClearPendingIRQ(IRQn_Type IRQn)
+{
+    (void)IRQn;
+}
+
+uint32_t HOST_NVIC_GetActive(IRQn_Type IRQn)
+{
+    (void)IRQn;
+    return 0u;
+}
+
+void HOST_NVIC_SetPriority(IRQn_Type IRQn, uint32_t priority)
+{
+    (void)IRQn;
+    (void)priority;
+}
+
+uint32_t HOST_NVIC_GetPriority(IRQn_Type IRQn)
+{
+    (void)IRQn;
+    return 0u;
+}
+
+void HOST_NVIC_SystemReset(void)
+{
+    exit(1);
+}
+
+/* EOF. */
@@ -0,0 +1,31 @@
+#ifndef __HOST_HAL_H_
+#define __HOST_HAL_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Host-side model of the peripherals used by board/ and application/.
+ *
+ * DMA channels are serviced explicitly: a transfer armed with DMA_EnableChannel()
+ * is consumed by HOST_DMA_Run(), which raises the half/full transfer flags and
+ * calls the channel's IRQ handler exactly like the NVIC would on the target.
+ * Re-initialising a channel that still has a transfer in flight completes that
+ * transfer first, which models the previous buffer having drained.
+ */
+
+typedef struct
+{
+    uint32_t SampleRate;    /* last rate programmed through I2S_InitMaster(). */
+    uint64_t Samples;       /* 16-bit words sent to the I2S tx register. */
+    uint32_t Transfers;     /* number of completed DMA transfers. */
+    uint32_t Crc32;         /* crc32 over every byte sent, for regression checks. */
+} HOST_Audio_Stats_Type;
+
+bool HOST_DMA_Run(void);
+
+int  HOST_Audio_OpenSink(const char *path);
+void HOST_Audio_CloseSink(void);
+void HOST_Audio_GetStats(HOST_Audio_Stats_Type *stats);
+
+#endif
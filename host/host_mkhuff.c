@@ -0,0 +1,275 @@
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "huffman.h"
+
+/*
+ * Generator for libmad's OPT_HUFFLUT tables:
+ *
+ *   mm32_mkhuff [out.dat]     (default stdout)
+ *
+ * Reads the Layer III code words back out of the tree tables in huffman.c and
+ * writes them as the multi-bit lookup tables of components/libmad-0.15.1b/
+ * hufflut.dat, in the entry format described in huffman.h. The first level of
+ * a pair table takes up to HUFFLUT_PAIR_BITS bits, every level below up to
+ * HUFFLUT_NEXT_BITS; the count1 tables are one HUFFLUT_QUAD_BITS level.
+ */
+
+/*
+ * Definitions.
+ */
+#define MKHUFF_MAX_CODES        256u
+#define MKHUFF_MAX_ENTRIES      2048u       /* the 11-bit offset of a pointer entry. */
+
+typedef struct
+{
+    uint32_t Code;
+    uint32_t Len;
+    uint32_t Value;     /* x | y << 4, or v w x y for the quads. */
+} MKHUFF_Code_Type;
+
+typedef struct
+{
+    MKHUFF_Code_Type Code[MKHUFF_MAX_CODES];
+    uint32_t         Count;
+} MKHUFF_Tree_Type;
+
+static uint16_t mkhuff_lut[MKHUFF_MAX_ENTRIES];
+static uint32_t mkhuff_used;
+
+
+/*
+ * Code words of a tree table, as mkmp3_walk_pair() in host_mkmp3.c. A final
+ * entry shorter than its level repeats for the bits it does not take.
+ */
+static void mkhuff_walk_pair(MKHUFF_Tree_Type *tree, union huffpair const *table, uint32_t offset,
+                             uint32_t bits, uint32_t prefix, uint32_t len)
+{
+    for (uint32_t i = 0u; i < (1u << bits); i++)
+    {
+        union huffpair const *entry = &table[offset + i];
+
+        if (!entry->final)
+        {
+            mkhuff_walk_pair(tree, table, entry->ptr.offset, entry->ptr.bits, (prefix << bits) | i, len + bits);
+        }
+        else if ((i & ((1u << (bits - entry->value.hlen)) - 1u)) == 0u)
+        {
+            MKHUFF_Code_Type *code = &tree->Code[tree->Count++];
+
+            code->Code  = (prefix << entry->value.hlen) | (i >> (bits - entry->value.hlen));
+            code->Len   = len + entry->value.hlen;
+            code->Value = entry->value.x | (entry->value.y << 4);
+        }
+    }
+}
+
+static void mkhuff_walk_quad(MKHUFF_Tree_Type *tree, union huffquad const *table, uint32_t offset,
+                             uint32_t bits, uint32_t prefix, uint32_t len)
+{
+    for (uint32_t i = 0u; i < (1u << bits); i++)
+    {
+        union huffquad const *entry = &table[offset + i];
+
+        if (!entry->final)
+        {
+            mkhuff_walk_quad(tree, table, entry->ptr.offset, entry->ptr.bits, (prefix << bits) | i, len + bits);
+        }
+        else if ((i & ((1u << (bits - entry->value.hlen)) - 1u)) == 0u)
+        {
+            MKHUFF_Code_Type *code = &tree->Code[tree->Count++];
+
+            code->Code  = (prefix << entry->value.hlen) | (i >> (bits - entry->value.hlen));
+            code->Len   = len + entry->value.hlen;
+            code->Value = (entry->value.v << 3) | (entry->value.w << 2) | (entry->value.x << 1) | entry->value.y;
+        }
+    }
+}
+
+/*
+ * One level of a pair table: 1 << bits entries for the codes that start with
+ * prefix (len bits), the levels below it behind them. Returns its offset.
+ */
+static uint32_t mkhuff_level(MKHUFF_Tree_Type const *tree, uint32_t prefix, uint32_t len, uint32_t bits)
+{
+    uint32_t base = mkhuff_used;
+
+    if ((base + (1u << bits)) > MKHUFF_MAX_ENTRIES)
+    {
+        fprintf(stderr, "mm32_mkhuff: table too large\n");
+        exit(1);
+    }
+    mkhuff_used += 1u << bits;
+
+    for (uint32_t i = 0u; i < (1u << bits); i++)
+    {
+        uint32_t next = (prefix << bits) | i;
+        uint32_t rest = 0u;
+        uint32_t c;
+
+        mkhuff_lut[base + i] = 0xFFFFu;
+
+        for (c = 0u; c < tree->Count; c++)
+        {
+            MKHUFF_Code_Type const *code = &tree->Code[c];
+
+            if (code->Len < len)
+            {
+                continue;
+            }
+            if (code->Len <= (len + bits))
+            {
+                /* ends in this level: every index that starts with it. */
+                if ((code->Code >> (code->Len - len)) == prefix &&
+                    (i >> (len + bits - code->Len)) == (code->Code & ((1u << (code->Len - len)) - 1u)))
+                {
+                    mkhuff_lut[base + i] = (uint16_t)(1u | ((code->Len - len) << 1) | (code->Value << 8));
+                }
+            }
+            else if ((code->Code >> (code->Len - len - bits)) == next)
+            {
+                if ((code->Len - len - bits) > rest)
+                {
+                    rest = code->Len - len - bits;
+                }
+            }
+        }
+
+        if (rest != 0u)
+        {
+            uint32_t width  = (rest < HUFFLUT_NEXT_BITS) ? rest : HUFFLUT_NEXT_BITS;
+            uint32_t offset = mkhuff_level(tree, next, len + bits, width);
+
+            mkhuff_lut[base + i] = (uint16_t)((width << 1) | (offset << 5));
+        }
+
+        if (mkhuff_lut[base + i] == 0xFFFFu)
+        {
+            fprintf(stderr, "mm32_mkhuff: incomplete code\n");
+            exit(1);
+        }
+    }
+
+    return base;
+}
+
+static void mkhuff_print(FILE *out, uint16_t const *entries, uint32_t count, char const *format)
+{
+    for (uint32_t i = 0u; i < count; i++)
+    {
+        fprintf(out, "%s", ((i % 8u) == 0u) ? "  " : " ");
+        fprintf(out, format, entries[i]);
+        fprintf(out, "%s", (i + 1u == count) ? "\n" : (((i % 8u) == 7u) ? ",\n" : ","));
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t              start[32];
+    FILE                 *out = stdout;
+    MKHUFF_Tree_Type      tree;
+    uint16_t              quad[2][1u << HUFFLUT_QUAD_BITS];
+
+    if ((argc > 1) && ((out = fopen(argv[1], "w")) == NULL))
+    {
+        perror(argv[1]);
+        return 1;
+    }
+
+    fprintf(out, "/*\n"
+                 " * Generated by mm32_mkhuff (host/host_mkhuff.c) from the Layer III\n"
+                 " * tables in huffman.c, do not edit. Entry format in huffman.h.\n"
+                 " */\n\n");
+
+    /* one set of levels per tree, tables 16..23 and 24..31 share theirs. */
+    for (uint32_t t = 0u; t < 32u; t++)
+    {
+        struct hufftable const *entry = &mad_huff_pair_table[t];
+        uint32_t                bits = 0u, first;
+
+        if (entry->table == NULL)
+        {
+            continue;
+        }
+        for (first = 0u; mad_huff_pair_table[first].table != entry->table; first++)
+        {
+        }
+        if (first < t)
+        {
+            start[t] = start[first];
+            continue;
+        }
+
+        memset(&tree, 0, sizeof(tree));
+        mkhuff_walk_pair(&tree, entry->table, 0u, entry->startbits, 0u, 0u);
+        for (uint32_t c = 0u; c < tree.Count; c++)
+        {
+            bits = (tree.Code[c].Len > bits) ? tree.Code[c].Len : bits;
+        }
+
+        mkhuff_used = 0u;
+        mkhuff_level(&tree, 0u, 0u, (bits < HUFFLUT_PAIR_BITS) ? bits : HUFFLUT_PAIR_BITS);
+
+        fprintf(out, "static MAD_DTCM_CONST\nunsigned short const hufflut%u[%u] = {\n", t, mkhuff_used);
+        mkhuff_print(out, mkhuff_lut, mkhuff_used, "0x%04x");
+        fprintf(out, "};\n\n");
+
+        start[t] = (bits < HUFFLUT_PAIR_BITS) ? bits : HUFFLUT_PAIR_BITS;
+    }
+
+    for (uint32_t t = 0u; t < 2u; t++)
+    {
+        memset(&tree, 0, sizeof(tree));
+        mkhuff_walk_quad(&tree, mad_huff_quad_table[t], 0u, 4u, 0u, 0u);
+
+        for (uint32_t i = 0u; i < (1u << HUFFLUT_QUAD_BITS); i++)
+        {
+            quad[t][i] = 0xFFFFu;
+            for (uint32_t c = 0u; c < tree.Count; c++)
+            {
+                if ((i >> (HUFFLUT_QUAD_BITS - tree.Code[c].Len)) == tree.Code[c].Code)
+                {
+                    quad[t][i] = (uint16_t)((tree.Code[c].Len << 4) | tree.Code[c].Value);
+                }
+            }
+        }
+    }
+
+    fprintf(out, "MAD_DTCM_CONST\nunsigned char const mad_huff_quad_lut[2][%u] = {\n", 1u << HUFFLUT_QUAD_BITS);
+    for (uint32_t t = 0u; t < 2u; t++)
+    {
+        fprintf(out, " {\n");
+        mkhuff_print(out, quad[t], 1u << HUFFLUT_QUAD_BITS, "0x%02x");
+        fprintf(out, " }%s\n", (t == 0u) ? "," : "");
+    }
+    fprintf(out, "};\n\n");
+
+    fprintf(out, "struct hufflut const mad_huff_pair_lut[32] = {\n");
+    for (uint32_t t = 0u; t < 32u; t++)
+    {
+        struct hufftable const *entry = &mad_huff_pair_table[t];
+        char                    name[16];
+        uint32_t                first;
+
+        if (entry->table == NULL)
+        {
+            fprintf(out, "  /* %2u */ { 0 /* not used */ }%s\n", t, (t == 31u) ? "" : ",");
+            continue;
+        }
+        for (first = 0u; mad_huff_pair_table[first].table != entry->table; first++)
+        {
+        }
+        snprintf(name, sizeof(name), "hufflut%u,", first);
+        fprintf(out, "  /* %2u */ { %-10s %2u, %u }%s\n", t, name, entry->linbits, start[t], (t == 31u) ? "" : ",");
+    }
+    fprintf(out, "};\n");
+
+    if (out != stdout)
+    {
+        fclose(out);
+    }
+    return 0;
+}
@@ -0,0 +1,136 @@
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+
+#include "hal_common.h"
+#include "ram_disk.h"
+
+/*
+ * Builds a FAT disk image for the host player with FatFs itself:
+ *
+ *   mm32_mkimg <disk.img> <size MiB> <file>...
+ *
+ * Every file is copied into AUDIO_MUSIC_PATH under its 8.3 upper case name.
+ */
+
+/*
+ * Variables.
+ */
+static FATFS   mkimg_fs;
+static uint8_t mkimg_work[FF_MAX_SS * 4];
+static uint8_t mkimg_buf[32 * 1024];
+
+/*
+ * Functions.
+ */
+static const char *mkimg_basename(const char *path)
+{
+    const char *p = strrchr(path, '/');
+
+    return (p != NULL) ? (p + 1) : path;
+}
+
+static int mkimg_copy(const char *src)
+{
+    static char dst[100];
+    const char *name = mkimg_basename(src);
+    FILE   *in;
+    FIL     out;
+    UINT    bw;
+    size_t  n, i;
+    FRESULT res;
+
+    snprintf(dst, sizeof(dst), "%s/%s", AUDIO_MUSIC_PATH, name);
+    for (i = 0; dst[i] != '\0'; i++)
+    {
+        dst[i] = (char)toupper((unsigned char)dst[i]);
+    }
+
+    in = fopen(src, "rb");
+    if (in == NULL)
+    {
+        fprintf(stderr, "cannot open %s\n", src);
+        return -1;
+    }
+
+    res = f_open(&out, dst, FA_WRITE | FA_CREATE_ALWAYS);
+    if (res != FR_OK)
+    {
+        fprintf(stderr, "f_open(%s) Fail!,res=%d (names must be 8.3)\n", dst, res);
+        fclose(in);
+        return -1;
+    }
+
+    while ((n = fread(mkimg_buf, 1u, sizeof(mkimg_buf), in)) > 0u)
+    {
+        res = f_write(&out, mkimg_buf, (UINT)n, &bw);
+        if ( (res != FR_OK) || (bw != n) )
+        {
+            fprintf(stderr, "f_write(%s) Fail!,res=%d\n", dst, res);
+            break;
+        }
+    }
+
+    f_close(&out);
+    fclose(in);
+    printf("%s -> %s\n", src, dst);
+    return (res == FR_OK) ? 0 : -1;
+}
+
+int main(int argc, char *argv[])
+{
+    MKFS_PARM opt = { FM_FAT32 | FM_SFD, 0, 0, 0, 0 };
+    uint32_t  mib;
+    FRESULT   res;
+    int       ret = 0;
+
+    if (argc < 3)
+    {
+        fprintf(stderr, "usage: mm32_mkimg <disk.img> <size MiB> <file>...\n");
+        return 2;
+    }
+
+    mib = (uint32_t)strtoul(argv[2], NULL, 0);
+    if (RAM_disk_create(argv[1], mib * (1024u * 1024u / FF_MAX_SS)) != 0)
+    {
+        fprintf(stderr, "cannot create %s\n", argv[1]);
+        return 1;
+    }
+
+    /* small images do not have enough clusters for FAT32. */
+    if (mib < 64u)
+    {
+        opt.fmt = FM_FAT | FM_SFD;
+    }
+
+    res = f_mkfs("0:", &opt, mkimg_work, sizeof(mkimg_work));
+    if (res == FR_OK)
+    {
+        res = f_mount(&mkimg_fs, "0:", 1);
+    }
+    if (res == FR_OK)
+    {
+        res = f_mkdir(AUDIO_MUSIC_PATH);
+    }
+    if (res != FR_OK)
+    {
+        fprintf(stderr, "format Fail!,res=%d\n", res);
+        RAM_disk_detach();
+        return 1;
+    }
+
+    for (int i = 3; i < argc; i++)
+    {
+        if (mkimg_copy(argv[i]) != 0)
+        {
+            ret = 1;
+        }
+    }
+
+    f_unmount("0:");
+    RAM_disk_detach();
+    return ret;
+}
+
+/* EOF. */
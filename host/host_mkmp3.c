@@ -0,0 +1,611 @@
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#include "huffman.h"
+
+/*
+ * Synthetic MPEG-1 Layer III stream generator for the decoder benchmark:
+ *
+ *   mm32_mkmp3 [-r rate] [-b kbps | -v min:max] [-m mono|stereo|joint]
+ *              [-n frames] [-t period] [-s seed] <out.mp3>
+ *
+ * There is no encoder in the tree, so the corpus is made from random spectra
+ * (energy falling with frequency, band limited by the bitrate) Huffman coded with
+ * libmad's own tables, sized to fill each frame. The streams go through the same
+ * decode paths as encoder output: every pair table including linbits, both count1
+ * tables, MS stereo, and start/short/stop windows every <period> granules (0 = long
+ * blocks only). Scalefactors are zero and main_data_begin is always 0.
+ */
+
+/*
+ * Definitions.
+ */
+#define MKMP3_MAX_FRAME_BYTES   1441u       /* 320 kbps at 32 kHz, padded. */
+#define MKMP3_MAX_PART23_BITS   4095u
+#define MKMP3_INVALID_COST      100000
+
+typedef struct
+{
+    uint32_t Code;
+    uint8_t  Len;      /* 0xff: no code. */
+} MKMP3_Code_Type;
+
+typedef struct
+{
+    uint8_t  *Buf;
+    uint32_t  Bits;
+} MKMP3_Bits_Type;
+
+typedef struct
+{
+    uint32_t Part23Length;
+    uint32_t BigValues;
+    uint32_t GlobalGain;
+    uint32_t BlockType;
+    uint32_t TableSelect[3];
+    uint32_t Region0Count;
+    uint32_t Region1Count;
+    uint32_t Count1Table;
+    uint8_t  Data[(MKMP3_MAX_PART23_BITS + 7u) / 8u];
+} MKMP3_Channel_Type;
+
+/*
+ * Variables.
+ */
+static MKMP3_Code_Type mkmp3_pair[32][16][16];
+static uint32_t        mkmp3_pair_max[32];
+static MKMP3_Code_Type mkmp3_quad[2][16];
+
+static const uint32_t mkmp3_bitrates[15] =
+{
+    0u, 32u, 40u, 48u, 56u, 64u, 80u, 96u, 112u, 128u, 160u, 192u, 224u, 256u, 320u
+};
+
+/* long block scalefactor band widths, 44.1, 48 and 32 kHz. */
+static const uint8_t mkmp3_sfb_long[3][22] =
+{
+    { 4, 4, 4, 4, 4, 4, 6, 6, 8, 8, 10, 12, 16, 20, 24, 28, 34, 42, 50, 54, 76, 158 },
+    { 4, 4, 4, 4, 4, 4, 6, 6, 6, 8, 10, 12, 16, 18, 22, 28, 34, 40, 46, 54, 54, 192 },
+    { 4, 4, 4, 4, 4, 4, 6, 6, 8, 10, 12, 16, 20, 24, 30, 38, 46, 56, 68, 84, 102, 26 },
+};
+
+static uint32_t mkmp3_seed = 1u;
+
+/*
+ * Functions.
+ */
+static uint32_t mkmp3_rand(void)
+{
+    mkmp3_seed ^= mkmp3_seed << 13;
+    mkmp3_seed ^= mkmp3_seed >> 17;
+    mkmp3_seed ^= mkmp3_seed << 5;
+    return mkmp3_seed;
+}
+
+static double mkmp3_uniform(void)
+{
+    return ((double)(mkmp3_rand() >> 8) + 0.5) / 16777216.0;
+}
+
+static double mkmp3_gauss(void)
+{
+    return sqrt(-2.0 * log(mkmp3_uniform())) * cos(6.283185307179586 * mkmp3_uniform());
+}
+
+static void mkmp3_put(MKMP3_Bits_Type *bits, uint32_t value, uint32_t len)
+{
+    while (len-- > 0u)
+    {
+        uint32_t byte = bits->Bits >> 3;
+        uint32_t mask = 0x80u >> (bits->Bits & 7u);
+
+        if ((value >> len) & 1u)
+        {
+            bits->Buf[byte] |= (uint8_t)mask;
+        }
+        else
+        {
+            bits->Buf[byte] &= (uint8_t)~mask;
+        }
+        bits->Bits++;
+    }
+}
+
+/* recover the code words from libmad's lookup tables, see III_huffdecode(). */
+static void mkmp3_walk_pair(uint32_t tab, union huffpair const *table, uint32_t offset,
+                            uint32_t clump, uint32_t prefix, uint32_t plen)
+{
+    for (uint32_t i = 0u; i < (1u << clump); i++)
+    {
+        union huffpair const *e = &table[offset + i];
+
+        if (e->final)
+        {
+            uint32_t hlen = e->value.hlen;
+            MKMP3_Code_Type *c = &mkmp3_pair[tab][e->value.x][e->value.y];
+
+            if (c->Len == 0xffu)
+            {
+                c->Code = (prefix << hlen) | (i >> (clump - hlen));
+                c->Len  = (uint8_t)(plen + hlen);
+            }
+            if (e->value.x > mkmp3_pair_max[tab])
+            {
+                mkmp3_pair_max[tab] = e->value.x;
+            }
+        }
+        else
+        {
+            mkmp3_walk_pair(tab, table, e->ptr.offset, e->ptr.bits, (prefix << clump) | i, plen + clump);
+        }
+    }
+}
+
+static void mkmp3_walk_quad(uint32_t tab, union huffquad const *table, uint32_t offset,
+                            uint32_t clump, uint32_t prefix, uint32_t plen)
+{
+    for (uint32_t i = 0u; i < (1u << clump); i++)
+    {
+        union huffquad const *e = &table[offset + i];
+
+        if (e->final)
+        {
+            uint32_t hlen = e->value.hlen;
+            uint32_t v = (e->value.v << 3) | (e->value.w << 2) | (e->value.x << 1) | e->value.y;
+            MKMP3_Code_Type *c = &mkmp3_quad[tab][v];
+
+            if (c->Len == 0xffu)
+            {
+                c->Code = (prefix << hlen) | (i >> (clump - hlen));
+                c->Len  = (uint8_t)(plen + hlen);
+            }
+        }
+        else
+        {
+            mkmp3_walk_quad(tab, table, e->ptr.offset, e->ptr.bits, (prefix << clump) | i, plen + clump);
+        }
+    }
+}
+
+static void mkmp3_init_tables(void)
+{
+    memset(mkmp3_pair, 0xff, sizeof(mkmp3_pair));
+    memset(mkmp3_quad, 0xff, sizeof(mkmp3_quad));
+
+    for (uint32_t t = 0u; t < 32u; t++)
+    {
+        if (mad_huff_pair_table[t].table != NULL)
+        {
+            mkmp3_walk_pair(t, mad_huff_pair_table[t].table, 0u, mad_huff_pair_table[t].startbits, 0u, 0u);
+        }
+        if (mad_huff_pair_table[t].linbits != 0u)
+        {
+            mkmp3_pair_max[t] = 15u + (1u << mad_huff_pair_table[t].linbits) - 1u;
+        }
+    }
+    for (uint32_t t = 0u; t < 2u; t++)
+    {
+        mkmp3_walk_quad(t, mad_huff_quad_table[t], 0u, 4u, 0u, 0u);
+    }
+}
+
+static int mkmp3_pair_cost(uint32_t t, int x, int y)
+{
+    uint32_t ax = (uint32_t)abs(x), ay = (uint32_t)abs(y);
+    uint32_t linbits = mad_huff_pair_table[t].linbits;
+    int      cost;
+
+    if ( (mad_huff_pair_table[t].table == NULL) || (ax > mkmp3_pair_max[t]) || (ay > mkmp3_pair_max[t]) )
+    {
+        return MKMP3_INVALID_COST;
+    }
+
+    cost = mkmp3_pair[t][(ax > 15u) ? 15u : ax][(ay > 15u) ? 15u : ay].Len;
+    cost += (ax != 0u) + (ay != 0u);
+    if (linbits != 0u)
+    {
+        cost += (ax >= 15u) ? (int)linbits : 0;
+        cost += (ay >= 15u) ? (int)linbits : 0;
+    }
+    return cost;
+}
+
+static void mkmp3_put_value(MKMP3_Bits_Type *bits, uint32_t linbits, int v)
+{
+    uint32_t a = (uint32_t)abs(v);
+
+    if ( (linbits != 0u) && (a >= 15u) )
+    {
+        mkmp3_put(bits, a - 15u, linbits);
+    }
+    if (a != 0u)
+    {
+        mkmp3_put(bits, (v < 0) ? 1u : 0u, 1u);
+    }
+}
+
+static void mkmp3_put_pair(MKMP3_Bits_Type *bits, uint32_t t, int x, int y)
+{
+    uint32_t ax = (uint32_t)abs(x), ay = (uint32_t)abs(y);
+    MKMP3_Code_Type const *c = &mkmp3_pair[t][(ax > 15u) ? 15u : ax][(ay > 15u) ? 15u : ay];
+
+    mkmp3_put(bits, c->Code, c->Len);
+    mkmp3_put_value(bits, mad_huff_pair_table[t].linbits, x);
+    mkmp3_put_value(bits, mad_huff_pair_table[t].linbits, y);
+}
+
+/* cheapest table for pairs [s, e) given per-table prefix costs. */
+static uint32_t mkmp3_best_table(int pc[32][289], uint32_t s, uint32_t e, int *cost)
+{
+    uint32_t best = 0u;
+    int      best_cost = pc[0][e] - pc[0][s];
+
+    for (uint32_t t = 1u; t < 32u; t++)
+    {
+        int c = pc[t][e] - pc[t][s];
+
+        if (c < best_cost)
+        {
+            best_cost = c;
+            best      = t;
+        }
+    }
+    *cost = best_cost;
+    return best;
+}
+
+/* Huffman code one granule/channel; returns the part2_3 length in bits. */
+static uint32_t mkmp3_encode(MKMP3_Channel_Type *ch, int const ix[576], uint32_t sfreqi)
+{
+    static int pc[32][289];
+    MKMP3_Bits_Type bits = { ch->Data, 0u };
+    uint32_t n, c1end, big, bound[2] = { 0u, 0u }, r;
+    int      cost, c1cost[2];
+
+    /* rzero / count1 / big_values partition. */
+    n = 576u;
+    while ( (n >= 2u) && (ix[n - 1u] == 0) && (ix[n - 2u] == 0) )
+    {
+        n -= 2u;
+    }
+    c1end = n;
+    while ( (n >= 4u) && (abs(ix[n - 1u]) <= 1) && (abs(ix[n - 2u]) <= 1)
+         && (abs(ix[n - 3u]) <= 1) && (abs(ix[n - 4u]) <= 1) )
+    {
+        n -= 4u;
+    }
+    big = n / 2u;
+    ch->BigValues = big;
+
+    for (uint32_t t = 0u; t < 32u; t++)
+    {
+        pc[t][0] = 0;
+        for (uint32_t i = 0u; i < big; i++)
+        {
+            pc[t][i + 1u] = pc[t][i] + mkmp3_pair_cost(t, ix[2u * i], ix[2u * i + 1u]);
+        }
+    }
+
+    if (ch->BlockType == 0u)
+    {
+        uint8_t const *sfb = mkmp3_sfb_long[sfreqi];
+        int best_cost = -1;
+
+        for (uint32_t r0 = 0u; r0 < 16u; r0++)
+        {
+            for (uint32_t r1 = 0u; (r1 < 8u) && (r0 + r1 + 2u < 22u); r1++)
+            {
+                uint32_t b0 = 0u, b1, ts[3];
+                int      c0, c1, c2;
+
+                for (uint32_t i = 0u; i <= r0; i++)
+                {
+                    b0 += sfb[i];
+                }
+                b1 = b0;
+                for (uint32_t i = r0 + 1u; i <= r0 + r1 + 1u; i++)
+                {
+                    b1 += sfb[i];
+                }
+                b0 = (b0 / 2u < big) ? (b0 / 2u) : big;
+                b1 = (b1 / 2u < big) ? (b1 / 2u) : big;
+
+                ts[0] = mkmp3_best_table(pc, 0u, b0, &c0);
+                ts[1] = mkmp3_best_table(pc, b0, b1, &c1);
+                ts[2] = mkmp3_best_table(pc, b1, big, &c2);
+
+                if ( (best_cost < 0) || (c0 + c1 + c2 < best_cost) )
+                {
+                    best_cost = c0 + c1 + c2;
+                    ch->Region0Count = r0;
+                    ch->Region1Count = r1;
+                    memcpy(ch->TableSelect, ts, sizeof(ts));
+                    bound[0] = b0;
+                    bound[1] = b1;
+                }
+            }
+        }
+    }
+    else
+    {
+        /* window switching: region0 is 8 long or 9 short bands, 36 lines at MPEG-1 rates, region1 the rest. */
+        uint32_t b0 = 18u;
+
+        b0 = (b0 < big) ? b0 : big;
+        ch->TableSelect[0] = mkmp3_best_table(pc, 0u, b0, &cost);
+        ch->TableSelect[1] = mkmp3_best_table(pc, b0, big, &cost);
+        ch->TableSelect[2] = 0u;
+        bound[0] = b0;
+        bound[1] = big;
+    }
+
+    for (uint32_t i = 0u; i < big; i++)
+    {
+        r = (i < bound[0]) ? 0u : ((i < bound[1]) ? 1u : 2u);
+        mkmp3_put_pair(&bits, ch->TableSelect[r], ix[2u * i], ix[2u * i + 1u]);
+    }
+
+    /* count1 with the cheaper quad table. */
+    for (uint32_t t = 0u; t < 2u; t++)
+    {
+        c1cost[t] = 0;
+        for (uint32_t i = 2u * big; i < c1end; i += 4u)
+        {
+            uint32_t v = ((ix[i] != 0) << 3) | ((ix[i + 1u] != 0) << 2) | ((ix[i + 2u] != 0) << 1) | (ix[i + 3u] != 0);
+
+            c1cost[t] += mkmp3_quad[t][v].Len;
+        }
+    }
+    ch->Count1Table = (c1cost[1] < c1cost[0]) ? 1u : 0u;
+
+    for (uint32_t i = 2u * big; i < c1end; i += 4u)
+    {
+        uint32_t v = ((ix[i] != 0) << 3) | ((ix[i + 1u] != 0) << 2) | ((ix[i + 2u] != 0) << 1) | (ix[i + 3u] != 0);
+        MKMP3_Code_Type const *c = &mkmp3_quad[ch->Count1Table][v];
+
+        mkmp3_put(&bits, c->Code, c->Len);
+        for (uint32_t k = 0u; k < 4u; k++)
+        {
+            if (ix[i + k] != 0)
+            {
+                mkmp3_put(&bits, (ix[i + k] < 0) ? 1u : 0u, 1u);
+            }
+        }
+    }
+
+    ch->Part23Length = bits.Bits;
+    return bits.Bits;
+}
+
+static void mkmp3_spectrum(int ix[576], double level, uint32_t cutoff)
+{
+    for (uint32_t i = 0u; i < 576u; i++)
+    {
+        double a = 0.0;
+
+        if (i < cutoff)
+        {
+            a = level * exp(-3.0 * (double)i / (double)cutoff) * fabs(mkmp3_gauss());
+        }
+        ix[i] = (int)(a + 0.5);
+        if ( (ix[i] != 0) && (mkmp3_rand() & 0x100u) )
+        {
+            ix[i] = -ix[i];
+        }
+    }
+}
+
+static int usage(void)
+{
+    fprintf(stderr, "usage: mm32_mkmp3 [-r rate] [-b kbps | -v min:max] [-m mono|stereo|joint]\n"
+                    "                  [-n frames] [-t period] [-s seed] <out.mp3>\n");
+    return 2;
+}
+
+static uint32_t mkmp3_bitrate_index(uint32_t kbps)
+{
+    for (uint32_t i = 1u; i < 15u; i++)
+    {
+        if (mkmp3_bitrates[i] == kbps)
+        {
+            return i;
+        }
+    }
+    return 0u;
+}
+
+int main(int argc, char *argv[])
+{
+    static uint8_t            frame[MKMP3_MAX_FRAME_BYTES];
+    static MKMP3_Channel_Type gc[2][2];
+    uint32_t rate = 44100u, kmin = 128u, kmax = 128u, frames = 400u, period = 32u;
+    uint32_t mode = 1u, nch, sfreqi, bidx, bmin, bmax, rem = 0u, granule = 0u;
+    double   level[2] = { 8.0, 8.0 };
+    const char *out = NULL;
+    FILE *f;
+
+    for (int arg = 1; arg < argc; arg++)
+    {
+        if ( (argv[arg][0] == '-') && (arg + 1 < argc) )
+        {
+            const char *v = argv[++arg];
+
+            switch (argv[arg - 1][1])
+            {
+            case 'r': rate   = (uint32_t)strtoul(v, NULL, 0); break;
+            case 'b': kmin   = kmax = (uint32_t)strtoul(v, NULL, 0); break;
+            case 'v': sscanf(v, "%u:%u", &kmin, &kmax); break;
+            case 'n': frames = (uint32_t)strtoul(v, NULL, 0); break;
+            case 't': period = (uint32_t)strtoul(v, NULL, 0); break;
+            case 's': mkmp3_seed = (uint32_t)strtoul(v, NULL, 0) | 1u; break;
+            case 'm':
+                mode = (0 == strcmp(v, "mono")) ? 3u : ((0 == strcmp(v, "stereo")) ? 0u : 1u);
+                break;
+            default:
+                return usage();
+            }
+        }
+        else
+        {
+            out = argv[arg];
+        }
+    }
+
+    sfreqi = (rate == 44100u) ? 0u : ((rate == 48000u) ? 1u : ((rate == 32000u) ? 2u : 3u));
+    bmin   = mkmp3_bitrate_index(kmin);
+    bmax   = mkmp3_bitrate_index(kmax);
+    if ( (out == NULL) || (sfreqi > 2u) || (bmin == 0u) || (bmax < bmin) || ( (period != 0u) && (period < 4u) ) )
+    {
+        return usage();
+    }
+
+    f = fopen(out, "wb");
+    if (f == NULL)
+    {
+        fprintf(stderr, "cannot create %s\n", out);
+        return 1;
+    }
+
+    mkmp3_init_tables();
+    nch  = (mode == 3u) ? 1u : 2u;
+    bidx = bmin;
+
+    for (uint32_t fr = 0u; fr < frames; fr++)
+    {
+        MKMP3_Bits_Type bits = { frame, 0u };
+        uint32_t kbps, bytes, pad, si_bytes, budget;
+
+        /* vbr: random walk over the allowed bitrates. */
+        if (bmax > bmin)
+        {
+            uint32_t step = mkmp3_rand() % 3u;
+
+            bidx = (step == 0u) ? ((bidx > bmin) ? (bidx - 1u) : bidx)
+                 : ((step == 1u) ? ((bidx < bmax) ? (bidx + 1u) : bidx) : bidx);
+        }
+        kbps  = mkmp3_bitrates[bidx];
+        bytes = 144000u * kbps / rate;
+        rem  += 144000u * kbps % rate;
+        pad   = (rem >= rate) ? 1u : 0u;
+        rem  -= pad * rate;
+        bytes += pad;
+
+        si_bytes = (nch == 1u) ? 17u : 32u;
+        budget   = (bytes - 4u - si_bytes) * 8u / (2u * nch);
+        if (budget > MKMP3_MAX_PART23_BITS)
+        {
+            budget = MKMP3_MAX_PART23_BITS;
+        }
+
+        for (uint32_t gr = 0u; gr < 2u; gr++, granule++)
+        {
+            uint32_t phase = (period != 0u) ? (granule % period) : 0u;
+            uint32_t block = 0u;
+
+            if (period != 0u)
+            {
+                block = (phase == period - 3u) ? 1u : ((phase == period - 2u) ? 2u : ((phase == period - 1u) ? 3u : 0u));
+            }
+
+            for (uint32_t ch = 0u; ch < nch; ch++)
+            {
+                /* the side channel of ms stereo carries less energy and bandwidth. */
+                double   scale  = ( (mode == 1u) && (ch == 1u) ) ? 0.35 : 1.0;
+                uint32_t cutoff = (uint32_t)(576.0 * (4000.0 + 140.0 * kbps / nch) / (rate / 2.0) * scale);
+                int      ix[576];
+
+                cutoff = (cutoff > 576u) ? 576u : ((cutoff < 32u) ? 32u : cutoff);
+                gc[gr][ch].BlockType  = block;
+                gc[gr][ch].GlobalGain = 156u + (mkmp3_rand() % 8u);
+
+                for (;;)
+                {
+                    mkmp3_spectrum(ix, level[ch] * scale, cutoff);
+                    if (mkmp3_encode(&gc[gr][ch], ix, sfreqi) <= budget)
+                    {
+                        break;
+                    }
+                    level[ch] *= 0.85;
+                }
+                if (gc[gr][ch].Part23Length < budget * 3u / 4u)
+                {
+                    level[ch] *= 1.1;
+                }
+            }
+        }
+
+        /* header: sync, MPEG-1, layer III, no crc; ms stereo for joint mode. */
+        memset(frame, 0, bytes);
+        mkmp3_put(&bits, 0xfffbu, 16u);
+        mkmp3_put(&bits, bidx, 4u);
+        mkmp3_put(&bits, (sfreqi == 0u) ? 0u : ((sfreqi == 1u) ? 1u : 2u), 2u);
+        mkmp3_put(&bits, pad, 1u);
+        mkmp3_put(&bits, 0u, 1u);
+        mkmp3_put(&bits, mode, 2u);
+        mkmp3_put(&bits, (mode == 1u) ? 2u : 0u, 2u);
+        mkmp3_put(&bits, 0x4u, 4u);
+
+        /* side info. */
+        mkmp3_put(&bits, 0u, 9u);
+        mkmp3_put(&bits, 0u, (nch == 1u) ? 5u : 3u);
+        mkmp3_put(&bits, 0u, 4u * nch);
+        for (uint32_t gr = 0u; gr < 2u; gr++)
+        {
+            for (uint32_t ch = 0u; ch < nch; ch++)
+            {
+                MKMP3_Channel_Type const *c = &gc[gr][ch];
+
+                mkmp3_put(&bits, c->Part23Length, 12u);
+                mkmp3_put(&bits, c->BigValues, 9u);
+                mkmp3_put(&bits, c->GlobalGain, 8u);
+                mkmp3_put(&bits, 0u, 4u);
+                if (c->BlockType != 0u)
+                {
+                    mkmp3_put(&bits, 1u, 1u);
+                    mkmp3_put(&bits, c->BlockType, 2u);
+                    mkmp3_put(&bits, 0u, 1u);
+                    mkmp3_put(&bits, c->TableSelect[0], 5u);
+                    mkmp3_put(&bits, c->TableSelect[1], 5u);
+                    mkmp3_put(&bits, 0u, 9u);
+                }
+                else
+                {
+                    mkmp3_put(&bits, 0u, 1u);
+                    mkmp3_put(&bits, c->TableSelect[0], 5u);
+                    mkmp3_put(&bits, c->TableSelect[1], 5u);
+                    mkmp3_put(&bits, c->TableSelect[2], 5u);
+                    mkmp3_put(&bits, c->Region0Count, 4u);
+                    mkmp3_put(&bits, c->Region1Count, 3u);
+                }
+                mkmp3_put(&bits, c->Count1Table, 3u);
+            }
+        }
+
+        /* main data, the rest of the frame is zero ancillary data. */
+        for (uint32_t gr = 0u; gr < 2u; gr++)
+        {
+            for (uint32_t ch = 0u; ch < nch; ch++)
+            {
+                MKMP3_Channel_Type const *c = &gc[gr][ch];
+
+                for (uint32_t i = 0u; i < c->Part23Length; i++)
+                {
+                    mkmp3_put(&bits, (c->Data[i >> 3] >> (7u - (i & 7u))) & 1u, 1u);
+                }
+            }
+        }
+
+        fwrite(frame, 1u, bytes, f);
+    }
+
+    fclose(f);
+    printf("%s: %u frames, %u Hz, %u-%u kbps, %s\n", out, frames, rate, kmin, kmax,
+           (mode == 3u) ? "mono" : ((mode == 0u) ? "stereo" : "joint stereo"));
+    return 0;
+}
+
+/* EOF. */
@@ -0,0 +1,225 @@
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "hal_common.h"
+#include "board_it.h"
+#include "scheduler.h"
+#include "host_hal.h"
+#include "ram_disk.h"
+#include "mp3.h"
+
+#ifdef APP_FREERTOS
+#include "FreeRTOS.h"
+#include "task.h"
+#include "audio_rtos.h"
+#include "i2s_port.h"
+#endif
+
+/*
+ * Host player: mounts a FAT image as drive 0 and runs the application's
+ * Audio_Task() against it, with the I2S DMA stream captured by host_hal.c.
+ *
+ *   mm32_player [-o out.pcm] [-d auto|libmad|helix] [-e off|on|auto] <disk.img> [song index]
+ *
+ * Built with MM32_FREERTOS the player runs as the firmware's APP_FREERTOS tasks
+ * on the kernel's POSIX port instead, until the song has played out.
+ */
+
+/*
+ * Variables.
+ */
+FATFS fs;
+
+extern uint8_t SongNumber;
+extern uint8_t AUDIO_StartPlay;
+extern uint8_t AUDIO_PlayState;
+extern uint8_t AUDIO_PlayIndex;
+
+/*
+ * Functions.
+ */
+static double host_now(void)
+{
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (double)t.tv_sec + (double)t.tv_nsec * 1e-9;
+}
+
+#ifdef APP_FREERTOS
+/* runs of the scheduler's 2 Hz loop, the one that calls Audio_Task(). */
+static uint32_t host_audio_task_runs(void)
+{
+    sched_stats_t stats;
+
+    for (uint8_t i = 0u; Scheduler_GetStats(i, &stats); i++)
+    {
+        if (stats.rate_hz == 2u)
+        {
+            return stats.runs;
+        }
+    }
+    return 0u;
+}
+
+/*
+ * Ends the scheduler once an Audio_Task() that saw the start request has
+ * returned -- an mp3 decodes inside it, a wav or a file that cannot be played
+ * returns at once -- and the song has stopped with the ring played out.
+ */
+static void host_monitor_task(void *param)
+{
+    uint32_t runs;
+
+    (void)param;
+
+    while (AUDIO_StartPlay == 1)
+    {
+        vTaskDelay(1);
+    }
+    runs = host_audio_task_runs();
+    while ( (host_audio_task_runs() == runs) || (AUDIO_PlayState == 1) || I2S_Ring_Busy() )
+    {
+        vTaskDelay(1);
+    }
+    vTaskEndScheduler();
+    vTaskDelete(NULL);
+}
+#endif
+
+static int usage(void)
+{
+    fprintf(stderr, "usage: mm32_player [-o out.pcm] [-d auto|libmad|helix] [-e off|on|auto] <disk.img> [song index]\n");
+    return 2;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *image = NULL;
+    const char *sink  = NULL;
+    int  index = 0;
+    int  arg;
+    FRESULT res;
+    HOST_Audio_Stats_Type audio;
+    RAM_Disk_Stats_Type   disk;
+    double start, elapsed, played;
+
+    for (arg = 1; arg < argc; arg++)
+    {
+        if ( (0 == strcmp(argv[arg], "-o")) && (arg + 1 < argc) )
+        {
+            sink = argv[++arg];
+        }
+        else if ( (0 == strcmp(argv[arg], "-d")) && (arg + 1 < argc) )
+        {
+            arg++;
+            for (MP3_Backend = MP3_Decoder_Auto; MP3_Backend < MP3_Decoder_Num; MP3_Backend++)
+            {
+                if (0 == strcmp(argv[arg], MP3_Decoder_GetName(MP3_Backend)))
+                {
+                    break;
+                }
+            }
+            if (MP3_Backend == MP3_Decoder_Num)
+            {
+                return usage();
+            }
+        }
+        else if ( (0 == strcmp(argv[arg], "-e")) && (arg + 1 < argc) )
+        {
+            static const char *economy[] = { "off", "on", "auto" };
+
+            arg++;
+            for (MP3_Economy = MP3_Economy_Off; MP3_Economy <= MP3_Economy_Auto; MP3_Economy++)
+            {
+                if (0 == strcmp(argv[arg], economy[MP3_Economy]))
+                {
+                    break;
+                }
+            }
+            if (MP3_Economy > MP3_Economy_Auto)
+            {
+                return usage();
+            }
+        }
+        else if (image == NULL)
+        {
+            image = argv[arg];
+        }
+        else
+        {
+            index = atoi(argv[arg]);
+        }
+    }
+    if (image == NULL)
+    {
+        return usage();
+    }
+
+    if (RAM_disk_attach(image) != 0)
+    {
+        fprintf(stderr, "cannot map %s\n", image);
+        return 1;
+    }
+    if ( (sink != NULL) && (HOST_Audio_OpenSink(sink) != 0) )
+    {
+        fprintf(stderr, "cannot create %s\n", sink);
+        return 1;
+    }
+
+    SysTick_Init();
+
+    res = f_mount(&fs, "0:/", 1);
+    if (res != FR_OK)
+    {
+        fprintf(stderr, "f_mount() Fail!,res=%d\n", res);
+        return 1;
+    }
+
+    Scheduler_Setup();
+    AUDIO_Init();
+    if ( (index < 0) || (index >= SongNumber) )
+    {
+        fprintf(stderr, "no song %d in %s\n", index, AUDIO_MUSIC_PATH);
+        return 1;
+    }
+    AUDIO_PlayIndex = (uint8_t)index;
+
+    start = host_now();
+
+#ifdef APP_FREERTOS
+    /* the idle task's WaitForInterrupt() plays the dma blocks. */
+    xTaskCreate(host_monitor_task, "monitor", configMINIMAL_STACK_SIZE, NULL, tskIDLE_PRIORITY, NULL);
+    AUDIO_RTOS_Start();
+#else
+    /* mp3 decodes inside Audio_Task(), wav refills from the events the dma interrupts post. */
+    Audio_Task();
+    while ( (AUDIO_PlayState == 1) && HOST_DMA_Run() )
+    {
+        AUDIO_ProcessEvents();
+    }
+#endif
+
+    elapsed = host_now() - start;
+
+    HOST_Audio_CloseSink();
+    HOST_Audio_GetStats(&audio);
+    RAM_disk_get_stats(&disk);
+
+    played = (audio.SampleRate != 0u) ? ((double)audio.Samples / 2.0 / audio.SampleRate) : 0.0;
+
+    printf("\r\nhost: %llu samples, %u transfers, %u Hz, crc32 %08x\r\n",
+           (unsigned long long)audio.Samples, audio.Transfers, audio.SampleRate, audio.Crc32);
+    printf("host: %.3f s audio in %.3f s (%.1fx realtime)\r\n",
+           played, elapsed, (elapsed > 0.0) ? (played / elapsed) : 0.0);
+    printf("host: disk_read %u calls, %u sectors, %u seeks\r\n",
+           disk.ReadCalls, disk.ReadSectors, disk.ReadSeeks);
+
+    f_unmount("0:/");
+    RAM_disk_detach();
+    return 0;
+}
+
+/* EOF. */
@@ -0,0 +1,145 @@
+#!/usr/bin/env python3
+"""Format the binary trace records of a LOG_TRACE build (application/log.h).
+
+    log_decode.py image.axf trace.bin       # memory dump of LOG_Trace
+    log_decode.py image.axf console.log     # UART capture with LOG_Trace_Dump() lines
+
+A record keeps the address of its printf format and the raw 32-bit arguments;
+both format and %s strings are read back from the image at those addresses.
+Strings that were in RAM on the target print as their address.
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+LOG_TRACE_MAGIC = 0x54474F4C
+LEVELS = {1: 'E', 2: 'W', 3: 'I', 4: 'D'}
+CONVERSION = re.compile(r'%([-+ #0]*)(\*|\d+)?(?:\.(\*|\d+))?(?:hh|h|ll|l|j|z|t)?([diouxXcsp%])')
+
+
+class Image:
+    """Loaded sections of an ELF file (the Keil .axf), addressed as on the target."""
+
+    def __init__(self, path):
+        with open(path, 'rb') as f:
+            data = f.read()
+        if data[:4] != b'\x7fELF':
+            sys.exit('%s: not an ELF file' % path)
+        if data[4] == 1:
+            shoff, = struct.unpack_from('<I', data, 0x20)
+            shentsize, shnum = struct.unpack_from('<HH', data, 0x2E)
+            layout = '<IIIIIIIIII'
+        else:
+            shoff, = struct.unpack_from('<Q', data, 0x28)
+            shentsize, shnum = struct.unpack_from('<HH', data, 0x3A)
+            layout = '<IIQQQQIIQQ'
+        self.sections = []
+        for i in range(shnum):
+            _, kind, flags, addr, offset, size = struct.unpack_from(layout, data, shoff + i * shentsize)[:6]
+            # allocated and with contents in the file, i.e. not .bss.
+            if (flags & 0x2) and kind != 8 and size:
+                self.sections.append((addr, data[offset:offset + size]))
+
+    def string(self, addr):
+        for base, body in self.sections:
+            if base <= addr < base + len(body):
+                end = body.find(b'\0', addr - base)
+                return body[addr - base:end if end >= 0 else len(body)].decode('latin-1')
+        return None
+
+
+def format_record(image, fmt_addr, args, nargs):
+    fmt = image.string(fmt_addr)
+    if fmt is None:
+        return '<format 0x%08x> %s' % (fmt_addr, ' '.join('%08x' % a for a in args[:nargs]))
+    values = iter(args[:nargs])
+
+    def take():
+        return next(values, None)
+
+    def convert(m):
+        flags, width, precision, kind = m.groups()
+        if kind == '%':
+            return '%'
+        if width == '*':
+            width = str(take() or 0)
+        if precision == '*':
+            precision = str(take() or 0)
+        spec = '%' + flags + (width or '') + ('.' + precision if precision else '')
+        value = take()
+        if value is None:
+            return '?'
+        if kind in 'di':
+            return (spec + 'd') % (value - (1 << 32) if value & 0x80000000 else value)
+        if kind == 'u':
+            return (spec + 'd') % value
+        if kind == 'c':
+            return (spec + 'c') % chr(value & 0xFF)
+        if kind == 's':
+            text = image.string(value)
+            return (spec + 's') % (text if text is not None else '<0x%08x>' % value)
+        if kind == 'p':
+            return '0x%08x' % value
+        return (spec + kind) % value
+
+    return CONVERSION.sub(convert, fmt)
+
+
+def load_binary(data):
+    magic, freq, count, num, argmax = struct.unpack_from('<IIIHH', data, 0)
+    if magic != LOG_TRACE_MAGIC:
+        return None
+    size = 16 + 4 * argmax
+    records = []
+    for i in range(num):
+        fields = struct.unpack_from('<IIIBBH%dI' % argmax, data, 16 + i * size)
+        fmt, time, seq, level, nargs = fields[:5]
+        if fmt and seq < count and seq >= count - num:
+            records.append((seq, level, fmt, time, nargs, fields[6:]))
+    return freq, records
+
+
+def load_console(text):
+    freq, records = 0, []
+    for line in text.splitlines():
+        cells = line.split()
+        if cells[:1] == ['#trace']:
+            freq, records = int(cells[1]), []
+        elif cells[:1] == ['#T'] and len(cells) >= 6:
+            records.append((int(cells[1]), int(cells[2]), int(cells[3], 16), int(cells[4], 16),
+                            int(cells[5]), [int(c, 16) for c in cells[6:]]))
+    return freq, records
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('image', help='the .axf the trace was recorded with')
+    parser.add_argument('trace', help='LOG_Trace memory dump or console capture')
+    opts = parser.parse_args()
+
+    image = Image(opts.image)
+    with open(opts.trace, 'rb') as f:
+        data = f.read()
+    loaded = load_binary(data) if len(data) >= 16 else None
+    if loaded is None:
+        loaded = load_console(data.decode('latin-1'))
+    freq, records = loaded
+    if not records:
+        sys.exit('%s: no trace records' % opts.trace)
+
+    # the cycle counter wraps (35 s at 120 MHz), records are unwrapped in order.
+    records.sort()
+    elapsed, last = 0, records[0][3]
+    for seq, level, fmt, time, nargs, args in records:
+        elapsed += (time - last) & 0xFFFFFFFF
+        last = time
+        stamp = '%12.6f' % (elapsed / freq) if freq else '%12u' % elapsed
+        text = format_record(image, fmt, list(args), nargs).rstrip('\r\n').lstrip('\r\n')
+        for line in text.splitlines() or ['']:
+            sys.stdout.write('%8u %s %s %s\n' % (seq, stamp, LEVELS.get(level, '?'), line.rstrip('\r')))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,88 @@
+#!/usr/bin/env python3
+"""Compare two mp3bench tables (mm32_bench output or the board's UART log).
+
+    mp3bench_cmp.py [-t percent] baseline.tsv current.tsv
+
+Prints the change in ticks per frame for every stage and fails when a file's
+crc32 differs (decoder output changed) or its total grew by more than the
+threshold (default 5%). Kernel lines such as "# dct32 ticks_call=.. crc32=.."
+are compared the same way, per call. Only tables with the same tick_hz are
+comparable.
+"""
+
+import argparse
+import sys
+
+
+def load(path):
+    clock, columns, rows, kernels = None, None, {}, {}
+    with open(path, newline='') as f:
+        for line in f:
+            line = line.strip()
+            if line.startswith('# mp3bench'):
+                clock = dict(kv.split('=') for kv in line.split()[2:]).get('tick_hz')
+            elif line.startswith('# ') and '=' in line:
+                fields = line.split()
+                kernels[fields[1]] = dict(kv.split('=') for kv in fields[2:])
+            elif line.startswith('file\t'):
+                columns = line.split('\t')
+            elif columns and '\t' in line:
+                cells = line.split('\t')
+                if len(cells) == len(columns):
+                    row = dict(zip(columns, cells))
+                    # tables from before the "dec" column are libmad only.
+                    rows['%s/%s' % (row['file'], row.get('dec', 'libmad'))] = row
+    if columns is None:
+        sys.exit('%s: no mp3bench table' % path)
+    return clock, columns, rows, kernels
+
+
+def main():
+    ap = argparse.ArgumentParser()
+    ap.add_argument('-t', '--threshold', type=float, default=5.0)
+    ap.add_argument('baseline')
+    ap.add_argument('current')
+    opt = ap.parse_args()
+
+    base_clock, columns, base, base_kernels = load(opt.baseline)
+    cur_clock, _, cur, cur_kernels = load(opt.current)
+    if base_clock != cur_clock:
+        sys.exit('tick_hz differs: %s vs %s' % (base_clock, cur_clock))
+
+    stages = columns[columns.index('errors') + 1:columns.index('total') + 1]
+    print('file\t' + '\t'.join(stages) + '\tresult')
+
+    failed = 0
+    for name, row in cur.items():
+        if name not in base:
+            print('%s\t(new)' % name)
+            continue
+        old = base[name]
+        deltas, result = [], 'ok'
+        for s in stages:
+            a, b = int(old[s]), int(row[s])
+            deltas.append('%+.1f%%' % ((b - a) * 100.0 / a) if a else '-')
+        if old['crc32'] != row['crc32'] or old['frames'] != row['frames']:
+            result = 'OUTPUT CHANGED'
+        elif int(row['total']) > int(old['total']) * (1.0 + opt.threshold / 100.0):
+            result = 'SLOWER'
+        failed += result != 'ok'
+        print('%s\t%s\t%s' % (name, '\t'.join(deltas), result))
+
+    for name, kernel in cur_kernels.items():
+        if name not in base_kernels:
+            continue
+        old, result = base_kernels[name], 'ok'
+        a, b = int(old['ticks_call']), int(kernel['ticks_call'])
+        if old['crc32'] != kernel['crc32']:
+            result = 'OUTPUT CHANGED'
+        elif b > a * (1.0 + opt.threshold / 100.0):
+            result = 'SLOWER'
+        failed += result != 'ok'
+        print('(%s)\t%u -> %u ticks/call, %+.1f%%\t%s' % (name, a, b, (b - a) * 100.0 / a if a else 0.0, result))
+
+    return 1 if failed else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,122 @@
+#!/usr/bin/env python3
+"""Report what the linker put in each memory region of an image.
+
+    placement_report.py image.axf                   # Keil build, after the link
+    placement_report.py image.axf -o placement.txt
+
+The Keil project has it as the After Build user program, off by default as
+it needs python on PATH: tick "Run #1" under Options for Target > User to
+get Objects/project_placement.txt after every link.
+
+Lists every allocated output section with its address, size and, where the
+capacity is known, how full it is; then the symbols of the tightly coupled
+memories, largest first. Works on the Keil .axf (sections named after the
+execution regions of mm32f5277e_flash.scf) and on the host build, where the
+placement attributes leave sections named .RAM_I1, .RAM_D1 and .RAM_D1_RO.
+"""
+
+import argparse
+import struct
+import sys
+
+# execution region capacities as in device/mdk/linker/mm32f5277e_flash.scf.
+LIMITS = {
+    'ER_ROM': 0x40000,
+    'ER_ITCM': 0x4000 - 0x10,
+    'RW_DTCM': 0x8000,
+    'RW_RAM': 0x1C000 - 0x4000 - 0x4000,
+}
+DETAIL = ['ER_ITCM', 'RW_DTCM', '.RAM_I1', '.RAM_D1', '.RAM_D1_RO']
+
+
+class Elf:
+    """Allocated sections and sized symbols of an ELF file."""
+
+    def __init__(self, path):
+        with open(path, 'rb') as f:
+            data = f.read()
+        if data[:4] != b'\x7fELF':
+            sys.exit('%s: not an ELF file' % path)
+        if data[4] == 1:
+            shoff, = struct.unpack_from('<I', data, 0x20)
+            shentsize, shnum, shstrndx = struct.unpack_from('<HHH', data, 0x2E)
+            layout, symbol = '<IIIIIIIIII', '<IIIBBH'
+        else:
+            shoff, = struct.unpack_from('<Q', data, 0x28)
+            shentsize, shnum, shstrndx = struct.unpack_from('<HHH', data, 0x3A)
+            layout, symbol = '<IIQQQQIIQQ', '<IBBHQQ'
+        headers = [struct.unpack_from(layout, data, shoff + i * shentsize) for i in range(shnum)]
+        names = headers[shstrndx]
+
+        def name(table, offset):
+            start = table[4] + offset
+            return data[start:data.index(b'\0', start)].decode('latin-1')
+
+        # name, address and size by section index, .bss included.
+        self.sections = {}
+        for index, (sh_name, _, flags, addr, _, size) in enumerate(h[:6] for h in headers):
+            if (flags & 0x2) and size:
+                self.sections[index] = (name(names, sh_name), addr, size)
+
+        self.symbols = []
+        for kind, offset, size, link, entsize in ((h[1], h[4], h[5], h[6], h[9]) for h in headers):
+            if kind != 2:
+                continue
+            for at in range(offset, offset + size, entsize):
+                fields = struct.unpack_from(symbol, data, at)
+                if data[4] == 1:
+                    st_name, value, st_size, info, _, shndx = fields
+                else:
+                    st_name, info, _, shndx, value, st_size = fields
+                # objects and functions that occupy memory.
+                if (info & 0xF) in (1, 2) and st_size and shndx in self.sections:
+                    self.symbols.append((self.sections[shndx][0], name(headers[link], st_name), value, st_size))
+
+
+def report(elf, out):
+    regions = {}
+    for name, addr, size in elf.sections.values():
+        base, total = regions.get(name, (addr, 0))
+        regions[name] = (min(base, addr), total + size)
+
+    out.write('%-16s %10s %8s %8s %6s\n' % ('region', 'base', 'bytes', 'limit', 'used'))
+    for name, (base, total) in sorted(regions.items(), key=lambda r: r[1][0]):
+        limit = LIMITS.get(name)
+        if limit:
+            out.write('%-16s 0x%08x %8u %8u %5.1f%%\n' % (name, base, total, limit, 100.0 * total / limit))
+        else:
+            out.write('%-16s 0x%08x %8u\n' % (name, base, total))
+
+    for region in DETAIL:
+        symbols = sorted((s for s in elf.symbols if s[0] == region), key=lambda s: (-s[3], s[1]))
+        if not symbols:
+            continue
+        out.write('\n%s\n' % region)
+        for _, name, value, size in symbols:
+            out.write('  %-32s 0x%08x %8u\n' % (name, value & ~1, size))
+        out.write('  %-32s %10s %8u\n' % ('(symbols)', '', sum(s[3] for s in symbols)))
+
+    for name, (base, total) in regions.items():
+        if LIMITS.get(name) and total > LIMITS[name]:
+            return 1
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('image', help='linked image, the Keil .axf or a host executable')
+    parser.add_argument('-o', '--output', help='write the report here instead of stdout')
+    opts = parser.parse_args()
+
+    elf = Elf(opts.image)
+    if opts.output:
+        with open(opts.output, 'w') as out:
+            status = report(elf, out)
+    else:
+        status = report(elf, sys.stdout)
+    if status:
+        sys.exit('%s: a region is over its limit' % opts.image)
+
+
+if __name__ == '__main__':
+    main()
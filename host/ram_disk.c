@@ -0,0 +1,172 @@
+/* Includes ------------------------------------------------------------------*/
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "ram_disk.h"
+
+/*
+ * Definitions.
+ */
+#define RAM_DISK_SECTOR_SIZE    FF_MAX_SS
+
+/*
+ * Variables.
+ */
+static int                 ram_disk_fd   = -1;
+static uint8_t            *ram_disk_base = NULL;
+static uint32_t            ram_disk_sectors = 0u;
+static LBA_t               ram_disk_next_sector = 0u;
+static RAM_Disk_Stats_Type ram_disk_stats;
+
+/*
+ * Functions.
+ */
+static int ram_disk_map(int fd)
+{
+    struct stat st;
+
+    if ( (fstat(fd, &st) != 0) || (st.st_size < RAM_DISK_SECTOR_SIZE) )
+    {
+        close(fd);
+        return -1;
+    }
+
+    ram_disk_base = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (ram_disk_base == MAP_FAILED)
+    {
+        ram_disk_base = NULL;
+        close(fd);
+        return -1;
+    }
+
+    ram_disk_fd      = fd;
+    ram_disk_sectors = (uint32_t)(st.st_size / RAM_DISK_SECTOR_SIZE);
+    memset(&ram_disk_stats, 0, sizeof(ram_disk_stats));
+    return 0;
+}
+
+int RAM_disk_attach(const char *path)
+{
+    int fd = open(path, O_RDWR);
+
+    return (fd < 0) ? -1 : ram_disk_map(fd);
+}
+
+int RAM_disk_create(const char *path, uint32_t sectors)
+{
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+
+    if (fd < 0)
+    {
+        return -1;
+    }
+    if (ftruncate(fd, (off_t)sectors * RAM_DISK_SECTOR_SIZE) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+    return ram_disk_map(fd);
+}
+
+void RAM_disk_detach(void)
+{
+    if (ram_disk_base != NULL)
+    {
+        msync(ram_disk_base, (size_t)ram_disk_sectors * RAM_DISK_SECTOR_SIZE, MS_SYNC);
+        munmap(ram_disk_base, (size_t)ram_disk_sectors * RAM_DISK_SECTOR_SIZE);
+        close(ram_disk_fd);
+    }
+    ram_disk_base    = NULL;
+    ram_disk_fd      = -1;
+    ram_disk_sectors = 0u;
+}
+
+void RAM_disk_get_stats(RAM_Disk_Stats_Type *stats)
+{
+    *stats = ram_disk_stats;
+}
+
+DSTATUS RAM_disk_status(void)
+{
+    return (ram_disk_base != NULL) ? 0u : STA_NOINIT;
+}
+
+DSTATUS RAM_disk_initialize(void)
+{
+    return RAM_disk_status();
+}
+
+DRESULT RAM_disk_read(BYTE *buff, LBA_t sector, UINT count)
+{
+    if (ram_disk_base == NULL)
+    {
+        return RES_NOTRDY;
+    }
+    if ( (sector >= ram_disk_sectors) || (count > ram_disk_sectors - sector) )
+    {
+        return RES_PARERR;
+    }
+
+    ram_disk_stats.ReadCalls++;
+    ram_disk_stats.ReadSectors += count;
+    if (sector != ram_disk_next_sector)
+    {
+        ram_disk_stats.ReadSeeks++;
+    }
+    ram_disk_next_sector = sector + count;
+
+    memcpy(buff, ram_disk_base + (size_t)sector * RAM_DISK_SECTOR_SIZE, (size_t)count * RAM_DISK_SECTOR_SIZE);
+    return RES_OK;
+}
+
+DRESULT RAM_disk_write(const BYTE *buff, LBA_t sector, UINT count)
+{
+    if (ram_disk_base == NULL)
+    {
+        return RES_NOTRDY;
+    }
+    if ( (sector >= ram_disk_sectors) || (count > ram_disk_sectors - sector) )
+    {
+        return RES_PARERR;
+    }
+
+    ram_disk_stats.WriteCalls++;
+    ram_disk_stats.WriteSectors += count;
+
+    memcpy(ram_disk_base + (size_t)sector * RAM_DISK_SECTOR_SIZE, buff, (size_t)count * RAM_DISK_SECTOR_SIZE);
+    return RES_OK;
+}
+
+DRESULT RAM_disk_ioctl(BYTE cmd, void *buff)
+{
+    if (ram_disk_base == NULL)
+    {
+        return RES_NOTRDY;
+    }
+
+    switch (cmd)
+    {
+    case CTRL_SYNC:
+        return RES_OK;
+
+    case GET_SECTOR_COUNT:
+        *(LBA_t *)buff = ram_disk_sectors;
+        return RES_OK;
+
+    case GET_SECTOR_SIZE:
+        *(WORD *)buff = RAM_DISK_SECTOR_SIZE;
+        return RES_OK;
+
+    case GET_BLOCK_SIZE:
+        *(DWORD *)buff = 1u;
+        return RES_OK;
+
+    default:
+        return RES_PARERR;
+    }
+}
+
+/* EOF. */
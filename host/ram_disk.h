@@ -0,0 +1,34 @@
+#ifndef __RAM_DISK_H_
+#define __RAM_DISK_H_
+
+#include "ff.h"
+#include "diskio.h"
+
+/*
+ * RAM disk behind FatFs physical drive 0 (DEV_RAM in diskio.c).
+ *
+ * The disk is a raw FAT image file mapped into memory, so FatFs, the players and
+ * the decoders run against realistic data sizes without a card attached.
+ */
+
+typedef struct
+{
+    uint32_t ReadCalls;     /* disk_read() requests. */
+    uint32_t ReadSectors;   /* sectors moved by disk_read(). */
+    uint32_t ReadSeeks;     /* disk_read() requests not contiguous with the previous one. */
+    uint32_t WriteCalls;    /* disk_write() requests. */
+    uint32_t WriteSectors;  /* sectors moved by disk_write(). */
+} RAM_Disk_Stats_Type;
+
+int  RAM_disk_attach(const char *path);                    /* map an existing image. */
+int  RAM_disk_create(const char *path, uint32_t sectors);  /* create, size and map an image. */
+void RAM_disk_detach(void);
+void RAM_disk_get_stats(RAM_Disk_Stats_Type *stats);
+
+DSTATUS RAM_disk_status(void);
+DSTATUS RAM_disk_initialize(void);
+DRESULT RAM_disk_read(BYTE *buff, LBA_t sector, UINT count);
+DRESULT RAM_disk_write(const BYTE *buff, LBA_t sector, UINT count);
+DRESULT RAM_disk_ioctl(BYTE cmd, void *buff);
+
+#endif